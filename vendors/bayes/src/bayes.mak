@@ -18,6 +18,7 @@ THISDIR  = ..\..\bayes\src
 UTILDIR  = ..\..\util\src
 TABLEDIR = ..\..\table\src
 HDRS     = $(UTILDIR)\arrays.h     $(UTILDIR)\scan.h \
+           $(UTILDIR)\refcnt.h \
            $(TABLEDIR)\attset.h    $(TABLEDIR)\table.h
 BCHDRS   = $(HDRS) $(UTILDIR)\tabscan.h $(UTILDIR)\parse.h \
            $(TABLEDIR)\io.h mvnorm.h fbayes.h nbayes.h
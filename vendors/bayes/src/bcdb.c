@@ -247,9 +247,10 @@ int main (int argc, char* argv[])
     if (dwnull) mode = (mode & ~NBC_DWNULL) | dwnull;
     if (maxllh) mode = (mode & ~NBC_MAXLLH) | maxllh;
                                 /* adapt the estimation parameters */
-    if (fbc) fbc_setup(fbc, mode, lcorr);
-    else     nbc_setup(nbc, mode, lcorr);
-  }                             /* set up the classifier anew */
+    k = (fbc) ? fbc_setup(fbc, mode, lcorr)
+              : nbc_setup(nbc, mode, lcorr);
+    if (k != 0) error(E_NOMEM); /* set up the classifier anew */
+  }
 
   /* --- generate database --- */
   if (fn_out && *fn_out)        /* if an output file name is given, */
@@ -14,13 +14,27 @@
             2003.08.16 slight changes in error message output
             2007.02.13 adapted to modified module attset
             2007.10.10 evaluation of attribute directions added
+            2026.10.17 multi-threaded simplification added (option -T)
+            2026.10.17 binary output of naive Bayes classifiers (option -z)
+            2026.10.17 multiple table files, sharded multi-threaded reading
+            2026.10.17 quantized binary output (option -q)
+            2026.10.17 feature hashing of tokens (options -H, -k, -g)
+            2026.10.17 heavy hitter token tracking (options -M, -S, -e)
+            2026.10.17 cross validation by count subtraction (option -x)
+            2026.10.17 multinomial model for count attributes (option -N)
+            2026.10.17 buffered reading of the table body (ts_attach())
+            2026.10.17 table parts independent of the number of threads
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <time.h>
+#include <limits.h>
 #include <assert.h>
+#ifdef NBC_THREADS
+#include <pthread.h>
+#endif
 #ifndef AS_RDWR
 #define AS_RDWR
 #endif
@@ -48,7 +62,7 @@
 ----------------------------------------------------------------------*/
 #define PRGNAME     "bci"
 #define DESCRIPTION "naive and full Bayes classifier induction"
-#define VERSION     "version 2.10 (2008.10.30)        " \
+#define VERSION     "version 2.18 (2026.10.17)        " \
                     "(c) 1998-2008   Christian Borgelt"
 
 /* --- error codes --- */
@@ -68,10 +82,56 @@
 #define E_CLASS    (-12)        /* missing class attribute */
 #define E_MULTCLS  (-13)        /* multiple class attributes */
 #define E_CTYPE    (-14)        /* class attribute is not nominal */
-#define E_UNKNOWN  (-15)        /* unknown error */
+#define E_BINARY   (-15)        /* binary output of full Bayes class. */
+#define E_QUANT    (-16)        /* unknown quantization mode */
+#define E_HASH     (-17)        /* token hashing/tracking not poss. */
+#define E_XVAL     (-18)        /* cross validation not possible */
+#define E_MULTI    (-19)        /* multinomial model not possible */
+#define E_TOKNAME  (-20)        /* token name clashes with a slot */
+#define E_UNKNOWN  (-21)        /* unknown error */
+
+#define PARTSIZE    1048576     /* size of a table part */
 
 #define SEC_SINCE(t)  ((clock()-(t)) /(double)CLOCKS_PER_SEC)
 
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- part of a table file --- */
+  const char *fname;            /* name of the table file */
+  long   beg, end;              /* range of record start positions */
+  int    skip;                  /* whether to skip to a record start */
+  int    pre;                   /* whether first record is read */
+  int    flags;                 /* table file read flags */
+  ATTSET *attset;               /* private attribute set (clone) */
+  NBC    *nbc;                  /* naive Bayes classifier shard */
+  FBC    *fbc;                  /* full  Bayes classifier shard */
+  int    tplcnt;                /* number of tuples read */
+  double tplwgt;                /* weight of tuples read */
+  int    err;                   /* error code of reading the part */
+} PART;                         /* (part of a table file) */
+
+typedef struct {                /* --- read job (one per thread) --- */
+  PART   *parts;                /* parts of the table files */
+  int    cnt;                   /* number of parts */
+  int    first;                 /* index of first part to read */
+  int    step;                  /* step between parts to read */
+} RDJOB;                        /* (read job) */
+
+typedef struct {                /* --- cross validation job --- */
+  NBC    *nbc;                  /* classifier induced from all tuples */
+  TABLE  *table;                /* table containing all tuples */
+  int    *tids;                 /* tuple ids. sorted by fold */
+  int    *offs;                 /* start offsets of the folds */
+  int    setup;                 /* classifier setup mode */
+  double lcorr;                 /* Laplace correction */
+  double *xmats;                /* confusion matrices of the folds */
+  int    first;                 /* index of first fold to evaluate */
+  int    step;                  /* step between folds to evaluate */
+  int    cnt;                   /* number of folds */
+  int    err;                   /* error code */
+} XVJOB;                        /* (cross validation job) */
+
 /*----------------------------------------------------------------------
   Constants
 ----------------------------------------------------------------------*/
@@ -91,7 +151,17 @@ static const char *errmsgs[] = {   /* error messages */
   /* E_CLASS   -12 */  "missing class attribute \"%s\" in file %s\n",
   /* E_MULTCLS -13 */  "multiple class attributes\n",
   /* E_CTYPE   -14 */  "class attribute \"%s\" is not nominal\n",
-  /* E_UNKNOWN -15 */  "unknown error\n"
+  /* E_BINARY  -15 */  "binary output is possible "
+                       "only for naive Bayes classifiers\n",
+  /* E_QUANT   -16 */  "unknown quantization mode %c\n",
+  /* E_HASH    -17 */  "feature hashing and token tracking are not "
+                       "possible together or with -F, -w, -s, -q\n",
+  /* E_XVAL    -18 */  "cross validation is possible only for "
+                       "naive Bayes classifiers without -s, -H, -M\n",
+  /* E_MULTI   -19 */  "multinomial model is possible "
+                       "only for naive Bayes classifiers\n",
+  /* E_TOKNAME -20 */  "token name clashes with a token slot name\n",
+  /* E_UNKNOWN -21 */  "unknown error\n"
 };
 
 /*----------------------------------------------------------------------
@@ -105,11 +175,344 @@ static NBC    *nbc     = NULL;  /* naive Bayes classifier */
 static FBC    *fbc     = NULL;  /* full  Bayes classifier */
 static FILE   *in      = NULL;  /* input  file */
 static FILE   *out     = NULL;  /* output file */
+static PART   *parts   = NULL;  /* parts of the table files */
+static char   *fn_tmp  = NULL;  /* temporary output file name */
+static int    partcnt  = 0;     /* number of parts */
 
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
 
+static void _clear (void)
+{                               /* --- delete classifier shards */
+  PART *p;                      /* to traverse the parts */
+
+  for (p = parts +partcnt; --p >= parts; ) {
+    if      (p->nbc)    nbc_delete(p->nbc, 1);
+    else if (p->fbc)    fbc_delete(p->fbc, 1);
+    else if (p->attset) as_delete(p->attset);
+    p->attset = NULL; p->nbc = NULL; p->fbc = NULL;
+  }                             /* delete shards and attribute sets */
+  free(parts); parts = NULL; partcnt = 0;
+}  /* _clear() */
+
+/*--------------------------------------------------------------------*/
+
+static int _split (ATTSET *attset, int clsid, int full,
+                   FILE *in, const char *fname, int flags)
+{                               /* --- split a table file into parts */
+  int  i, cnt;                  /* loop variable, number of parts */
+  long beg, end;                /* range of the table body */
+  PART *p;                      /* to traverse the parts */
+
+  assert(attset && in && fname);/* check the function arguments */
+  beg = ftell(in);              /* get the start of the table body */
+  if ((beg < 0) || (fseek(in, 0, SEEK_END) != 0))
+    return E_FREAD;             /* seek to the end of the file */
+  end = ftell(in);              /* and get the size of the file */
+  if (end < beg) return E_FREAD;
+  cnt = (int)((end -beg) /PARTSIZE);
+  if (cnt < 1) cnt = 1;         /* the parts depend only on the file, */
+  p = (PART*)realloc(parts, (partcnt +cnt) *sizeof(PART));
+  if (!p) return E_NOMEM;       /* resize the part vector */
+  parts = p; p += partcnt;      /* and get the first new part */
+  for (i = 0; i < cnt; i++, p++) {
+    p->fname  = fname;          /* traverse the new parts */
+    p->beg    = beg +(long)i     *PARTSIZE;  /* not on the number */
+    p->end    = beg +(long)(i+1) *PARTSIZE;  /* of threads (value */
+    if (i >= cnt-1) p->end = LONG_MAX;       /* sums are per part) */
+    p->skip   = (i > 0);        /* compute the range of the part */
+    p->pre    = (i <= 0) && (flags & AS_DFLT) && !(flags & AS_ATT);
+    p->flags  = flags;          /* (the first record may be read */
+    p->nbc    = NULL;           /*  together with a default header) */
+    p->fbc    = NULL;
+    p->tplcnt = 0; p->tplwgt = 0; p->err = E_NONE;
+    p->attset = as_clone(attset);
+    partcnt++;                  /* clone the attribute set (with */
+    if (!p->attset) return E_NOMEM;   /* the field map of the file) */
+    if (full) p->fbc = fbc_create(p->attset, clsid);
+    else      p->nbc = nbc_create(p->attset, clsid);
+    if (!p->fbc && !p->nbc)     /* create a classifier shard */
+      return E_NOMEM;           /* for the part of the file */
+  }
+  return 0;                     /* return 'ok' */
+}  /* _split() */
+
+/*--------------------------------------------------------------------*/
+
+static void _read (PART *p)
+{                               /* --- read a part of a table file */
+  int     c, k, r;              /* character read, flags, buffer */
+  FILE    *in;                  /* table file to read */
+  TABSCAN *tsc;                 /* table scanner of the clone */
+
+  assert(p);                    /* check the function argument */
+  in = fopen(p->fname, "rb");   /* open the table file */
+  if (!in) { p->err = E_FOPEN; return; }
+  if (fseek(in, (p->skip) ? p->beg-1 : p->beg, SEEK_SET) != 0) {
+    fclose(in); p->err = E_FREAD; return; }
+  tsc = as_tabscan(p->attset);  /* get the table scanner */
+  if (p->skip) {                /* if inside the table body, */
+    do c = getc(in); while ((c != EOF) && !ts_istype(tsc,TS_RECSEP,c));
+  }                             /* skip to the next record start */
+  ts_attach(tsc, in);           /* (a record belongs to the part */
+  k = AS_INST | (p->flags & ~(AS_ATT|AS_DFLT));  /* it starts in) */
+  r = (p->pre) ? 0 : (ts_tell(tsc, in) < p->end)
+    ? as_read(p->attset, in, k) : 1;
+  while (r == 0) {              /* record read loop */
+    if (((p->fbc) ? fbc_add(p->fbc, NULL) : nbc_add(p->nbc, NULL)) != 0) {
+      r = E_NOMEM; break; }     /* process tuple and count it */
+    p->tplcnt++; p->tplwgt += as_getwgt(p->attset);
+    r = (ts_tell(tsc, in) < p->end) ? as_read(p->attset, in, k) : 1;
+  }                             /* try to read the next record */
+  if (ferror(in) && (r >= 0)) r = E_FREAD;
+  ts_detach(tsc);               /* release the read buffer */
+  fclose(in);                   /* and close the table file */
+  p->err = (r < 0) ? r : E_NONE;/* note an error code */
+}  /* _read() */
+
+/*--------------------------------------------------------------------*/
+
+static void _readjob (RDJOB *job)
+{                               /* --- process a read job */
+  int i;                        /* loop variable */
+
+  assert(job);                  /* check the function argument */
+  for (i = job->first; i < job->cnt; i += job->step)
+    _read(job->parts +i);       /* read the parts assigned to the job */
+}  /* _readjob() */
+
+/*--------------------------------------------------------------------*/
+#ifdef NBC_THREADS
+
+static void* _readthd (void *job)
+{                               /* --- thread function for reading */
+  _readjob((RDJOB*)job);        /* process the read job */
+  return NULL;                  /* and return a dummy result */
+}  /* _readthd() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static int _readall (int thcnt)
+{                               /* --- read all parts of the tables */
+  int       i, k;               /* loop variables */
+  RDJOB     *jobs;              /* read jobs (one per thread) */
+  #ifdef NBC_THREADS
+  pthread_t *thds;              /* worker threads */
+  #endif
+
+  #ifndef NBC_THREADS
+  thcnt = 1;                    /* no threads without thread support */
+  #endif
+  if (thcnt > partcnt) thcnt = partcnt;
+  if (thcnt < 1)       thcnt = 1;
+  jobs = (RDJOB*)malloc(thcnt *sizeof(RDJOB));
+  if (!jobs) return E_NOMEM;    /* allocate the read jobs */
+  for (i = thcnt; --i >= 0; ) { /* initialize the jobs */
+    jobs[i].parts = parts; jobs[i].cnt  = partcnt;
+    jobs[i].first = i;     jobs[i].step = thcnt;
+  }                             /* (parts are assigned round robin) */
+  #ifdef NBC_THREADS
+  thds = (thcnt > 1)            /* create a thread vector */
+       ? (pthread_t*)malloc(thcnt *sizeof(pthread_t)) : NULL;
+  if (thds) {                   /* if worker threads can be used */
+    for (i = 1; i < thcnt; i++) /* start the worker threads */
+      if (pthread_create(thds +i, NULL, _readthd, jobs +i) != 0)
+        break;                  /* (the first job is processed */
+    _readjob(jobs);             /* by the calling thread) */
+    for (k = i; k < thcnt; k++) /* process jobs for which no thread */
+      _readjob(jobs +k);        /* could be created, then wait */
+    while (--i > 0)             /* for the worker threads */
+      pthread_join(thds[i], NULL);
+    free(thds); }               /* delete the thread vector */
+  else
+  #endif
+  for (k = 0; k < thcnt; k++)   /* if no threads are available, */
+    _readjob(jobs +k);          /* process the jobs sequentially */
+  free(jobs);                   /* delete the read jobs */
+  return 0;                     /* return 'ok' */
+}  /* _readall() */
+
+/*--------------------------------------------------------------------*/
+
+static void _xvjob (XVJOB *job)
+{                               /* --- process a cross valid. job */
+  int    f, i, c, k;            /* loop variables, classes */
+  int    clscnt;                /* number of classes */
+  NBC    *nbc;                  /* classifier of a fold */
+  TUPLE  *tpl;                  /* to traverse the tuples of a fold */
+  double *xmat;                 /* confusion matrix of a fold */
+
+  assert(job);                  /* check the function argument */
+  clscnt = nbc_clscnt(job->nbc);/* get the number of classes */
+  for (f = job->first; f < job->cnt; f += job->step) {
+    nbc = nbc_clone(job->nbc, 0);  /* traverse the assigned folds */
+    if (!nbc) { job->err = E_NOMEM; return; }
+    for (i = job->offs[f]; i < job->offs[f+1]; i++)
+      if (nbc_sub(nbc, tab_tpl(job->table, job->tids[i])) != 0) {
+        nbc_delete(nbc, 0); job->err = E_NOMEM; return; }
+    if (nbc_setup(nbc, job->setup|NBC_ALL, job->lcorr) != 0) {
+      nbc_delete(nbc, 0); job->err = E_NOMEM; return; }
+    xmat = job->xmats +(size_t)f *clscnt *clscnt;
+    for (i = job->offs[f]; i < job->offs[f+1]; i++) {
+      tpl = tab_tpl(job->table, job->tids[i]);
+      c   = tpl_colval(tpl, nbc_clsid(nbc))->i;
+      k   = nbc_exec(nbc, tpl, NULL);
+      xmat[c *clscnt +k] += tpl_getwgt(tpl);
+    }                           /* classify the tuples of the fold */
+    nbc_delete(nbc, 0);         /* with the classifier from which */
+  }                             /* their counts have been removed */
+}  /* _xvjob() */               /* and update the confusion matrix */
+
+/*--------------------------------------------------------------------*/
+#ifdef NBC_THREADS
+
+static void* _xvthd (void *job)
+{                               /* --- thread function for cross val. */
+  _xvjob((XVJOB*)job);          /* process the cross validation job */
+  return NULL;                  /* and return a dummy result */
+}  /* _xvthd() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static double* _xval (NBC *nbc, TABLE *table, int cnt,
+                      int setup, double lcorr, int thcnt)
+{                               /* --- cross validate by subtraction */
+  int       i, k, c, n, m;      /* loop variables, buffers */
+  int       clscnt;             /* number of classes */
+  int       *tids, *offs, *fld; /* tuple ids., fold offsets/indices */
+  double    *xmats;             /* confusion matrices of the folds */
+  XVJOB     *jobs;              /* cross validation jobs */
+  #ifdef NBC_THREADS
+  pthread_t *thds;              /* worker threads */
+  #endif
+
+  assert(nbc && table && (cnt > 0));
+  #ifndef NBC_THREADS
+  thcnt = 1;                    /* no threads without thread support */
+  #endif
+  if (thcnt > cnt) thcnt = cnt;
+  if (thcnt < 1)   thcnt = 1;
+  clscnt = nbc_clscnt(nbc);     /* get the number of classes */
+  n      = tab_tplcnt(table);   /* and the number of tuples */
+  xmats  = (double*)calloc((size_t)(cnt+1) *clscnt *clscnt +1,
+                           sizeof(double));
+  tids   = (int*)malloc(((size_t)n+n +cnt+1 +clscnt) *sizeof(int));
+  jobs   = (XVJOB*)malloc(thcnt *sizeof(XVJOB));
+  if (!xmats || !tids || !jobs) {
+    if (xmats) free(xmats);     /* allocate the matrices */
+    if (tids)  free(tids);      /* and the buffers and */
+    if (jobs)  free(jobs);      /* on failure clean up */
+    return NULL;                /* and abort the function */
+  }
+  fld  = tids +n; offs = fld +n;/* organize the memory */
+  for (c = clscnt; --c >= 0; ) offs[cnt+1+c] = 0;
+  for (k = cnt+1; --k >= 0; )   offs[k] = 0;
+  for (m = i = 0; i < n; i++) { /* traverse the tuples */
+    c = tpl_colval(tab_tpl(table, i), nbc_clsid(nbc))->i;
+    if ((c < 0) || (c >= clscnt)) { fld[i] = -1; continue; }
+    fld[i] = k = offs[cnt+1+c]++ % cnt;
+    offs[k+1]++; m++;           /* assign the tuples to the folds */
+  }                             /* round robin per class (stratified) */
+  for (k = 0; k < cnt; k++)     /* and count the tuples per fold */
+    offs[k+1] += offs[k];       /* compute the fold end offsets */
+  for (i = n; --i >= 0; )       /* sort the tuple ids. by fold */
+    if (fld[i] >= 0) tids[--offs[fld[i]+1]] = i;
+  for (k = 0; k < cnt; k++)     /* (this turns the end offsets */
+    offs[k] = offs[k+1];        /*  into start offsets, which */
+  offs[cnt] = m;                /*  are shifted to the fold index) */
+  for (i = thcnt; --i >= 0; ) { /* initialize the jobs */
+    jobs[i].nbc   = nbc;   jobs[i].table = table;
+    jobs[i].tids  = tids;  jobs[i].offs  = offs;
+    jobs[i].setup = setup; jobs[i].lcorr = lcorr;
+    jobs[i].xmats = xmats; jobs[i].err   = 0;
+    jobs[i].first = i;     jobs[i].step  = thcnt;
+    jobs[i].cnt   = cnt;        /* (folds are assigned round robin) */
+  }
+  #ifdef NBC_THREADS
+  thds = (thcnt > 1)            /* create a thread vector */
+       ? (pthread_t*)malloc(thcnt *sizeof(pthread_t)) : NULL;
+  if (thds) {                   /* if worker threads can be used */
+    for (i = 1; i < thcnt; i++) /* start the worker threads */
+      if (pthread_create(thds +i, NULL, _xvthd, jobs +i) != 0)
+        break;                  /* (the first job is processed */
+    _xvjob(jobs);               /* by the calling thread) */
+    for (k = i; k < thcnt; k++) /* process jobs for which no thread */
+      _xvjob(jobs +k);          /* could be created, then wait */
+    while (--i > 0)             /* for the worker threads */
+      pthread_join(thds[i], NULL);
+    free(thds); }               /* delete the thread vector */
+  else
+  #endif
+  for (k = 0; k < thcnt; k++)   /* if no threads are available, */
+    _xvjob(jobs +k);            /* process the jobs sequentially */
+  for (k = thcnt; --k >= 0; )   /* check for an error */
+    if (jobs[k].err) break;
+  free(jobs); free(tids);       /* delete the jobs and buffers */
+  if (k >= 0) { free(xmats); return NULL; }
+  for (k = clscnt *clscnt, i = cnt; --i >= 0; )
+    for (c = k; --c >= 0; )     /* sum the confusion matrices */
+      xmats[(size_t)cnt *k +c] += xmats[(size_t)i *k +c];
+  return xmats;                 /* return the confusion matrices */
+}  /* _xval() */                /* (last matrix: sum over folds) */
+
+/*--------------------------------------------------------------------*/
+
+static void _xmat (FILE *out, const double *xmat, ATT *att)
+{                               /* --- print a confusion matrix */
+  int    x, y, i, n;            /* loop variables, number of classes */
+  int    len, maxlen = 6;       /* (maximal) length of a class name */
+  double sum, err;              /* sums of the row and column errors */
+
+  assert(out && xmat && att);   /* check the function arguments */
+  n = att_valcnt(att);          /* get the number of classes */
+  for (y = n; --y >= 0; ) {     /* determine the maximal length */
+    len = (int)strlen(att_valname(att, y));    /* of a class name */
+    if (len > maxlen) maxlen = len;
+  }
+  fprintf(out, "no | value");   /* print start of header */
+  for (i = maxlen -5; --i >= 0; ) putc(' ', out);
+  fprintf(out, " | ");          /* fill value column */
+  for (x = 0; x < n; x++)       /* print column headers */
+    fprintf(out, "%5d ", x+1);
+  fprintf(out, "| errors\n");   /* print end of header */
+  fprintf(out, "---+-");        /* print start of separating line */
+  for (i = maxlen; --i >= 0; ) putc('-', out);
+  fprintf(out, "-+");           /* fill value column */
+  for (x = n; --x >= 0; ) fprintf(out, "------");
+  fprintf(out, "-+-------\n");  /* print end of separating line */
+  for (y = 0; y < n; y++) {     /* traverse the rows of the matrix */
+    fprintf(out, "%2d | %s", y+1, att_valname(att, y));
+    for (i = maxlen -(int)strlen(att_valname(att, y)); --i >= 0; )
+      putc(' ', out);           /* print row number and class */
+    fprintf(out, " |");         /* and fill the value column */
+    for (err = 0, x = 0; x < n; x++) {
+      fprintf(out, " %5g", xmat[y *n +x]);
+      if (x != y) err += xmat[y *n +x];
+    }                           /* print the matrix row and */
+    fprintf(out, " | %5g\n", err);  /* the errors of the row */
+  }
+  fprintf(out, "---+-");        /* print start of separating line */
+  for (i = maxlen; --i >= 0; ) putc('-', out);
+  fprintf(out, "-+");           /* fill value column */
+  for (x = n; --x >= 0; ) fprintf(out, "------");
+  fprintf(out, "-+-------\n");  /* print end of separating line */
+  fprintf(out, "   | errors");  /* print start of error row */
+  for (i = maxlen -6; --i >= 0; ) putc(' ', out);
+  fprintf(out, " |");           /* fill the value column */
+  for (sum = 0, x = 0; x < n; x++) {
+    for (err = 0, y = 0; y < n; y++)
+      if (y != x) err += xmat[y *n +x];
+    fprintf(out, " %5g", err);  /* print the errors of the columns */
+    sum += err;                 /* and sum them */
+  }
+  fprintf(out, " | %5g\n", sum);/* print the total number of errors */
+}  /* _xmat() */
+
+/*--------------------------------------------------------------------*/
+
 static void error (int code, ...)
 {                               /* --- print error message */
   va_list    args;              /* list of variable arguments */
@@ -126,7 +529,8 @@ static void error (int code, ...)
     va_end(args);               /* end argument evaluation */
   }
   #ifndef NDEBUG
-  if (nbc)    nbc_delete(nbc, 0);
+  if (parts)  _clear();         /* delete the classifier shards */
+  if (nbc)    nbc_delete(nbc, nbc_attset(nbc) != attset);
   if (fbc)    fbc_delete(fbc, 0);
   if (attset) as_delete(attset);
   if (table)  tab_delete(table, 0);  /* clean up memory */
@@ -134,6 +538,7 @@ static void error (int code, ...)
   if (in  && (in  != stdin))  fclose(in);
   if (out && (out != stdout)) fclose(out);
   #endif
+  if (fn_tmp) remove(fn_tmp);   /* remove a partial output file */
   #ifdef STORAGE
   showmem("at end of program"); /* check memory usage */
   #endif
@@ -145,10 +550,14 @@ static void error (int code, ...)
 int main (int argc, char *argv[])
 {                               /* --- main function */
   int     i, k = 0;             /* loop variables, counter, buffer */
+  int     f, n;                 /* table file index, tuple counter */
   char    *s;                   /* to traverse options */
   char    **optarg = NULL;      /* option argument */
+  char    **fns    = argv+1;    /* non-option arguments (file names) */
   char    *fn_hdr  = NULL;      /* name of table header file */
   char    *fn_tab  = NULL;      /* name of table file */
+  char    **fn_tabs;            /* names of table files */
+  int     tabcnt;               /* number of table files */
   char    *fn_dom  = NULL;      /* name of domain file */
   char    *fn_bc   = NULL;      /* name of classifier file */
   char    *blanks  = NULL;      /* blanks */
@@ -161,8 +570,26 @@ int main (int argc, char *argv[])
   int     flags    = AS_NOXATT; /* table file read flags */
   int     balance  = 0;         /* flag for balancing class freqs. */
   int     simp     = 0;         /* flag for classifier simplification */
+  int     thcnt    = 1;         /* number of threads */
   double  lcorr    = 0;         /* Laplace correction value */
   int     maxlen   = 0;         /* maximal output line length */
+  int     binary   = 0;         /* flag for binary output */
+  int     quant    = 0;         /* quantization mode (binary output) */
+  int     bktcnt   = 0;         /* number of hash buckets */
+  unsigned int seed = 0;        /* seed for the hash function */
+  int     hmode    = 0;         /* feature hashing mode */
+  int     slotcnt  = 0;         /* number of token slots (tracking) */
+  int     ctrcnt   = 0;         /* number of heavy hitter counters */
+  double  minfrq   = 2;         /* minimal frequency of a token */
+  int     toks     = 0;         /* flag for hashed/tracked tokens */
+  int     xval     = 0;         /* number of cross validation folds */
+  double  *xmats;               /* confusion matrices of the folds */
+  double  wgt, errs;            /* weight and errors of a fold */
+  SPINST  *insts   = NULL;      /* hashed token instantiations */
+  int     cls;                  /* class of a hashed instantiation */
+  int     tokcnt;               /* number of hashed tokens */
+  int     used, coll, maxld;    /* hash collision statistics */
+  int     drop;                 /* number of dropped frequent tokens */
   int     setup    = 0;         /* setup/induction mode */
   int     desc     = 0;         /* description mode */
   int     attcnt   = 0;         /* number of attributes */
@@ -170,6 +597,8 @@ int main (int argc, char *argv[])
   double  tplwgt   = 0.0;       /* weight of tuples */
   int     clsid;                /* id of class column */
   ATT     *att;                 /* to traverse attributes */
+  TABLE   *tab;                 /* table read from further files */
+  PART    *p;                   /* to traverse the table file parts */
   TSINFO  *err;                 /* error information */
   clock_t t;                    /* timer for measurements */
 
@@ -181,7 +610,8 @@ int main (int argc, char *argv[])
     fprintf(stderr, VERSION); } /* print a startup message */
   else {                        /* if no argument given */
     printf("usage: %s [options] domfile "
-                     "[-d|-h hdrfile] tabfile bcfile\n", argv[0]);
+                     "[-d|-h hdrfile] tabfile [tabfile ...] bcfile\n",
+                     argv[0]);
     printf("%s\n", DESCRIPTION);
     printf("%s\n", VERSION);
     printf("-F       induce a full Bayes classifier "
@@ -191,12 +621,39 @@ int main (int argc, char *argv[])
     printf("         l: lower, b: boost, s: shift weights\n");
     printf("-s#      simplify classifier (naive Bayes only)\n"
            "         a: by adding, r: by removing attributes\n");
+    printf("-T#      number of threads for reading and simplification "
+                    "(default: %d)\n", thcnt);
     printf("-L#      Laplace correction (default: %g)\n", lcorr);
     printf("-t       distribute tuple weight for null values\n");
     printf("-m       use maximum likelihood estimate "
                     "for the variance\n");
+    printf("-N       multinomial model for integer attributes "
+                    "(token counts)\n");
     printf("-p       print relative frequencies (in percent)\n");
     printf("-l#      output line length (default: no limit)\n");
+    printf("-z       write classifier in binary format "
+                    "(naive Bayes only)\n");
+    printf("-q#      quantize log. probabilities "
+                    "(binary format, inference only)\n"
+           "         f: 32 bit floats, s: 16 bit, b: 8 bit fixed-point\n");
+    printf("-H#      hash token attributes into # buckets "
+                    "(default: no hashing)\n");
+    printf("-k#      seed for the token hash function "
+                    "(default: %u)\n", seed);
+    printf("-g       signed feature hashing "
+                    "(default: unsigned; lossy, since\n"
+           "         colliding tokens may cancel; use only "
+                    "with few collisions)\n");
+    printf("-M#      track tokens, keep at most # frequent ones "
+                    "(default: all)\n");
+    printf("-S#      number of heavy hitter counters "
+                    "(default: 4 times -M)\n");
+    printf("-e#      minimal frequency of a kept token "
+                    "(default: %g)\n", minfrq);
+    printf("         (occurrences before a token is kept "
+                    "are not counted)\n");
+    printf("-x#      number of cross validation folds "
+                    "(default: no cross validation)\n");
     printf("-b#      blank   characters    (default: \" \\t\\r\")\n");
     printf("-f#      field   separators    (default: \" \\t\")\n");
     printf("-r#      record  separators    (default: \"\\n\")\n");
@@ -208,7 +665,7 @@ int main (int argc, char *argv[])
                     "(field names = field numbers)\n");
     printf("-h       read table header (field names) from hdrfile\n");
     printf("hdrfile  file containing table header (field names)\n");
-    printf("tabfile  table file to read "
+    printf("tabfile  table file(s) to read "
                     "(field names in first record)\n");
     printf("bcfile   file to write Bayes classifier to\n");
     return 0;                   /* print a usage message */
@@ -225,11 +682,22 @@ int main (int argc, char *argv[])
           case 'c': optarg  = &clsname;              break;
           case 'w': balance = (*s) ? *s++ : 0;       break;
           case 's': simp    = (*s) ? *s++ : 0;       break;
+          case 'T': thcnt   = (int)strtol(s, &s, 0); break;
           case 'L': lcorr   =      strtod(s, &s);    break;
           case 't': setup  |= NBC_DWNULL;            break;
           case 'm': setup  |= NBC_MAXLLH;            break;
+          case 'N': setup  |= NBC_MULTI;             break;
           case 'p': desc   |= NBC_REL;               break;
           case 'l': maxlen  = (int)strtol(s, &s, 0); break;
+          case 'z': binary  = 1;                     break;
+          case 'q': quant   = (*s) ? *s++ : 0;       break;
+          case 'H': bktcnt  = (int)strtol(s, &s, 0); break;
+          case 'k': seed    = (unsigned int)strtoul(s, &s, 0); break;
+          case 'g': hmode  |= NBC_HSIGN;             break;
+          case 'M': slotcnt = (int)strtol(s, &s, 0); break;
+          case 'S': ctrcnt  = (int)strtol(s, &s, 0); break;
+          case 'e': minfrq  =      strtod(s, &s);    break;
+          case 'x': xval    = (int)strtol(s, &s, 0); break;
           case 'b': optarg  = &blanks;               break;
           case 'f': optarg  = &fldseps;              break;
           case 'r': optarg  = &recseps;              break;
@@ -243,21 +711,20 @@ int main (int argc, char *argv[])
         if (!*s) break;         /* if at end of string, abort loop */
         if (optarg) { *optarg = s; optarg = NULL; break; }
       } }                       /* get option argument */
-    else {                      /* -- if argument is no option */
-      switch (k++) {            /* evaluate non-option */
-        case  0: fn_dom = s;      break;
-        case  1: fn_tab = s;      break;
-        case  2: fn_bc  = s;      break;
-        default: error(E_ARGCNT); break;
-      }                         /* note filenames */
-    }
-  }
+    else                        /* -- if argument is no option */
+      fns[k++] = s;             /* note the file name (the processed */
+  }                             /* arguments are overwritten) */
   if (optarg) error(E_OPTARG);  /* check the option argument */
-  if (k != 3) error(E_ARGCNT);  /* and the number of arguments */
+  if (k < 3)  error(E_ARGCNT);  /* and the number of arguments */
+  fn_dom  = fns[0];             /* get the domain file, */
+  fn_tabs = fns+1;              /* the table files, */
+  tabcnt  = k-2;                /* and the classifier file */
+  fn_bc   = fns[k-1];
   if (fn_hdr && (strcmp(fn_hdr, "-") == 0))
     fn_hdr = "";                /* convert "-" to "" */
   i = (!fn_dom || !*fn_dom) ? 1 : 0;
-  if  (!fn_tab || !*fn_tab) i++;
+  for (f = 0; f < tabcnt; f++)  /* traverse the table files */
+    if (!*fn_tabs[f]) i++;      /* and count uses of stdin */
   if  ( fn_hdr && !*fn_hdr) i++;/* check assignments of stdin: */
   if (i > 1) error(E_STDIN);    /* stdin must not be used twice */
   if      (simp == 'a') setup |= NBC_ADD;
@@ -267,6 +734,26 @@ int main (int argc, char *argv[])
   if ((balance !=  0)  && (balance != 'l')
   &&  (balance != 'b') && (balance != 's'))
     error(E_BALANCE, balance);  /* check balancing mode */
+  if      (quant == 'f') quant = NBC_F32;
+  else if (quant == 's') quant = NBC_Q16;
+  else if (quant == 'b') quant = NBC_Q8;
+  else if (quant !=  0 )        /* check the quantization mode */
+    error(E_QUANT, quant);      /* (quantized tables are written */
+  if (quant) binary = 1;        /*  only in binary format) */
+  if (full && binary)           /* binary output is possible */
+    error(E_BINARY);            /* only for naive Bayes classifiers */
+  if (full && (setup & NBC_MULTI))
+    error(E_MULTI);             /* as is a multinomial model */
+  toks = (bktcnt > 0) || (slotcnt > 0);
+  if (toks                      /* hashing or tracking is possible */
+  &&  (full || balance || simp || quant     /* only for plain naive */
+  ||   ((bktcnt > 0) && (slotcnt > 0))))    /* Bayes classifiers */
+    error(E_HASH);              /* (tokens are read sequentially) */
+  if (ctrcnt <= 0) ctrcnt = 4*slotcnt;
+  if ((xval > 0) && (full || simp || toks))
+    error(E_XVAL);              /* check cross validation */
+  if (toks)                     /* token columns unknown to the */
+    flags &= ~AS_NOXATT;        /* domain file become attributes */
   if (fn_hdr)                   /* set the header file flag */
     flags = AS_ATT | (flags & ~AS_DFLT);
 
@@ -314,24 +801,54 @@ int main (int argc, char *argv[])
   att_setdir(att, DIR_OUT);     /* set the class attribute direction */
   if (att_type(att) != AT_NOM)  /* check the type of the class */
     error(E_CTYPE, att_name(att));        /* (must be nominal) */
+  if (setup & NBC_MULTI) {      /* if multinomial model for counts */
+    for (i = attcnt; --i >= 0; ) {
+      att = as_att(attset, i);  /* traverse the nominal attributes */
+      if ((i == clsid) || (att_type(att) != AT_NOM)
+      ||  (att_valcnt(att) <= 0)) continue;
+      for (k = att_valcnt(att); --k >= 0; ) {
+        s = (char*)att_valname(att, k);
+        if ((s[0] == '0') && (s[1] == '\0')) continue;
+        if ((*s < '1') || (*s > '9')
+        ||  (strtol(s, &s, 10) <= 0) || *s) break;
+      }                         /* check for non-negative decimal */
+                                /* integers without leading zeros */
+      if (k < 0) att_conv(att, AT_INT, NULL);
+    }                           /* convert count attributes, so that */
+  }                             /* no value vectors are needed */
   sc_delete(scan); scan = NULL; /* delete the scanner */
   fprintf(stderr, "\n");        /* terminate the startup message */
 
   /* --- read table header --- */
   as_chars(attset, recseps, fldseps, blanks, nullchs, comment);
+  fn_tab = fn_tabs[0];          /* get the first table file */
   in = io_hdr(attset, fn_hdr, fn_tab, flags, 1);
   if (!in) error(1);            /* read the table header */
 
   /* --- build naive Bayes classifier --- */
   if (!full                     /* if to induce a naive Bayes class. */
   &&  (balance                  /* and to balance class frequencies */
-  ||   simp)) {                 /* or to simplify the classifier */
+  ||   simp                     /* or to simplify the classifier */
+  ||   (xval > 0))) {           /* or to cross validate it */
     table = io_bodyin(attset, in, fn_tab, flags, "table", 2);
     if (!table) error(1);       /* read the table body */
+    for (f = 1; f < tabcnt; f++) {
+      fn_tab = fn_tabs[f];      /* traverse the other table files */
+      in  = io_hdr(attset, fn_hdr, fn_tab, flags, 1);
+      if (!in)  error(1);       /* read the table header */
+      tab = io_bodyin(attset, in, fn_tab, flags, "table", 2);
+      in  = NULL;               /* read the table body */
+      if (!tab) error(1);       /* and append its tuples */
+      k = tab_tplcopy(table, tab, 0);
+      tab_delete(tab, 0);       /* delete the read table */
+      if (k != 0) error(E_NOMEM);
+    }
     t = clock();                /* start the timer */
-    fprintf(stderr, "reducing%s table ... ",
-                    (balance) ? " and balancing" : "");
-    tab_reduce(table);          /* reduce table for speed up */
+    fprintf(stderr, "%s%s table ... ", (xval > 0) ? "preparing"
+                    : "reducing", (balance) ? " and balancing" : "");
+    if (xval <= 0)              /* reduce table for speed up */
+      tab_reduce(table);        /* (not for cross validation, as */
+                                /*  equal tuples may form a fold) */
     if (balance) {              /* if the balance flag is set */
       tab_balance(table, clsid, (balance == 'l') ? -2.0F
                               : (balance == 'b') ? -1.0F : 0.0F, NULL);
@@ -341,66 +858,190 @@ int main (int argc, char *argv[])
     fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t));
     t = clock();                /* start the timer */
     fprintf(stderr, "building classifier ... ");
-    nbc = nbc_induce(table, clsid, setup, lcorr);
+    nbc = nbc_induce(table, clsid, setup, lcorr, thcnt);
     if (!nbc) error(E_NOMEM);   /* induce a classifier and */
     attcnt = nbc_mark(nbc);     /* mark the selected attributes */
-    fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t)); }
+    fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t));
+    if (xval > 0) {             /* if to cross validate */
+      t = clock();              /* start the timer */
+      fprintf(stderr, "cross validating classifier ... ");
+      xmats = _xval(nbc, table, xval, setup, lcorr, thcnt);
+      if (!xmats) error(E_NOMEM);
+      fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t));
+      k = nbc_clscnt(nbc);      /* print the errors of the folds */
+      for (f = 0; f <= xval; f++) {
+        for (wgt = errs = 0, i = k*k; --i >= 0; ) {
+          wgt += xmats[(size_t)f*k*k +i];
+          if (i /k != i %k) errs += xmats[(size_t)f*k*k +i];
+        }                       /* sum tuple weights and errors */
+        if (f < xval) fprintf(stderr, "fold %d:", f+1);
+        else          fprintf(stderr, "total:");
+        fprintf(stderr, " %g/%g error(s) (%.2f%%)\n", errs, wgt,
+                (wgt > 0) ? 100*(errs/wgt) : 0);
+      }                         /* print the (total) error rate */
+      _xmat(stderr, xmats +(size_t)xval*k*k,
+            as_att(attset, clsid));
+      free(xmats);              /* print the confusion matrix */
+    } }                         /* (sum over all folds) */
   else {                        /* if to build a normal classifier */
-    if (full) fbc = fbc_create(attset, clsid);
-    else      nbc = nbc_create(attset, clsid);
+    if      (full)   fbc = fbc_create(attset, clsid);
+    else if (bktcnt) nbc = nbc_hcreate(attset, clsid, bktcnt,
+                                       seed, hmode);
+    else if (slotcnt) nbc = nbc_tcreate(attset, clsid, slotcnt,
+                                        ctrcnt, minfrq);
+    else             nbc = nbc_create(attset, clsid);
     if (!fbc && !nbc)           /* create either a full or */
       error(E_NOMEM);           /* a naive Bayes classifier */
     t = clock();                /* start the timer */
-    k = AS_INST | (flags & ~(AS_ATT|AS_DFLT));
-    i = ((flags & AS_DFLT) && !(flags & AS_ATT))
-      ? 0 : as_read(attset, in, k);
-    while (i == 0) {            /* record read loop */
-      if (((fbc) ? fbc_add(fbc, NULL) : nbc_add(nbc, NULL)) != 0)
-        error(E_NOMEM);         /* process tuple and count it */
-      tplcnt++; tplwgt += as_getwgt(attset);
-      i = as_read(attset, in, k);
-    }                           /* try to read the next record */
-    if (i < 0) {                /* if an error occurred, */
-      err = as_err(attset);     /* get the error information */
-      tplcnt += (flags & (AS_ATT|AS_DFLT)) ? 1 : 2;
-      io_error(i, fn_tab, tplcnt, err->s, err->fld, err->exp);
-      error(1);                 /* print an error message */
-    }                           /* and abort the program */
-    if (in != stdin) fclose(in);/* close the input file */
-    in = NULL;                  /* and set up the classifier */
-    if (fbc) { fbc_setup(fbc, setup, lcorr); attcnt = fbc_mark(fbc); }
-    else     { nbc_setup(nbc, setup|NBC_ALL, lcorr); }
+    for (i = 0, f = tabcnt; --f >= 0; )
+      if (!*fn_tabs[f]) i = 1;  /* check for reading from stdin */
+    if (toks) i = 1;            /* tokens are mapped sequentially */
+    if (!i) {                   /* if to read the files in parts */
+      for (f = 0; f < tabcnt; f++) {
+        if (f > 0) {            /* traverse the table files */
+          fn_tab = fn_tabs[f];  /* read the table header */
+          in = io_hdr(attset, fn_hdr, fn_tab, flags, 1);
+          if (!in) error(1);    /* (set the field map) */
+        }                       /* and split the table body */
+        n = partcnt;            /* note the current number of parts */
+        k = _split(attset, clsid, full, in, fn_tab, flags);
+        fclose(in); in = NULL;  /* close the table file */
+        if (k == E_FREAD) error(E_FREAD, fn_tab);
+        if (k != 0)       error(E_NOMEM);
+        fprintf(stderr, "[%d part(s)]", partcnt -n);
+        if (f < tabcnt-1) fprintf(stderr, "\n");
+      }                         /* print the number of parts */
+      fputc(' ', stderr);       /* and read them with threads */
+      if (_readall(thcnt) != 0) error(E_NOMEM);
+      for (n = i = 0; i < partcnt; i++) {
+        p = parts +i;           /* traverse the parts in file order */
+        if (!p->skip) n = 0;    /* (deterministic reduction order) */
+        if      (p->err == E_FOPEN) error(E_FOPEN, p->fname);
+        else if (p->err <  0) { /* if an error occurred, */
+          err = as_err(p->attset);    /* get the error information */
+          n  += p->tplcnt +((flags & (AS_ATT|AS_DFLT)) ? 1 : 2);
+          io_error(p->err, p->fname, n, err->s, err->fld, err->exp);
+          error(1);             /* print an error message */
+        }                       /* and abort the program */
+        n += p->tplcnt; tplcnt += p->tplcnt; tplwgt += p->tplwgt;
+        k = (fbc) ? fbc_merge(fbc, p->fbc) : nbc_merge(nbc, p->nbc);
+        if (k != 0) error(E_NOMEM); /* merge the shard */
+        if (p->nbc) { nbc_delete(p->nbc, 1); p->nbc = NULL; }
+        if (p->fbc) { fbc_delete(p->fbc, 1); p->fbc = NULL; }
+        p->attset = NULL;       /* delete the classifier shard */
+      }                         /* and its attribute set */
+      _clear(); }               /* delete the part vector */
+    else {                      /* if to read sequentially */
+      for (f = 0; f < tabcnt; f++) {
+        if (f > 0) {            /* traverse the table files */
+          fn_tab = fn_tabs[f];  /* and read the table header */
+          in = io_hdr(attset, fn_hdr, fn_tab, flags, 1);
+          if (!in) error(1);    /* (the header of the first file */
+        }                       /*  has already been read) */
+        if (toks) {             /* if to map token attributes, */
+          free(insts);          /* (re)create the instantiation */
+          insts = (SPINST*)malloc((size_t)as_attcnt(attset)
+                                 *sizeof(SPINST));
+          if (!insts) error(E_NOMEM);
+        }                       /* (the header may add tokens) */
+        k = AS_INST | (flags & ~(AS_ATT|AS_DFLT));
+        ts_attach(as_tabscan(attset), in);
+        i = ((flags & AS_DFLT) && !(flags & AS_ATT))
+          ? 0 : as_read(attset, in, k);  /* read the body buffered */
+        for (n = 0; i == 0; ) { /* record read loop */
+          if (toks) {           /* if to map token attributes */
+            tokcnt = nbc_hinst(nbc, attset, clsid, insts, &cls);
+            if (tokcnt < -1) error(E_TOKNAME);
+            if ((tokcnt < 0)    /* map the tokens and add them */
+            ||  (nbc_addsp(nbc, cls, as_getwgt(attset), insts, tokcnt)))
+              error(E_NOMEM); } /* map the tokens to buckets */
+          else if (((fbc) ? fbc_add(fbc,NULL) : nbc_add(nbc,NULL)) != 0)
+            error(E_NOMEM);     /* process tuple and count it */
+          n++; tplwgt += as_getwgt(attset);
+          i = as_read(attset, in, k);
+        }                       /* try to read the next record */
+        if (i < 0) {            /* if an error occurred, */
+          err = as_err(attset); /* get the error information */
+          n += (flags & (AS_ATT|AS_DFLT)) ? 1 : 2;
+          io_error(i, fn_tab, n, err->s, err->fld, err->exp);
+          error(1);             /* print an error message */
+        }                       /* and abort the program */
+        ts_detach(as_tabscan(attset));   /* release the read buffer */
+        if (in != stdin) fclose(in);  /* close the input file */
+        in = NULL; tplcnt += n; /* and sum the number of tuples */
+        if (f < tabcnt-1)       /* print the tuples of the file */
+          fprintf(stderr, "[%d tuple(s)] done.\n", n);
+      }                         /* (the total is printed below) */
+    }                           /* set up the classifier */
+    if (fbc) {                  /* if full Bayes classifier */
+      if (fbc_setup(fbc, setup, lcorr) != 0) error(E_NOMEM);
+      attcnt = fbc_mark(fbc); }
+    else if (slotcnt) {         /* if tokens have been tracked */
+      k = nbc_tstats(nbc, &used, &drop);
+      attcnt = nbc_tdone(nbc)+1;/* mark the materialized tokens */
+      if (nbc_setup(nbc, setup|NBC_MARKED, lcorr) != 0)
+        error(E_NOMEM); }
+    else if (nbc_setup(nbc, setup|NBC_ALL, lcorr) != 0)
+      error(E_NOMEM);
     fprintf(stderr, "[%d/%g tuple(s)] ", tplcnt, tplwgt);
+    if (slotcnt)                /* print the tracking statistics */
+      fprintf(stderr, "[%d token(s), %d/%d kept, %d dropped] ",
+                      k, used, slotcnt, drop);
+    if (bktcnt) {               /* if tokens have been hashed */
+      k = nbc_hstats(nbc, &used, &coll, &maxld);
+      if (k < 0) error(E_NOMEM);/* print the collision statistics */
+      fprintf(stderr, "[%d token(s) in %d/%d bucket(s), "
+                      "%d colliding, max. %d per bucket] ",
+                      k, used, bktcnt, coll, maxld);
+      attcnt = bktcnt +1;       /* the buckets replace the tokens */
+    }                           /* as the classifier's attributes */
     fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t));
   }                             /* print a success message */
 
   /* --- describe created classifier --- */
   t = clock();                  /* start the timer */
-  if (fn_bc && *fn_bc)          /* if an output file name is given, */
-    out = fopen(fn_bc, "w");    /* open output file for writing */
+  if (fn_bc && *fn_bc) {        /* if an output file name is given, */
+    fn_tmp = (char*)malloc(strlen(fn_bc) +5);
+    if (!fn_tmp) error(E_NOMEM);/* write to a temporary file */
+    strcat(strcpy(fn_tmp, fn_bc), ".tmp");    /* that replaces */
+    out = fopen(fn_tmp, (binary) ? "wb" : "w"); }   /* the output */
+                                /* file only when it is complete */
   else {                        /* if no output file name is given, */
     out = stdout; fn_bc = "<stdout>"; }     /* write to std. output */
   fprintf(stderr, "writing %s ... ", fn_bc);
   if (!out) error(E_FOPEN, fn_bc);
-  k = (full || simp)            /* print only the class and */
-    ? AS_MARKED : 0;            /* the marked attributes */
-  if (as_desc(attset, out, k|AS_TITLE|AS_IVALS, maxlen) != 0)
-    error(E_FWRITE, fn_bc);     /* describe attribute domains */
-  fputc('\n', out);             /* leave one line empty */
-  k = (simp) ? NBC_MARKED : 0;  /* print only marked attributes */
-  if (((fbc) ? fbc_desc(fbc,  out, desc  |FBC_TITLE, maxlen)
-  :            nbc_desc(nbc,  out, desc|k|NBC_TITLE, maxlen)) != 0)
-    error(E_FWRITE, fn_bc);     /* describe Bayes classifier */
-  if (maxlen <= 0) maxlen = 72; /* determine maximal line length */
-  fputs("\n/*", out);           /* append additional information */
-  for (k = maxlen -2; --k >= 0; ) fputc('-', out);
-  fprintf(out, "\n  number of attributes: %d",   attcnt);
-  fprintf(out, "\n  number of tuples    : %g\n", tplwgt);
-  for (k = maxlen -2; --k >= 0; ) fputc('-', out);
-  fputs("*/\n", out);           /* terminate additional information */
+  if (binary) {                 /* if to write a binary file */
+    k = (simp || slotcnt)       /* (domains and classifier */
+      ? NBC_MARKED : 0;         /*  in one memory image) */
+    if (nbc_save(nbc, out, k|quant) != 0)
+      error(E_FWRITE, fn_bc); }
+  else {                        /* if to write a description */
+    k = (full || simp || slotcnt)    /* print only the class */
+      ? AS_MARKED : 0;          /* and the marked attributes */
+    if (as_desc(nbc ? nbc_attset(nbc) : attset, out,
+                k|AS_TITLE|AS_IVALS, maxlen) != 0)
+      error(E_FWRITE, fn_bc);   /* describe attribute domains */
+    fputc('\n', out);           /* leave one line empty */
+    k = (simp || slotcnt)       /* print only marked attributes */
+      ? NBC_MARKED : 0;
+    if (((fbc) ? fbc_desc(fbc,  out, desc  |FBC_TITLE, maxlen)
+    :            nbc_desc(nbc,  out, desc|k|NBC_TITLE, maxlen)) != 0)
+      error(E_FWRITE, fn_bc);   /* describe Bayes classifier */
+    if (maxlen <= 0) maxlen = 72;    /* determine max. line length */
+    fputs("\n/*", out);         /* append additional information */
+    for (k = maxlen -2; --k >= 0; ) fputc('-', out);
+    fprintf(out, "\n  number of attributes: %d",   attcnt);
+    fprintf(out, "\n  number of tuples    : %g\n", tplwgt);
+    for (k = maxlen -2; --k >= 0; ) fputc('-', out);
+    fputs("*/\n", out);         /* terminate additional information */
+  }
   if (out != stdout) {          /* if not written to stdout, */
     k = fclose(out); out = NULL;/* close the output file */
     if (k) error(E_FWRITE, fn_bc);
+    if ((rename(fn_tmp, fn_bc) != 0)  /* replace the output file */
+    &&  ((remove(fn_bc) != 0) || (rename(fn_tmp, fn_bc) != 0)))
+      error(E_FWRITE, fn_bc);   /* (a reader, e.g. bcx -R, sees */
+    free(fn_tmp); fn_tmp = NULL;/*  either the old or the new file) */
   }                             /* print a success message */
   fprintf(stderr, "[%d+1 attribute(s)] ", attcnt-1);
   fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t));
@@ -410,7 +1051,9 @@ int main (int argc, char *argv[])
   if (table) tab_delete(table, 0);  /* delete table, */
   if (nbc)   nbc_delete(nbc, 1);    /* naive Bayes classifier, */
   if (fbc)   fbc_delete(fbc, 1);    /* full Bayes classifier, */
-  #endif                            /* and underlying attribute set */
+  if (toks)  as_delete(attset);     /* and underlying attribute set */
+  if (insts) free(insts);           /* (the token attributes are not */
+  #endif                            /*  part of a hashed classifier) */
   #ifdef STORAGE
   showmem("at end of program"); /* check memory usage */
   #endif
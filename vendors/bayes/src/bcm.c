@@ -0,0 +1,370 @@
+/*----------------------------------------------------------------------
+  File    : bcm.c
+  Contents: merge naive or full Bayes classifiers
+  Author  : agent
+  History : 2026.10.17 file created from files bci.c and bcx.c
+            2026.10.17 merging of classifiers with hashed tokens
+            2026.10.17 attributes missing in the first classifier added
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#ifndef SC_SCAN
+#define SC_SCAN
+#endif
+#include "scan.h"
+#ifndef AS_RDWR
+#define AS_RDWR
+#endif
+#ifndef AS_PARSE
+#define AS_PARSE
+#endif
+#include "attset.h"
+#ifndef NBC_INDUCE
+#define NBC_INDUCE
+#endif
+#ifndef NBC_PARSE
+#define NBC_PARSE
+#endif
+#include "nbayes.h"
+#ifndef FBC_INDUCE
+#define FBC_INDUCE
+#endif
+#ifndef FBC_PARSE
+#define FBC_PARSE
+#endif
+#include "fbayes.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define PRGNAME     "bcm"
+#define DESCRIPTION "merge naive or full Bayes classifiers"
+#define VERSION     "version 1.1 (2026.10.17)"
+
+/* --- error codes --- */
+#define OK            0         /* no error */
+#define E_NONE        0         /* no error */
+#define E_NOMEM     (-1)        /* not enough memory */
+#define E_FOPEN     (-2)        /* cannot open file */
+#define E_FREAD     (-3)        /* read error on file */
+#define E_FWRITE    (-4)        /* write error on file */
+#define E_OPTION    (-5)        /* unknown option */
+#define E_OPTARG    (-6)        /* missing option argument */
+#define E_ARGCNT    (-7)        /* wrong number of arguments */
+#define E_STDIN     (-8)        /* double assignment of stdin */
+#define E_PARSE     (-9)        /* parse error */
+#define E_NEGLC    (-10)        /* negative Laplace correction */
+#define E_BINARY   (-11)        /* invalid binary classifier file */
+#define E_TYPE     (-12)        /* different classifier types */
+#define E_MERGE    (-13)        /* incompatible classifiers */
+#define E_BINOUT   (-14)        /* binary output of full Bayes class. */
+#define E_UNKNOWN  (-15)        /* unknown error */
+
+#define SEC_SINCE(t)  ((clock()-(t)) /(double)CLOCKS_PER_SEC)
+
+/*----------------------------------------------------------------------
+  Constants
+----------------------------------------------------------------------*/
+static const char *errmsgs[] = {   /* error messages */
+  /* E_NONE      0 */  "no error\n",
+  /* E_NOMEM    -1 */  "not enough memory\n",
+  /* E_FOPEN    -2 */  "cannot open file %s\n",
+  /* E_FREAD    -3 */  "read error on file %s\n",
+  /* E_FWRITE   -4 */  "write error on file %s\n",
+  /* E_OPTION   -5 */  "unknown option -%c\n",
+  /* E_OPTARG   -6 */  "missing option argument\n",
+  /* E_ARGCNT   -7 */  "wrong number of arguments\n",
+  /* E_STDIN    -8 */  "double assignment of standard input\n",
+  /* E_PARSE    -9 */  "parse error(s) on file %s\n",
+  /* E_NEGLC   -10 */  "Laplace correction must not be negative\n",
+  /* E_BINARY  -11 */  "invalid binary classifier file %s\n",
+  /* E_TYPE    -12 */  "classifier in file %s is of a different type\n",
+  /* E_MERGE   -13 */  "classifier in file %s is incompatible "
+                       "(attributes or types differ)\n",
+  /* E_BINOUT  -14 */  "binary output is possible "
+                       "only for naive Bayes classifiers\n",
+  /* E_UNKNOWN -15 */  "unknown error\n"
+};
+
+/*----------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------*/
+const  char   *prgname = NULL;  /* program name for error messages */
+static SCAN   *scan    = NULL;  /* scanner */
+static NBC    *nbc     = NULL;  /* merged naive Bayes classifier */
+static FBC    *fbc     = NULL;  /* merged full  Bayes classifier */
+static NBC    *nsrc    = NULL;  /* naive Bayes classifier to merge */
+static FBC    *fsrc    = NULL;  /* full  Bayes classifier to merge */
+static ATTSET *attset  = NULL;  /* attribute set */
+static FILE   *out     = NULL;  /* output file */
+static char   *fn_tmp  = NULL;  /* temporary output file name */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+
+static void error (int code, ...)
+{                               /* --- print error message */
+  va_list    args;              /* list of variable arguments */
+  const char *msg;              /* error message */
+
+  assert(prgname);              /* check the program name */
+  if (code < E_UNKNOWN) code = E_UNKNOWN;
+  if (code < 0) {               /* if to report an error, */
+    msg = errmsgs[-code];       /* get error message */
+    if (!msg) msg = errmsgs[-E_UNKNOWN];
+    fprintf(stderr, "\n%s: ", prgname);
+    va_start(args, code);       /* get variable arguments */
+    vfprintf(stderr, msg, args);/* print error message */
+    va_end(args);               /* end argument evaluation */
+  }
+  #ifndef NDEBUG
+  if (nsrc)   nbc_delete(nsrc, 1);
+  if (fsrc)   fbc_delete(fsrc, 1);  /* delete the classifiers */
+  if (nbc)    nbc_delete(nbc, 0);
+  if (fbc)    fbc_delete(fbc, 0);
+  if (attset) as_delete(attset);   /* clean up memory */
+  if (scan)   sc_delete(scan);     /* and close files */
+  if (out && (out != stdout)) fclose(out);
+  #endif
+  if (fn_tmp) remove(fn_tmp);   /* remove a partial output file */
+  #ifdef STORAGE
+  showmem("at end of program"); /* check memory usage */
+  #endif
+  exit(code);                   /* abort programm */
+}  /* error() */
+
+/*--------------------------------------------------------------------*/
+
+static void readbc (char *fn_bc)
+{                               /* --- read a classifier to merge */
+  ATTSET *set;                  /* attribute set of the classifier */
+
+  if (fn_bc && *fn_bc && nbc_isbin(fn_bc)) {
+    fprintf(stderr, "reading %s ... ", fn_bc);
+    nsrc = nbc_load(fn_bc, 0);  /* map a binary classifier file */
+    if (!nsrc) error(E_BINARY, fn_bc);
+    set = nbc_attset(nsrc); }   /* get the attribute set */
+  else {                        /* if to parse a description */
+    scan = sc_create(fn_bc);    /* create a scanner */
+    if (!scan) error((!fn_bc || !*fn_bc) ? E_NOMEM : E_FOPEN, fn_bc);
+    set = as_create("domains", att_delete);
+    if (!set) error(E_NOMEM);   /* create an attribute set */
+    fprintf(stderr, "reading %s ... ", sc_fname(scan));
+    if ((sc_nexter(scan) <  0)  /* start scanning (get first token) */
+    ||  (as_parse(set, scan, AT_ALL) != 0)
+    ||  (as_attcnt(set)  <= 0)) {   /* parse the attribute set */
+      as_delete(set); error(E_PARSE, sc_fname(scan)); }
+    if ((sc_token(scan) == T_ID)/* determine classifier type */
+    &&  (strcmp(sc_value(scan), "fbc") == 0))
+         fsrc = fbc_parse(set, scan);
+    else nsrc = nbc_parse(set, scan);
+    if (!fsrc && !nsrc) {       /* parse the Bayes classifier */
+      as_delete(set); error(E_PARSE, sc_fname(scan)); }
+    if (!sc_eof(scan))          /* check for end of file */
+      error(E_PARSE, sc_fname(scan));
+    sc_delete(scan); scan = NULL;      /* delete the scanner */
+  }
+  fprintf(stderr, "[%d attribute(s)] done.\n", as_attcnt(set));
+}  /* readbc() */
+
+/*--------------------------------------------------------------------*/
+
+static void extend (void)
+{                               /* --- add attributes of a source */
+  int    i, n;                  /* loop variable, attribute counter */
+  ATTSET *set;                  /* attribute set of the source */
+  ATT    *att;                  /* attribute to add */
+  NBC    *tmp;                  /* enlarged merged classifier */
+
+  assert(nbc && nsrc);          /* check the global variables */
+  set = nbc_attset(nsrc);       /* get the source attribute set */
+  for (n = 0, i = as_attcnt(set); --i >= 0; ) {
+    if (as_attid(attset, att_name(as_att(set, i))) >= 0)
+      continue;                 /* skip known attributes */
+    att = att_clone(as_att(set, i));
+    if (!att) error(E_NOMEM);   /* copy a new attribute */
+    if (as_attadd(attset, att) != 0) {
+      att_delete(att); error(E_NOMEM); }
+    n++;                        /* add it to the merged domains */
+  }                             /* and count it */
+  if (n <= 0) return;           /* check for new attributes */
+  tmp = nbc_create(attset, nbc_clsid(nbc));
+  if (!tmp) error(E_NOMEM);     /* the distribution vectors of */
+  tmp->bktcnt = nbc_bktcnt(nbc);  /* a classifier cannot grow, */
+  tmp->seed   = nbc_seed(nbc);    /* so create a new one on the */
+  tmp->hmode  = nbc_hmode(nbc);   /* enlarged attribute set */
+  if (nbc_merge(tmp, nbc) != 0) {
+    nbc_delete(tmp, 0); error(E_NOMEM); }
+  nbc_delete(nbc, 0);           /* move the merged statistics */
+  nbc = tmp;                    /* into the new classifier */
+}  /* extend() */
+
+/*--------------------------------------------------------------------*/
+
+int main (int argc, char *argv[])
+{                               /* --- main function */
+  int     i, k = 0, r;          /* loop variables, buffers */
+  char    *s;                   /* to traverse options */
+  char    **optarg = NULL;      /* option argument */
+  char    **fn_bcs = NULL;      /* names of classifier files */
+  char    *fn_out  = NULL;      /* name of output file */
+  double  lcorr    = -DBL_MAX;  /* Laplace correction value */
+  int     desc     = 0;         /* description mode */
+  int     maxlen   = 0;         /* maximal output line length */
+  int     binary   = 0;         /* flag for binary output */
+  int     attcnt;               /* number of attributes */
+  int     mode     = 0;         /* classifier setup mode */
+  clock_t t;                    /* timer for measurements */
+
+  prgname = argv[0];            /* get program name for error msgs. */
+
+  /* --- print startup/usage message --- */
+  if (argc > 1) {               /* if arguments are given */
+    fprintf(stderr, "%s - %s\n", argv[0], DESCRIPTION);
+    fprintf(stderr, VERSION); } /* print a startup message */
+  else {                        /* if no argument given */
+    printf("usage: %s [options] bcfile [bcfile ...] outfile\n",
+           argv[0]);            /* print a usage message */
+    printf("%s\n", DESCRIPTION);
+    printf("%s\n", VERSION);
+    printf("-L#      Laplace correction "
+                    "(default: as specified in first classifier)\n");
+    printf("-p       print relative frequencies (in percent)\n");
+    printf("-l#      output line length (default: no limit)\n");
+    printf("-z       write classifier in binary format "
+                    "(naive Bayes only)\n");
+    printf("bcfile   file containing classifier description\n");
+    printf("         (or binary classifier file written by bci -z)\n");
+    printf("         (descriptions contain rounded parameters of "
+                    "numeric attributes,\n"
+           "          so their merge is exact only up to "
+                    "this rounding)\n");
+    printf("outfile  file to write merged classifier to\n");
+    return 0;                   /* print a usage message */
+  }                             /* and abort the program */
+
+  /* --- evaluate arguments --- */
+  fn_bcs = (char**)malloc(argc *sizeof(char*));
+  if (!fn_bcs) error(E_NOMEM);  /* create a file name vector */
+  for (i = 1; i < argc; i++) {  /* traverse arguments */
+    s = argv[i];                /* get option argument */
+    if (optarg) { *optarg = s; optarg = NULL; continue; }
+    if ((*s == '-') && *++s) {  /* -- if argument is an option */
+      while (*s) {              /* traverse options */
+        switch (*s++) {         /* evaluate option */
+          case 'L': lcorr   =      strtod(s, &s);    break;
+          case 'p': desc   |= NBC_REL;               break;
+          case 'l': maxlen  = (int)strtol(s, &s, 0); break;
+          case 'z': binary  = 1;                     break;
+          default : error(E_OPTION, *--s);           break;
+        }                       /* set option variables */
+        if (!*s) break;         /* if at end of string, abort loop */
+        if (optarg) { *optarg = s; optarg = NULL; break; }
+      } }                       /* get option argument */
+    else fn_bcs[k++] = s;       /* if argument is no option, */
+  }                             /* note the file name */
+  if (optarg) error(E_OPTARG);  /* check the option argument */
+  if (k < 2) error(E_ARGCNT);   /* and the number of arguments */
+  fn_out = fn_bcs[--k];         /* get the output file name */
+  for (r = 0, i = k; --i >= 0; )/* check assignments of stdin: */
+    if (!*fn_bcs[i]) r++;       /* stdin must not be used twice */
+  if (r > 1) error(E_STDIN);
+  if ((lcorr < 0) && (lcorr > -DBL_MAX))
+    error(E_NEGLC);             /* check the Laplace correction */
+  fprintf(stderr, "\n");        /* terminate the startup message */
+
+  /* --- merge Bayes classifiers --- */
+  t = clock();                  /* start the timer */
+  for (i = 0; i < k; i++) {     /* traverse the classifier files */
+    readbc(fn_bcs[i]);          /* read the next classifier */
+    if (i <= 0) {               /* if this is the first classifier, */
+      attset = as_clone((fsrc) ? fbc_attset(fsrc) : nbc_attset(nsrc));
+      if (!attset) error(E_NOMEM);  /* clone its attribute set */
+      if (fsrc) fbc = fbc_create(attset, fbc_clsid(fsrc));
+      else      nbc = nbc_create(attset, nbc_clsid(nsrc));
+      if (!fbc && !nbc) error(E_NOMEM);
+      if (nbc) {                /* copy the hashing parameters */
+        nbc->bktcnt = nbc_bktcnt(nsrc);  /* (the attribute set */
+        nbc->seed   = nbc_seed(nsrc);    /*  already contains */
+        nbc->hmode  = nbc_hmode(nsrc);   /*  the hash buckets) */
+      }
+      if (lcorr < 0)            /* create the merged classifier */
+        lcorr = (fsrc) ? fbc_lcorr(fsrc) : nbc_lcorr(nsrc);
+      mode = (fsrc) ? fbc_mode(fsrc) : nbc_mode(nsrc);
+    }                           /* get the estimation parameters */
+    if ((fsrc && !fbc) || (nsrc && !nbc))
+      error(E_TYPE, fn_bcs[i]); /* check the classifier type */
+    if (nsrc) extend();         /* add new attributes (vocabulary) */
+    r = (fbc) ? fbc_merge(fbc, fsrc) : nbc_merge(nbc, nsrc);
+    if (r == -2) error(E_MERGE, fn_bcs[i]);
+    if (r != 0)  error(E_NOMEM);/* merge the classifiers */
+    if (fsrc) { fbc_delete(fsrc, 1); fsrc = NULL; }
+    if (nsrc) { nbc_delete(nsrc, 1); nsrc = NULL; }
+  }                             /* delete the merged classifier */
+  r = (fbc) ? fbc_setup(fbc, mode, lcorr) : nbc_setup(nbc, mode, lcorr);
+  if (r != 0) error(E_NOMEM);   /* set up the merged classifier */
+  attcnt = (fbc) ? fbc_mark(fbc) : nbc_mark(nbc);
+  fprintf(stderr, "merging %d classifier(s) done [%.2fs].\n",
+          i, SEC_SINCE(t));     /* and mark the used attributes */
+
+  /* --- describe merged classifier --- */
+  t = clock();                  /* start the timer */
+  if (binary && fbc) error(E_BINOUT);
+  if (*fn_out) {                /* if an output file name is given, */
+    fn_tmp = (char*)malloc(strlen(fn_out) +5);
+    if (!fn_tmp) error(E_NOMEM);/* write to a temporary file */
+    strcat(strcpy(fn_tmp, fn_out), ".tmp");   /* that replaces */
+    out = fopen(fn_tmp, (binary) ? "wb" : "w"); }   /* the output */
+  else {                        /* file only when it is complete; */
+    out = stdout; fn_out = "<stdout>"; }    /* or write to stdout */
+  fprintf(stderr, "writing %s ... ", fn_out);
+  if (!out) error(E_FOPEN, fn_out);
+  if (binary) {                 /* if to write a binary file */
+    if (nbc_save(nbc, out, NBC_MARKED) != 0)
+      error(E_FWRITE, fn_out); }
+  else {                        /* if to write a description */
+    if (as_desc(attset, out, AS_MARKED|AS_TITLE|AS_IVALS, maxlen) != 0)
+      error(E_FWRITE, fn_out);  /* describe attribute domains */
+    fputc('\n', out);           /* leave one line empty */
+    if (((fbc) ? fbc_desc(fbc, out, desc|FBC_TITLE, maxlen)
+    :            nbc_desc(nbc, out, desc|NBC_MARKED|NBC_TITLE, maxlen))
+        != 0) error(E_FWRITE, fn_out);
+    if (maxlen <= 0) maxlen = 72;    /* determine max. line length */
+    fputs("\n/*", out);         /* append additional information */
+    for (k = maxlen -2; --k >= 0; ) fputc('-', out);
+    fprintf(out, "\n  number of attributes: %d",   attcnt);
+    fprintf(out, "\n  number of tuples    : %g\n",
+            (fbc) ? fbc_total(fbc) : nbc_total(nbc));
+    for (k = maxlen -2; --k >= 0; ) fputc('-', out);
+    fputs("*/\n", out);         /* terminate additional information */
+  }
+  if (out != stdout) {          /* if not written to stdout, */
+    k = fclose(out); out = NULL;/* close the output file */
+    if (k) error(E_FWRITE, fn_out);
+    if ((rename(fn_tmp, fn_out) != 0) /* replace the output file */
+    &&  ((remove(fn_out) != 0) || (rename(fn_tmp, fn_out) != 0)))
+      error(E_FWRITE, fn_out);  /* (a reader, e.g. bcx -R, sees */
+    free(fn_tmp); fn_tmp = NULL;/*  either the old or the new file) */
+  }                             /* print a success message */
+  fprintf(stderr, "[%d+1 attribute(s)] ", attcnt-1);
+  fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t));
+
+  /* --- clean up --- */
+  #ifndef NDEBUG
+  free(fn_bcs);                 /* delete the file name vector, */
+  if (nbc) nbc_delete(nbc, 1);  /* the naive Bayes classifier, */
+  if (fbc) fbc_delete(fbc, 1);  /* the full Bayes classifier, */
+  #endif                        /* and the attribute set */
+  #ifdef STORAGE
+  showmem("at end of program"); /* check memory usage */
+  #endif
+  return 0;                     /* return 'ok' */
+}  /* main() */
@@ -16,12 +16,41 @@
             2005.02.22 classification threshold added (option -t)
             2006.01.17 format specification for confidence added
             2007.02.13 adapted to modified module attset
+            2026.10.17 batch execution of naive Bayes classifiers added
+            2026.10.17 naive Bayes classifier compiled before execution
+            2026.10.17 binary naive Bayes classifier files supported
+            2026.10.17 quantized binary classifier files supported
+            2026.10.17 classifiers with hashed token attributes supported
+            2026.10.17 server mode added (options -S and -U)
+            2026.10.17 hot reload of the classifier added (option -R)
+            2026.10.17 aligned output in one pass (spooled results)
+            2026.10.17 multi-threaded execution on table parts (option -T)
+            2026.10.17 buffered reading of the table body (ts_attach())
 ----------------------------------------------------------------------*/
+#if !defined BCX_NOPOSIX && (defined __unix__ || defined __APPLE__)
+#define BCX_POSIX               /* sockets, signals, file status */
+#ifndef _POSIX_C_SOURCE         /* (declarations of fdopen, socket, */
+#define _POSIX_C_SOURCE 200809L /* sigaction etc. are needed with */
+#endif                          /* -ansi, SA_RESTART needs 2008) */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
 #include <assert.h>
+#ifdef BCX_POSIX
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef NBC_THREADS
+#include <pthread.h>
+#endif
+#endif
 #ifndef SC_SCAN
 #define SC_SCAN
 #endif
@@ -50,7 +79,7 @@
 ----------------------------------------------------------------------*/
 #define PRGNAME     "bcx"
 #define DESCRIPTION "naive and full Bayes classifier execution"
-#define VERSION     "version 2.17 (2008.10.30)        " \
+#define VERSION     "version 2.22 (2026.10.17)        " \
                     "(c) 1998-2008   Christian Borgelt"
 
 /* --- error codes --- */
@@ -67,7 +96,13 @@
 #define E_PARSE     (-9)        /* parse error */
 #define E_CLASS    (-10)        /* missing class */
 #define E_NEGLC    (-11)        /* negative Laplace correction */
-#define E_UNKNOWN  (-12)        /* unknown error */
+#define E_BATCH    (-12)        /* invalid batch size */
+#define E_BINARY   (-13)        /* invalid binary classifier file */
+#define E_QUANT    (-14)        /* re-estimation of quantized class. */
+#define E_SOCKET   (-15)        /* cannot serve on a socket */
+#define E_UNKNOWN  (-16)        /* unknown error */
+
+#define PARTMIN     65536       /* minimal size of a table part */
 
 /*----------------------------------------------------------------------
   Type Definitions
@@ -80,10 +115,88 @@ typedef struct {                /* --- classification result info.--- */
   char   *n_prob;               /* name  of probability column */
   int    w_prob;                /* width of probability column */
   double prob;                  /* probability of result */
+  double *posts;                /* posterior class probabilities */
   char   *format;               /* number output format */
   int    all;                   /* whether to show all probabilities */
 } RESULT;                       /* (classification result info.) */
 
+typedef struct {                /* --- value identifier map --- */
+  int    cnt;                   /* number of mapped values */
+  int    *ids;                  /* value identifiers in classifier */
+} VALMAP;                       /* (value identifier map) */
+
+typedef struct {                /* --- batch of tuples --- */
+  int    size;                  /* maximal number of tuples */
+  TUPLE  **tpls;                /* tuples of the batch */
+  int    *clss;                 /* classes     of the tuples */
+  double *confs;                /* confidences of the tuples */
+  double *posts;                /* posteriors  of the tuples */
+  INST   *cols;                 /* column block (binary classifier) */
+  SPINST *insts;                /* hashed token instantiations */
+  int    clscnt;                /* number of classes */
+  double thresh;                /* classification threshold */
+} BATCH;                        /* (batch of tuples) */
+
+typedef struct {                /* --- loaded classifier --- */
+  ATTSET *attset;               /* attribute set */
+  NBC    *nbc;                  /* naive Bayes classifier */
+  FBC    *fbc;                  /* full  Bayes classifier */
+  VALMAP *vmaps;                /* value maps (binary classifier) */
+} MODEL;                        /* (loaded classifier) */
+
+typedef struct {                /* --- classifier loader --- */
+  CCHAR  *fname;                /* name of classifier file */
+  double lcorr;                 /* Laplace correction (if >= 0) */
+  int    dwnull;                /* distribute weight of null values */
+  int    maxllh;                /* max. likelihood est. of variance */
+  CCHAR  *chars[5];             /* separators, blanks, nulls etc. */
+  int    reload;                /* whether to reload the classifier */
+  int    async;                 /* whether loading in the background */
+  time_t mtime;                 /* modification time of the file */
+  long   size;                  /* size of the file */
+  int    settled;               /* whether the change was loaded */
+  time_t polled;                /* time of last (synchronous) poll */
+  MODEL  *pending;              /* newly loaded classifier */
+  #if defined BCX_POSIX && defined NBC_THREADS
+  pthread_mutex_t mutex;        /* mutex for the pending classifier */
+  #endif
+} LOADER;                       /* (classifier loader) */
+
+typedef struct {                /* --- tuple information --- */
+  float  wgt;                   /* weight of the tuple */
+  int    miss;                  /* whether it was misclassified */
+} TPLINF;                       /* (tuple information) */
+
+typedef struct {                /* --- part of a table file --- */
+  CCHAR  *fname;                /* name of the table file */
+  long   beg, end;              /* range of the part in the file */
+  int    skip;                  /* whether to skip to a record start */
+  int    pre;                   /* whether first record is read */
+  int    flags;                 /* table file read flags */
+  ATTSET *attset;               /* private attribute set (clone) */
+  INST   *insts;                /* instances for the classifier */
+  VALMAP *vmaps;                /* value maps (binary classifier) */
+  NBCWS  *nws;                  /* naive Bayes execution workspace */
+  FBCWS  *fws;                  /* full  Bayes execution workspace */
+  RESULT res;                   /* classification result */
+  double *posts;                /* posterior class probabilities */
+  FILE   *out;                  /* output of the part (tmpfile) */
+  int    tplcnt;                /* number of tuples read */
+  int    infvsz;                /* size of the tuple info. vector */
+  TPLINF *infs;                 /* weights and classification errors */
+  int    err;                   /* error code of processing the part */
+} PART;                         /* (part of a table file) */
+
+typedef struct {                /* --- execution job --- */
+  PART   *parts;                /* parts of the table file */
+  int    cnt;                   /* number of parts */
+  int    first;                 /* index of first part to process */
+  int    step;                  /* step between parts to process */
+  int    mode;                  /* output mode (or -1: spool) */
+  int    clscnt;                /* number of classes */
+  double thresh;                /* classification threshold */
+} EXJOB;                        /* (execution job) */
+
 /*----------------------------------------------------------------------
   Constants
 ----------------------------------------------------------------------*/
@@ -100,28 +213,76 @@ static const char *errmsgs[] = {   /* error messages */
   /* E_PARSE    -9 */  "parse error(s) on file %s\n",
   /* E_CLASS   -10 */  "missing class \"%s\" in file %s\n",
   /* E_NEGLC   -11 */  "Laplace correction must not be negative\n",
-  /* E_UNKNOWN -12 */  "unknown error\n"
+  /* E_BATCH   -12 */  "batch size must be positive\n",
+  /* E_BINARY  -13 */  "invalid binary classifier file %s\n",
+  /* E_QUANT   -14 */  "quantized classifier %s cannot be re-estimated\n",
+  /* E_SOCKET  -15 */  "cannot serve on socket %s\n",
+  /* E_UNKNOWN -16 */  "unknown error\n"
 };
 
 /*----------------------------------------------------------------------
   Global Variables
 ----------------------------------------------------------------------*/
 const  char   *prgname = NULL;  /* program name for error messages */
-static SCAN   *scan    = NULL;  /* scanner */
 static NBC    *nbc     = NULL;  /* naive Bayes classifier */
 static FBC    *fbc     = NULL;  /* full  Bayes classifier */
 static ATTSET *attset  = NULL;  /* attribute set */
 static FILE   *in      = NULL;  /* input  file */
 static FILE   *out     = NULL;  /* output file */
+static FILE   *spl     = NULL;  /* spool file (aligned output) */
+static VALMAP *vmaps   = NULL;  /* value maps (binary classifier) */
+static LOADER ldr;              /* classifier loader */
+static PART   *parts   = NULL;  /* parts of the table file */
+static int    partcnt  = 0;     /* number of parts */
+static volatile sig_atomic_t hup = 0;   /* whether SIGHUP received */
 static RESULT res = {           /* classification result information */
   NULL,                         /* class attribute */
   "bc", 0, 0,                   /* data for classification column */
-  NULL, 0, 0.0, "%.3f", 0 };    /* data for probability    column */
+  NULL, 0, 0.0, NULL,           /* data for probability    column */
+  "%.3f", 0 };                  /* output format, all probs. flag */
 
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
 
+static void vmdelete (VALMAP *vmaps, int n)
+{                               /* --- delete value maps */
+  while (--n >= 0)              /* traverse the value maps */
+    if (vmaps[n].ids) free(vmaps[n].ids);
+  free(vmaps);                  /* delete the identifier vectors */
+}  /* vmdelete() */             /* and the map vector */
+
+/*--------------------------------------------------------------------*/
+
+static void mdelete (MODEL *m)
+{                               /* --- delete a loaded classifier */
+  if (m->vmaps) vmdelete(m->vmaps, nbc_attcnt(m->nbc));
+  if      (m->nbc)    nbc_delete(m->nbc, 1);
+  else if (m->fbc)    fbc_delete(m->fbc, 1);
+  else if (m->attset) as_delete(m->attset);
+}  /* mdelete() */              /* (the classifier owns its domains) */
+
+/*--------------------------------------------------------------------*/
+
+static void pclear (void)
+{                               /* --- delete the table parts */
+  PART *p;                      /* to traverse the parts */
+
+  for (p = parts +partcnt; --p >= parts; ) {
+    if (p->vmaps)  vmdelete(p->vmaps, nbc_attcnt(nbc));
+    if (p->nws)    nbc_wsdelete(p->nws);
+    if (p->fws)    fbc_wsdelete(p->fws);
+    if (p->attset) as_delete(p->attset);
+    if (p->out)    fclose(p->out);
+    if (p->insts)  free(p->insts);
+    if (p->posts)  free(p->posts);
+    if (p->infs)   free(p->infs);
+  }                             /* delete the part data */
+  free(parts); parts = NULL; partcnt = 0;
+}  /* pclear() */               /* delete the part vector */
+
+/*--------------------------------------------------------------------*/
+
 static void error (int code, ...)
 {                               /* --- print error message */
   va_list    args;              /* list of variable arguments */
@@ -138,12 +299,14 @@ static void error (int code, ...)
     va_end(args);               /* end argument evaluation */
   }
   #ifndef NDEBUG
+  if (parts)  pclear();         /* delete the table parts */
+  if (vmaps)  vmdelete(vmaps, nbc_attcnt(nbc));
   if (nbc)    nbc_delete(nbc, 0);
   if (fbc)    fbc_delete(fbc, 0);
   if (attset) as_delete(attset);   /* clean up memory */
-  if (scan)   sc_delete(scan);     /* and close files */
   if (in  && (in  != stdin))  fclose(in);
   if (out && (out != stdout)) fclose(out);
+  if (spl) fclose(spl);
   #endif
   #ifdef STORAGE
   showmem("at end of program"); /* check memory usage */
@@ -153,6 +316,167 @@ static void error (int code, ...)
 
 /*--------------------------------------------------------------------*/
 
+static int load (MODEL *m, LOADER *l)
+{                               /* --- load a classifier */
+  SCAN   *scan;                 /* scanner for a description */
+  int    mode;                  /* classifier setup mode */
+  double lcorr;                 /* Laplace correction */
+
+  m->attset = NULL; m->nbc = NULL; m->fbc = NULL; m->vmaps = NULL;
+  if (l->fname && *l->fname && nbc_isbin(l->fname)) {
+    m->nbc = nbc_load(l->fname, /* map a binary classifier file */
+                      (l->reload) ? NBC_READ : 0);  /* (or read it */
+    if (!m->nbc) return E_BINARY;    /* if it may be rewritten) */
+    m->attset = nbc_attset(m->nbc); }  /* get the attribute set */
+  else {                        /* if to parse a description */
+    scan = sc_create(l->fname); /* create a scanner */
+    if (!scan) return (!l->fname || !*l->fname) ? E_NOMEM : E_FOPEN;
+    m->attset = as_create("domains", att_delete);
+    if (!m->attset) { sc_delete(scan); return E_NOMEM; }
+    if ((sc_nexter(scan)   >= 0)/* start scanning (get first token) */
+    &&  (as_parse(m->attset, scan, AT_ALL) == 0)
+    &&  (as_attcnt(m->attset) > 0)) {  /* parse attribute set */
+      if ((sc_token(scan) == T_ID)     /* and the classifier */
+      &&  (strcmp(sc_value(scan), "fbc") == 0))
+           m->fbc = fbc_parse(m->attset, scan);
+      else m->nbc = nbc_parse(m->attset, scan);
+    }                           /* (determine classifier type) */
+    if ((!m->fbc && !m->nbc)    /* check the classifier */
+    ||   !sc_eof(scan)) {       /* and for end of file */
+      sc_delete(scan); mdelete(m); return E_PARSE; }
+    sc_delete(scan);            /* delete the scanner */
+  }
+  if ((l->lcorr >= 0) || l->dwnull || l->maxllh) {
+    if (m->nbc && nbc_quant(m->nbc)) {  /* a quantized classifier */
+      mdelete(m); return E_QUANT; }     /* has no distributions */
+    lcorr = l->lcorr;           /* get the classifier's parameters */
+    if (lcorr < 0)
+      lcorr = (m->fbc) ? fbc_lcorr(m->fbc) : nbc_lcorr(m->nbc);
+    mode    = (m->fbc) ? fbc_mode(m->fbc)  : nbc_mode(m->nbc);
+    if (l->dwnull) mode = (mode & ~NBC_DWNULL) | l->dwnull;
+    if (l->maxllh) mode = (mode & ~NBC_MAXLLH) | l->maxllh;
+                                /* adapt the estimation parameters */
+    if (((m->fbc) ? fbc_setup(m->fbc, mode, lcorr)
+                  : nbc_setup(m->nbc, mode, lcorr)) != 0) {
+      mdelete(m); return E_NOMEM; }
+  }                             /* set up the classifier anew */
+  if (m->nbc) {                 /* if naive Bayes classifier */
+    if (!nbc_compiled(m->nbc)   /* compile an execution plan */
+    &&  (nbc_compile(m->nbc) != 0)) {   /* for a faster */
+      mdelete(m); return E_NOMEM; }     /* classification */
+    if (nbc_binary(m->nbc) && (nbc_bktcnt(m->nbc) <= 0)) {
+      m->vmaps = (VALMAP*)calloc(nbc_attcnt(m->nbc), sizeof(VALMAP));
+      if (!m->vmaps) { mdelete(m); return E_NOMEM; }
+    }                           /* create value maps */
+  }                             /* (binary files contain a plan) */
+  as_chars(m->attset, l->chars[0], l->chars[1], l->chars[2],
+                      l->chars[3], l->chars[4]);
+  return 0;                     /* set the separators etc. */
+}  /* load() */                 /* and return 'ok' */
+
+/*--------------------------------------------------------------------*/
+#ifdef BCX_POSIX
+
+static void sighup (int sig)
+{ hup = 1; }                    /* --- note a reload request */
+
+/*--------------------------------------------------------------------*/
+
+static int changed (LOADER *l)
+{                               /* --- check for a changed classifier */
+  struct stat st;               /* status of the classifier file */
+
+  if (hup) { hup = 0; return 1; }  /* reload on request (SIGHUP) */
+  if (stat(l->fname, &st) != 0) return 0;
+  if ((st.st_mtime != l->mtime) /* if the file has changed, */
+  ||  ((long)st.st_size != l->size)) {   /* note its status and */
+    l->mtime = st.st_mtime; l->size = (long)st.st_size;
+    l->settled = 0; return 0;   /* wait for the next poll in order */
+  }                             /* not to read a partial file */
+  if (l->settled) return 0;     /* if the change has been loaded, */
+  l->settled = 1; return 1;     /* there is nothing to do, otherwise */
+}  /* changed() */              /* load the (settled) file */
+
+/*--------------------------------------------------------------------*/
+
+static void reload (LOADER *l)
+{                               /* --- reload a changed classifier */
+  int   r;                      /* result of load */
+  MODEL *m, *old;               /* new and pending classifier */
+
+  m = (MODEL*)malloc(sizeof(MODEL));
+  r = (m) ? load(m, l) : E_NOMEM;
+  if (r != 0) {                 /* load the classifier file */
+    if (m) free(m);             /* on failure report the error */
+    fprintf(stderr, "\n%s: ", prgname);      /* and keep */
+    fprintf(stderr, errmsgs[-r], l->fname);  /* the old classifier */
+    return;
+  }
+  #ifdef NBC_THREADS
+  pthread_mutex_lock(&l->mutex);
+  #endif                        /* publish the new classifier */
+  old = l->pending; l->pending = m;
+  #ifdef NBC_THREADS
+  pthread_mutex_unlock(&l->mutex);
+  #endif                        /* (replace a classifier */
+  if (old) { mdelete(old); free(old); }   /* that was not */
+}  /* reload() */                /* installed yet) */
+
+/*--------------------------------------------------------------------*/
+#ifdef NBC_THREADS
+
+static void* _rldthd (void *p)
+{                               /* --- loader thread function */
+  LOADER *l = (LOADER*)p;       /* classifier loader */
+
+  while (1) {                   /* poll the classifier file */
+    sleep(1);                   /* once per second and load it */
+    if (changed(l)) reload(l);  /* in the background if it changed */
+  }                             /* (the thread runs until */
+  return NULL;                  /* the program terminates) */
+}  /* _rldthd() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static MODEL* fetch (LOADER *l)
+{                               /* --- get a newly loaded classifier */
+  MODEL  *m;                    /* new classifier */
+  time_t t;                     /* current time */
+
+  if (!l->reload) return NULL;  /* check whether to reload */
+  if (!l->async) {              /* if not loading in the background, */
+    t = time(NULL);             /* poll at most once per second */
+    if (t != l->polled) { l->polled = t; if (changed(l)) reload(l); }
+  }                             /* (the request waits for the load) */
+  #ifdef NBC_THREADS
+  pthread_mutex_lock(&l->mutex);
+  #endif                        /* take the pending classifier */
+  m = l->pending; l->pending = NULL;
+  #ifdef NBC_THREADS
+  pthread_mutex_unlock(&l->mutex);
+  #endif
+  return m;                     /* return the new classifier */
+}  /* fetch() */
+
+/*--------------------------------------------------------------------*/
+
+static void repend (LOADER *l, MODEL *m)
+{                               /* --- put a classifier back */
+  #ifdef NBC_THREADS
+  pthread_mutex_lock(&l->mutex);
+  #endif                        /* unless a newer one was loaded */
+  if (!l->pending) { l->pending = m; m = NULL; }
+  #ifdef NBC_THREADS
+  pthread_mutex_unlock(&l->mutex);
+  #endif
+  if (m) { mdelete(m); free(m); }
+}  /* repend() */
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
 static void infout (ATTSET *set, FILE *file, int mode, CCHAR *seps)
 {                               /* --- write additional information */
   int    i, k;                  /* loop variables, buffers */
@@ -160,77 +484,758 @@ static void infout (ATTSET *set, FILE *file, int mode, CCHAR *seps)
   char   *prob;                 /* name of probability column */
   double p;                     /* buffer for probability */
   char   buf[32];               /* buffer for output */
+  RESULT *r;                    /* classification result */
 
+  r = (set == attset)           /* get the classification result */
+    ? &res : (RESULT*)as_info(set)->p;   /* (clones of the set */
+                                         /*  carry their own) */
   if (mode & AS_ATT) {          /* if to write header */
-    class = res.n_class;        /* get name of classification column */
-    prob  = res.n_prob;         /* and name of probability column */
+    class = r->n_class;         /* get name of classification column */
+    prob  = r->n_prob;          /* and name of probability column */
     if (mode & AS_ALIGN) {      /* if to align fields */
       if ((mode & AS_WEIGHT) || prob) {
-        i = att_valwd(res.att, 0);
-        k = (int)strlen(class); res.w_class = (i > k) ? i : k;
+        i = att_valwd(r->att, 0);
+        k = (int)strlen(class); r->w_class = (i > k) ? i : k;
       }                         /* compute width of class column */
       if (prob && (mode & AS_WEIGHT)) {
-        k = (int)strlen(prob);  res.w_prob  = (4 > k) ? 4 : k; }
+        k = (int)strlen(prob);  r->w_prob  = (4 > k) ? 4 : k; }
     } }                         /* compute width of prob. column */
   else {                        /* if to write a normal record */
-    class = att_valname(res.att, res.class);
-    if (res.n_prob) sprintf(buf, res.format, res.prob);
+    class = att_valname(r->att, r->class);
+    if (r->n_prob) sprintf(buf, r->format, r->prob);
     prob = buf;                 /* format the probability */
   }                             /* get and format field contents */
   k = fprintf(file, class);     /* write classification result */
-  for (i = res.w_class -k; --i >= 0; )
+  for (i = r->w_class -k; --i >= 0; )
     fputc(seps[0], file);       /* if to align, pad with blanks */
-  if (res.n_prob) {             /* if to write class probability */
+  if (r->n_prob) {              /* if to write class probability */
     fputc(seps[1], file);       /* write field separator */
     fputs(prob, file);          /* and number of errors */
-    for (i = res.w_prob -k; --i >= 0; ) fputc(seps[0], file);
+    for (i = r->w_prob -k; --i >= 0; ) fputc(seps[0], file);
   }                             /* if to align, pad with blanks */
-  if (!res.all) return;         /* if not to show probs., abort */
-  k = att_valcnt(res.att);      /* get the number of values */
+  if (!r->all) return;          /* if not to show probs., abort */
+  k = att_valcnt(r->att);       /* get the number of values */
   if (mode & AS_ATT) {          /* if to write the header */
     for (i = 0; i < k; i++) {   /* traverse the target values */
       fputc(seps[1], file);     /* print a separator */
-      fputs(att_valname(res.att, i), file);
+      fputs(att_valname(r->att, i), file);
     } }                         /* print the value name */
   else {                        /* if to write the activations */
     for (i = 0; i < k; i++) {   /* traverse the values */
       fputc(seps[1], file);     /* print a separator */
-      p = (fbc) ? fbc_post(fbc, i) : nbc_post(nbc, i);
-      fprintf(file, res.format, p);
+      p = r->posts[i];          /* get the posterior probability */
+      fprintf(file, r->format, p);
     }                           /* print the probability */
   }                             /* (extended confidence information) */
 }  /* infout() */
 
 /*--------------------------------------------------------------------*/
 
+static int spool (FILE *file, ATTSET *set, RESULT *r, int clscnt)
+{                               /* --- spool a classified tuple */
+  int   i;                      /* loop variable */
+  float wgt;                    /* tuple weight */
+
+  for (i = 0; i < as_attcnt(set); i++)
+    fwrite(att_inst(as_att(set, i)), sizeof(INST), 1, file);
+  wgt = as_getwgt(set);         /* write the instantiation, */
+  fwrite(&wgt,      sizeof(float),  1, file);   /* the weight, */
+  fwrite(&r->class, sizeof(int),    1, file);   /* the class, */
+  fwrite(&r->prob,  sizeof(double), 1, file);   /* and the conf. */
+  if (r->all) fwrite(r->posts, sizeof(double), clscnt, file);
+  return ferror(file) ? -1 : 0; /* write the posteriors */
+}  /* spool() */                /* and check for an error */
+
+/*--------------------------------------------------------------------*/
+
+static int unspool (FILE *file, FILE *out, ATTSET *set, RESULT *r,
+                    int mode, int clscnt)
+{                               /* --- write spooled tuples aligned */
+  int    i, n;                  /* loop variable, number of posts. */
+  int    err = 0;               /* flag for a truncated record */
+  float  wgt;                   /* tuple weight */
+  double *posts;                /* buffer for the posteriors */
+
+  n = att_valcnt(r->att);       /* the class attribute may have */
+  if (n < clscnt) n = clscnt;   /* more values than the classifier */
+  posts = (double*)calloc((size_t)n+1, sizeof(double));
+  if (!posts) return -1;        /* create a posteriors buffer */
+  rewind(file);                 /* read the spooled tuples */
+  while (fread(att_inst(as_att(set, 0)), sizeof(INST), 1, file)) {
+    for (i = 1; i < as_attcnt(set); i++)
+      if (fread(att_inst(as_att(set, i)), sizeof(INST), 1, file) != 1)
+        break;                  /* read the instantiation */
+    if ((i < as_attcnt(set))    /* and the classification result */
+    ||  (fread(&wgt,      sizeof(float),  1, file) != 1)
+    ||  (fread(&r->class, sizeof(int),    1, file) != 1)
+    ||  (fread(&r->prob,  sizeof(double), 1, file) != 1)
+    ||  (r->all && (fread(posts, sizeof(double), (size_t)clscnt, file)
+                    != (size_t)clscnt))) {
+      err = -1; break; }        /* abort on a truncated record */
+    as_setwgt(set, wgt);        /* restore the instantiation */
+    r->posts = posts;           /* and the classification result */
+    if (as_write(set, out, mode, infout) != 0) break;
+  }                             /* write the tuple (now the column */
+  free(posts);                  /* widths of all tuples are known) */
+  r->posts = NULL;              /* clear the posteriors buffer */
+  return (err || ferror(file) || ferror(out)) ? -1 : 0;
+}  /* unspool() */
+
+/*--------------------------------------------------------------------*/
+
+static int transl (TUPLE **tpls, int n, INST *cols)
+{                               /* --- translate value identifiers */
+  int    i, k, t;               /* loop variables, buffer */
+  ATT    *att;                  /* to traverse the attributes */
+  VALMAP *vm;                   /* to traverse the value maps */
+  int    *ids;                  /* buffer for reallocation */
+  INST   *col;                  /* to traverse the columns */
+
+  for (i = nbc_attcnt(nbc); --i >= 0; ) {
+    att = as_att(attset, i);    /* traverse the attributes */
+    col = cols +(size_t)i *n;   /* and the columns of the block */
+    for (t = n; --t >= 0; )     /* copy the attribute instances */
+      col[t] = *tpl_colval(tpls[t], i);
+    if ((att_type(att) != AT_NOM) || (i == nbc_clsid(nbc)))
+      continue;                 /* only nominal values are mapped */
+    vm = vmaps +i;              /* get the value map */
+    k  = att_valcnt(att);       /* and the number of values */
+    if (k > vm->cnt) {          /* if new values have been read, */
+      ids = (int*)realloc(vm->ids, k *sizeof(int));
+      if (!ids) return -1;      /* enlarge the identifier vector */
+      for (vm->ids = ids; vm->cnt < k; vm->cnt++)
+        ids[vm->cnt] = nbc_valid(nbc, i, att_valname(att, vm->cnt));
+    }                           /* look up the new values */
+    for (t = n; --t >= 0; ) {   /* in the classifier's domain */
+      k = col[t].i;             /* translate the value identifiers */
+      col[t].i = ((k >= 0) && (k < vm->cnt)) ? vm->ids[k] : NV_NOM;
+    }                           /* (values unknown to the classifier */
+  }                             /*  are treated like null values) */
+  return 0;                     /* return 'ok' */
+}  /* transl() */
+
+/*--------------------------------------------------------------------*/
+
+static void marks (void)
+{                               /* --- mark the attributes to read */
+  int attid;                    /* loop variable for attributes */
+
+  for (attid = as_attcnt(attset); --attid >= 0; )
+    att_setmark(as_att(attset, attid), 1);
+  att_setmark(res.att, 0);      /* mark all attribs. except the class */
+  if (nbc && (nbc_bktcnt(nbc) > 0)) {
+    for (attid = as_attcnt(attset); --attid >= 0; )
+      att_setmark(as_att(attset, attid),
+                  (attid < nbc_attcnt(nbc)) ? -1 : 0);
+    att_setmark(res.att, 0);    /* the buckets are not table columns, */
+  }                             /* tokens are added as attributes */
+}  /* marks() */                /* (tokens of earlier clients are */
+                                /*  read if they are present) */
+
+/*--------------------------------------------------------------------*/
+#ifdef BCX_POSIX
+
+static void tokcut (int flags)
+{                               /* --- remove the tokens of a session */
+  int n;                        /* number of classifier attributes */
+
+  if ((flags & AS_ATT)          /* tokens of a header file are kept */
+  ||  !nbc || (nbc_bktcnt(nbc) <= 0))  /* for all sessions, and only */
+    return;                     /* hashed classifiers add tokens */
+  n = nbc_attcnt(nbc);          /* remove the token attributes */
+  as_attcut(NULL, attset, AS_RANGE, n, as_attcnt(attset) -n);
+}  /* tokcut() */               /* (so that the set does not grow */
+                                /*  with the tokens of all clients) */
+#endif
+
+/*--------------------------------------------------------------------*/
+
+static int classify (BATCH *b, int n)
+{                               /* --- classify a batch of tuples */
+  if (b->cols)                  /* if the classifier is binary, */
+    return ((transl(b->tpls, n, b->cols) != 0)   /* translate */
+    ||      (nbc_exec_block(nbc, b->cols, n, b->clss,  /* the values */
+                            b->confs, b->posts) != 0)) ? -1 : 0;
+  if (nbc && !b->insts)         /* and classify the column block */
+    return nbc_exec_batch(nbc, b->tpls, n, b->clss, b->confs, b->posts);
+  return 0;                     /* classify the batch of tuples */
+}  /* classify() */              /* (naive Bayes classifier only) */
+
+/*--------------------------------------------------------------------*/
+
+static void adapt (RESULT *r, int clscnt, double thresh)
+{                               /* --- adapt a two class result */
+  if (clscnt > 2) return;       /* check for a two class problem */
+  if (r->class <= 0) {          /* check and adapt class 0 result */
+    if (r->prob <   thresh) {
+      r->class = 1; r->prob = 1 -r->prob; } }
+  else {                        /* check and adapt class 1 result */
+    if (r->prob < 1-thresh) {
+      r->class = 0; r->prob = 1 -r->prob; }
+  }                             /* (classify as class 0 if prob. */
+}  /* adapt() */                /* of this class is >= threshold) */
+
+/*--------------------------------------------------------------------*/
+
+static int result (BATCH *b, int t)
+{                               /* --- get a classification result */
+  int tokcnt;                   /* number of hashed tokens */
+
+  tpl_toas(b->tpls[t]);         /* restore the instantiation */
+  if (fbc) {                    /* if full Bayes classifier */
+    res.class = fbc_exec(fbc, NULL, &res.prob);
+    res.posts = fbc->posts; }
+  else if (b->insts) {          /* if hashed naive Bayes classifier */
+    if ((tokcnt = nbc_hinst(nbc, attset, -1, b->insts, NULL)) < 0)
+      return -1;                /* map the tokens to buckets */
+    res.class = nbc_execsp(nbc, b->insts, tokcnt, &res.prob);
+    res.posts = nbc->posts; }
+  else {                        /* if naive Bayes classifier */
+    res.class = b->clss[t]; res.prob = b->confs[t];
+    res.posts = b->posts +t *b->clscnt;
+  }                             /* get the classification result */
+  adapt(&res, b->clscnt, b->thresh);
+  return 0;                     /* adapt a two class result */
+}  /* result() */               /* and return 'ok' */
+
+/*--------------------------------------------------------------------*/
+
+static int pexec (PART *p, int clscnt, double thresh)
+{                               /* --- classify a tuple of a part */
+  int    i, k;                  /* loop variables, buffer */
+  ATT    *att;                  /* to traverse the attributes */
+  VALMAP *vm;                   /* to traverse the value maps */
+  int    *ids;                  /* buffer for reallocation */
+  INST   *inst;                 /* to traverse the instances */
+  double *posts;                /* posterior class probabilities */
+
+  for (i = as_attcnt(p->attset); --i >= 0; )
+    p->insts[i] = *att_inst(as_att(p->attset, i));
+  if (p->vmaps) {               /* if the classifier is binary, */
+    for (i = nbc_attcnt(nbc); --i >= 0; ) {     /* translate the */
+      att = as_att(p->attset, i);            /* value identifiers */
+      if ((att_type(att) != AT_NOM) || (i == nbc_clsid(nbc)))
+        continue;               /* only nominal values are mapped */
+      vm = p->vmaps +i;         /* get the value map */
+      k  = att_valcnt(att);     /* and the number of values */
+      if (k > vm->cnt) {        /* if new values have been read, */
+        ids = (int*)realloc(vm->ids, k *sizeof(int));
+        if (!ids) return -1;    /* enlarge the identifier vector */
+        for (vm->ids = ids; vm->cnt < k; vm->cnt++)
+          ids[vm->cnt] = nbc_valid(nbc, i, att_valname(att, vm->cnt));
+      }                         /* look up the new values */
+      inst = p->insts +i; k = inst->i;
+      inst->i = ((k >= 0) && (k < vm->cnt)) ? vm->ids[k] : NV_NOM;
+    }                           /* (values unknown to the classifier */
+  }                             /*  are treated like null values) */
+  if (fbc) {                    /* if full Bayes classifier */
+    p->res.class = fbc_exec_r(fbc, p->fws, p->insts, &p->res.prob);
+    posts = p->fws->posts; }
+  else {                        /* if naive Bayes classifier */
+    p->res.class = nbc_exec_r(nbc, p->nws, p->insts, &p->res.prob);
+    posts = p->nws->posts;      /* execute the classifier */
+  }                             /* with the part's workspace */
+  for (i = clscnt; --i >= 0; ) p->posts[i] = posts[i];
+  adapt(&p->res, clscnt, thresh);
+  return 0;                     /* copy the posteriors, adapt a */
+}  /* pexec() */                /* two class result, return 'ok' */
+
+/*--------------------------------------------------------------------*/
+
+static int split (FILE *in, CCHAR *fname, int flags, int cnt,
+                  int clscnt)
+{                               /* --- split a table file into parts */
+  int  i, n;                    /* loop variable, number of posts. */
+  long beg, end;                /* range of the table body */
+  PART *p;                      /* to traverse the parts */
+
+  assert(in && fname && (cnt > 0));
+  beg = ftell(in);              /* get the start of the table body */
+  if ((beg < 0) || (fseek(in, 0, SEEK_END) != 0))
+    return E_FREAD;             /* seek to the end of the file */
+  end = ftell(in);              /* and get the size of the file */
+  if (end < beg) return E_FREAD;
+  if ((end -beg) /PARTMIN < cnt)/* do not split into parts */
+    cnt = (int)((end -beg) /PARTMIN);        /* that are too small */
+  if (cnt < 1) cnt = 1;         /* use at least one part */
+  parts = (PART*)calloc(cnt, sizeof(PART));
+  if (!parts) return E_NOMEM;   /* create the part vector */
+  n = att_valcnt(res.att);      /* the class attribute may have */
+  if (n < clscnt) n = clscnt;   /* more values than the classifier */
+  for (p = parts, i = 0; i < cnt; i++, p++) {
+    p->fname  = fname;          /* traverse the parts */
+    p->beg    = beg +(long)((double)(end-beg) * i    /cnt);
+    p->end    = beg +(long)((double)(end-beg) *(i+1) /cnt);
+    if (i >= cnt-1) p->end = LONG_MAX;
+    p->skip   = (i > 0);        /* compute the range of the part */
+    p->pre    = (i <= 0) && (flags & AS_DFLT) && !(flags & AS_ATT);
+    p->flags  = flags;          /* (the first record may be read */
+    p->err    = E_NONE;         /*  together with a default header) */
+    partcnt++;                  /* clone the attribute set (with */
+    p->attset = as_clone(attset);     /* the field map of the file) */
+    if (!p->attset) return E_NOMEM;
+    as_info(p->attset)->p = &p->res;  /* and note the result */
+    p->res    = res;            /* (it is used by function infout) */
+    p->posts  = (double*)calloc((size_t)n+1, sizeof(double));
+    p->insts  = (INST*)  malloc(as_attcnt(attset) *sizeof(INST));
+    if (!p->posts || !p->insts) return E_NOMEM;
+    p->res.posts = p->posts;    /* create the result buffers */
+    if (fbc) p->fws = fbc_wscreate(fbc);
+    else     p->nws = nbc_wscreate(nbc);
+    if (!p->fws && !p->nws) return E_NOMEM;
+    if (vmaps) {                /* create an execution workspace */
+      p->vmaps = (VALMAP*)calloc(nbc_attcnt(nbc), sizeof(VALMAP));
+      if (!p->vmaps) return E_NOMEM;
+    }                           /* create value maps */
+  }                             /* (binary classifier) */
+  return 0;                     /* return 'ok' */
+}  /* split() */
+
+/*--------------------------------------------------------------------*/
+
+static void prun (PART *p, EXJOB *job)
+{                               /* --- process a part of a table */
+  int     c, k, r;              /* character read, flags, buffer */
+  FILE    *in;                  /* table file to read */
+  TABSCAN *tsc;                 /* table scanner of the clone */
+  TPLINF  *inf;                 /* buffer for reallocation */
+  ATT     *cls;                 /* class attribute of the clone */
+
+  assert(p && job);             /* check the function arguments */
+  in = fopen(p->fname, "rb");   /* open the table file */
+  if (!in) { p->err = E_FOPEN; return; }
+  if (fseek(in, (p->skip) ? p->beg-1 : p->beg, SEEK_SET) != 0) {
+    fclose(in); p->err = E_FREAD; return; }
+  tsc = as_tabscan(p->attset);  /* get the table scanner */
+  if (p->skip) {                /* if inside the table body, */
+    do c = getc(in); while ((c != EOF) && !ts_istype(tsc,TS_RECSEP,c));
+  }                             /* skip to the next record start */
+  ts_attach(tsc, in);           /* (a record belongs to the part */
+  cls = as_att(p->attset, att_id(res.att));      /* it starts in) */
+  k = AS_INST | (p->flags & ~(AS_ATT|AS_DFLT));
+  r = (p->pre) ? 0 : (ts_tell(tsc, in) < p->end)
+    ? as_read(p->attset, in, k) : 1;
+  while (r == 0) {              /* record read loop */
+    if (p->tplcnt >= p->infvsz) {
+      c   = p->infvsz +((p->infvsz > 1024) ? p->infvsz >> 1 : 1024);
+      inf = (TPLINF*)realloc(p->infs, c *sizeof(TPLINF));
+      if (!inf) { r = E_NOMEM; break; }
+      p->infs = inf; p->infvsz = c;
+    }                           /* enlarge the tuple info. vector */
+    if (pexec(p, job->clscnt, job->thresh) != 0) {
+      r = E_NOMEM; break; }     /* classify the tuple */
+    inf = p->infs +p->tplcnt++; /* note the tuple weight and */
+    inf->wgt  = as_getwgt(p->attset);  /* whether it was */
+    inf->miss = (p->res.class != att_inst(cls)->i);  /* misclass. */
+    if (p->out                  /* write or spool the tuple */
+    && (((job->mode < 0) ? spool(p->out, p->attset, &p->res, job->clscnt)
+    :    as_write(p->attset, p->out, job->mode, infout)) != 0)) {
+      r = E_FWRITE; break; }    /* (into the output of the part) */
+    r = (ts_tell(tsc, in) < p->end) ? as_read(p->attset, in, k) : 1;
+  }                             /* try to read the next record */
+  if (ferror(in) && (r >= 0)) r = E_FREAD;
+  ts_detach(tsc);               /* release the read buffer */
+  fclose(in);                   /* and close the table file */
+  p->err = (r < 0) ? r : E_NONE;/* note an error code */
+}  /* prun() */
+
+/*--------------------------------------------------------------------*/
+
+static void _exjob (EXJOB *job)
+{                               /* --- process an execution job */
+  int i;                        /* loop variable */
+
+  assert(job);                  /* check the function argument */
+  for (i = job->first; i < job->cnt; i += job->step)
+    prun(job->parts +i, job);   /* process the assigned parts */
+}  /* _exjob() */
+
+/*--------------------------------------------------------------------*/
+#ifdef NBC_THREADS
+
+static void* _exthd (void *job)
+{                               /* --- thread function for execution */
+  _exjob((EXJOB*)job);          /* process the execution job */
+  return NULL;                  /* and return a dummy result */
+}  /* _exthd() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static int prunall (int thcnt, int mode, BATCH *b)
+{                               /* --- process all parts of a table */
+  int       i, k;               /* loop variables */
+  EXJOB     *jobs;              /* execution jobs (one per thread) */
+  #ifdef NBC_THREADS
+  pthread_t *thds;              /* worker threads */
+  #endif
+
+  #ifndef NBC_THREADS
+  thcnt = 1;                    /* no threads without thread support */
+  #endif
+  if (thcnt > partcnt) thcnt = partcnt;
+  if (thcnt < 1)       thcnt = 1;
+  jobs = (EXJOB*)malloc(thcnt *sizeof(EXJOB));
+  if (!jobs) return E_NOMEM;    /* allocate the execution jobs */
+  for (i = thcnt; --i >= 0; ) { /* initialize the jobs */
+    jobs[i].parts  = parts;     jobs[i].cnt    = partcnt;
+    jobs[i].first  = i;         jobs[i].step   = thcnt;
+    jobs[i].mode   = mode;      jobs[i].clscnt = b->clscnt;
+    jobs[i].thresh = b->thresh; /* (parts are assigned round robin) */
+  }
+  #ifdef NBC_THREADS
+  thds = (thcnt > 1)            /* create a thread vector */
+       ? (pthread_t*)malloc(thcnt *sizeof(pthread_t)) : NULL;
+  if (thds) {                   /* if worker threads can be used */
+    for (i = 1; i < thcnt; i++) /* start the worker threads */
+      if (pthread_create(thds +i, NULL, _exthd, jobs +i) != 0)
+        break;                  /* (the first job is processed */
+    _exjob(jobs);               /* by the calling thread) */
+    for (k = i; k < thcnt; k++) /* process jobs for which no thread */
+      _exjob(jobs +k);          /* could be created, then wait */
+    while (--i > 0)             /* for the worker threads */
+      pthread_join(thds[i], NULL);
+    free(thds); }               /* delete the thread vector */
+  else
+  #endif
+  for (k = 0; k < thcnt; k++)   /* if no threads are available, */
+    _exjob(jobs +k);            /* process the jobs sequentially */
+  free(jobs);                   /* delete the execution jobs */
+  return 0;                     /* return 'ok' */
+}  /* prunall() */
+
+/*--------------------------------------------------------------------*/
+
+static void widths (void)
+{                               /* --- unify the column widths */
+  int  i, k;                    /* loop variables */
+  int  w0, w1;                  /* maximal value name widths */
+  ATT  *att;                    /* to traverse the attributes */
+
+  for (i = as_attcnt(attset); --i >= 0; ) {
+    att = as_att(attset, i);    /* traverse the attributes */
+    w0  = att_valwd(att, 0); w1 = att_valwd(att, 1);
+    for (k = partcnt; --k >= 0; ) {
+      att = as_att(parts[k].attset, i);
+      if (att_valwd(att, 0) > w0) w0 = att_valwd(att, 0);
+      if (att_valwd(att, 1) > w1) w1 = att_valwd(att, 1);
+    }                           /* determine the maximal widths */
+    for (k = partcnt; --k >= -1; ) {   /* over all parts and set */
+      att = as_att((k < 0) ? attset : parts[k].attset, i);
+      att->valwd[0] = w0; att->valwd[1] = w1;
+    }                           /* them in the attribute set */
+  }                             /* and all of its clones */
+}  /* widths() */               /* (values are read in the clones) */
+
+/*--------------------------------------------------------------------*/
+
+static int fcopy (FILE *src, FILE *dst)
+{                               /* --- copy the output of a part */
+  size_t n;                     /* number of characters read */
+  char   buf[4096];             /* buffer for the characters */
+
+  rewind(src);                  /* copy the contents of the file */
+  while ((n = fread(buf, 1, sizeof(buf), src)) > 0)
+    if (fwrite(buf, 1, n, dst) != n) return -1;
+  return (ferror(src) || ferror(dst)) ? -1 : 0;
+}  /* fcopy() */
+
+/*--------------------------------------------------------------------*/
+#ifdef BCX_POSIX
+
+static int rebind (ATTSET *old, int flags, CCHAR *seps)
+{                               /* --- bind the fields of a session */
+  int    i, k, n;               /* loop variable, buffers */
+  int    dummy = -1;            /* attribute for skipped fields */
+  size_t z;                     /* size of the table header */
+  char   *hdr, *p;              /* table header of the session */
+  FILE   *tmp;                  /* stream to read the header from */
+  TSINFO *err;                  /* error information */
+
+  n = as_fldcnt(old);           /* get the number of fields */
+  if (nbc && (nbc_bktcnt(nbc) > 0))    /* skipped fields are */
+    dummy = (nbc_clsid(nbc) != 0) ? 0 : 1;     /* bound to a */
+  for (z = 4, i = 0; i < n; i++) {     /* bucket of the new class. */
+    k = as_fldid(old, i);       /* traverse the fields of the session */
+    if ((k < 0) && (dummy < 0)) return E_MISFLD;
+    z += strlen(att_name((k >= 0) ? as_att(old, k)
+                                  : as_att(attset, dummy))) +1;
+  }                             /* sum the lengths of the names */
+  hdr = p = (char*)malloc(z);   /* create a buffer for the header */
+  if (!hdr) return E_NOMEM;     /* (in memory, since the session */
+  for (i = 0; i < n; i++) {     /*  waits for the new classifier) */
+    k = as_fldid(old, i);       /* traverse the fields again */
+    if (i > 0) *p++ = seps[1];  /* and write the field names */
+    strcpy(p, att_name((k >= 0) ? as_att(old, k)
+                                : as_att(attset, dummy)));
+    p += strlen(p);             /* (the header is rebuilt from */
+  }                             /*  the fields of the session) */
+  if (flags & AS_WEIGHT) { *p++ = seps[1]; *p++ = 'w'; }
+  *p++ = seps[2];               /* terminate the table header */
+  tmp = fmemopen(hdr, (size_t)(p -hdr), "r");
+  if (!tmp) { free(hdr); return E_NOMEM; }
+  marks();                      /* read the header into the new set */
+  i = as_read(attset, tmp, AS_ATT|AS_MARKED|(flags & AS_WEIGHT));
+  fclose(tmp); free(hdr);       /* (this binds the fields of */
+  if (i != 0) {                 /*  the session to attributes) */
+    err = as_err(attset);       /* if the fields cannot be bound */
+    io_error(i, "<reload>", 1, err->s, err->fld, err->exp);
+  }                             /* report the error */
+  return i;                     /* return the error code */
+}  /* rebind() */
+
+/*--------------------------------------------------------------------*/
+
+static int install (MODEL *m, BATCH *b, int flags, int bind,
+                    CCHAR *seps)
+{                               /* --- install a reloaded classifier */
+  int    i, n;                  /* loop variable, number of classes */
+  MODEL  old;                   /* classifier in use */
+  TUPLE  *tpl;                  /* new tuple */
+  void   *p;                    /* buffer for reallocation */
+
+  old.attset = attset; old.nbc = nbc; old.fbc = fbc; old.vmaps = vmaps;
+  attset = m->attset; nbc = m->nbc; fbc = m->fbc; vmaps = m->vmaps;
+  res.att = as_att(attset, (fbc) ? fbc_clsid(fbc) : nbc_clsid(nbc));
+  if (bind && (rebind(old.attset, flags, seps) != 0)) {
+    attset = old.attset; nbc = old.nbc; fbc = old.fbc; vmaps = old.vmaps;
+    res.att = as_att(attset, (fbc) ? fbc_clsid(fbc) : nbc_clsid(nbc));
+    return 1;                   /* if the session cannot be bound, */
+  }                             /* keep the old classifier */
+  n = (fbc) ? fbc_clscnt(fbc) : nbc_clscnt(nbc);
+  if (n > b->clscnt) {          /* if there are more classes */
+    p = realloc(b->confs, b->size *(n+1) *sizeof(double));
+    if (!p) return -1;          /* enlarge the result buffer */
+    b->confs = (double*)p; b->posts = b->confs +b->size;
+  }                             /* set the number of classes */
+  b->clscnt = n;                /* (and the posteriors buffer) */
+  for (i = b->size; --i >= 0; ) {
+    tpl = tpl_create(attset,0); /* create tuples */
+    if (!tpl) return -1;        /* for the new attribute set */
+    tpl_delete(b->tpls[i]); b->tpls[i] = tpl;
+  }                             /* replace the old tuples */
+  if (b->insts) { free(b->insts); b->insts = NULL; }
+  if (nbc && (nbc_bktcnt(nbc) > 0)) {
+    b->insts = (SPINST*)malloc((size_t)as_attcnt(attset)
+                              *sizeof(SPINST));
+    if (!b->insts) return -1;   /* create a buffer for */
+  }                             /* the hashed token instantiations */
+  if (b->cols)  { free(b->cols);  b->cols  = NULL; }
+  if (vmaps) {                  /* if the classifier is binary */
+    b->cols = (INST*)malloc((size_t)b->size *nbc_attcnt(nbc)
+                           *sizeof(INST));
+    if (!b->cols) return -1;    /* create a column block */
+  }
+  mdelete(&old); free(m);       /* delete the old classifier */
+  fprintf(stderr, "reloaded %s [%d attribute(s)]\n",
+          ldr.fname, as_attcnt(attset));
+  return 0;                     /* return 'ok' */
+}  /* install() */
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
+static int reply (FILE *out, int clscnt, CCHAR *seps,
+                  int code, int fld)
+{                               /* --- reply to a request (server) */
+  int        i;                 /* loop variable */
+  const char *s;                /* error indicator */
+
+  if      (code > 0) {          /* if to acknowledge a table header, */
+    fputs("ok", out);           /* list the classes (in the order */
+    for (i = 0; i < clscnt; i++) { /* of the posterior probs.) */
+      fputc(seps[1], out);
+      fputs(att_valname(res.att, i), out);
+    } }
+  else if (code == 0) {         /* if to return a result, */
+    fputs("ok", out);           /* write the class, the confidence, */
+    fputc(seps[1], out);        /* and (if requested) the posterior */
+    fputs(att_valname(res.att, res.class), out);     /* probabilities */
+    fputc(seps[1], out); fprintf(out, res.format, res.prob);
+    for (i = 0; res.all && (i < clscnt); i++) {
+      fputc(seps[1], out); fprintf(out, res.format, res.posts[i]); }
+    }
+  else {                        /* if to report an error */
+    switch (code) {             /* get an error indicator */
+      case E_VALUE : s = "value";     break;
+      case E_FLDCNT: s = "fields";    break;
+      case E_EMPFLD: s = "empty";     break;
+      case E_DUPFLD: s = "duplicate"; break;
+      case E_MISFLD: s = "missing";   break;
+      case E_NOMEM : s = "memory";    break;
+      default      : s = "read";      break;
+    }                           /* write the error indicator */
+    fputs("err", out); fputc(seps[1], out);   /* and the number */
+    fputs(s,     out); fputc(seps[1], out);   /* of the field */
+    fprintf(out, "%d", fld);    /* in which the error occurred */
+  }
+  fputc(seps[2], out);          /* terminate the reply and */
+  fflush(out);                  /* send it to the client */
+  return ferror(out) ? -1 : 0;  /* check for a write error */
+}  /* reply() */
+
+/*--------------------------------------------------------------------*/
+
+static int serve (FILE *in, FILE *out, BATCH *b, int flags,
+                  CCHAR *seps)
+{                               /* --- serve classification requests */
+  int     r, d;                 /* result of read, delimiter type */
+  int     rec = 0;              /* number of the current record */
+  int     f;                    /* flags for reading records */
+  TUPLE   *tpl;                 /* tuple for a record */
+  SPINST  *insts;               /* buffer for reallocation */
+  TSINFO  *err;                 /* error information */
+  TABSCAN *tsc;                 /* table scanner of attribute set */
+  #ifdef BCX_POSIX
+  MODEL   *m;                   /* reloaded classifier */
+  int     defer = 0;            /* whether to defer a reload */
+  #endif
+
+  assert(in && out && b);       /* check the function arguments */
+  #ifdef BCX_POSIX
+  if ((m = fetch(&ldr)) != NULL) {   /* if the classifier was */
+    r = install(m, b, flags, flags & AS_ATT, seps); /* reloaded, */
+    if (r < 0) return -1;       /* install it for this session */
+    if (r > 0) repend(&ldr, m); /* (if the header file does not */
+  }                             /*  fit, keep the old classifier) */
+  #endif
+  f = AS_INST | (flags & ~(AS_ATT|AS_DFLT));
+  if (flags & AS_ATT)           /* if the header has been read, */
+    r = as_read(attset, in, f); /* read the first record */
+  else {                        /* if the header is sent by a client */
+    marks();                    /* mark the attributes to read */
+    r = as_read(attset, in, flags|AS_MARKED|AS_ATT);
+    if (r != 0) {               /* read the table header */
+      if (feof(in)) return 0;   /* (or the first record with -d) */
+      err = as_err(attset);     /* on error get the error info., */
+      io_error(r, "<client>", 1, err->s, err->fld, err->exp);
+      reply(out, b->clscnt, seps, r, err->fld);
+      return 0;                 /* report the error to the client */
+    }                           /* and close the session */
+    if (b->insts) {             /* if hashed classifier, clear */
+      for (d = as_attcnt(attset); --d >= nbc_attcnt(nbc); )
+        if (att_getmark(as_att(attset, d)) < 0)
+          att_inst(as_att(attset, d))->i = NV_NOM;
+    }                           /* tokens missing from the header */
+    tpl = tpl_create(attset,0); /* as attributes may have been added */
+    if (!tpl) return -1;        /* by the header, create a new tuple */
+    tpl_delete(b->tpls[0]);     /* for the records of the session */
+    b->tpls[0] = tpl;           /* and enlarge the token buffer */
+    if (b->insts) {             /* (hashed classifier) */
+      insts = (SPINST*)realloc(b->insts,
+                (size_t)as_attcnt(attset) *sizeof(SPINST));
+      if (!insts) return -1;    /* resize the token buffer */
+      b->insts = insts;         /* for the token attributes */
+    }                           /* created by the header */
+    if (flags & AS_DFLT) r = 0; /* first record has been read */
+    else if (reply(out, b->clscnt, seps, 1, 0) != 0) return 0;
+    else { rec = 1; r = as_read(attset, in, f); }
+  }                             /* acknowledge the header */
+  while (r <= 0) {              /* record read loop */
+    rec++;                      /* count the record */
+    if (r < 0) {                /* if the record is invalid */
+      err = as_err(attset);     /* get the error information */
+      if (r == E_FREAD) return 0;   /* (abort on read errors) */
+      if (r == E_NOMEM) return -1;  /* and on memory errors) */
+      io_error(r, "<client>", rec, err->s, err->fld, err->exp);
+      tsc = as_tabscan(attset); /* get the table scanner and */
+      d = ts_delim(tsc);        /* skip the rest of the record */
+      while (d == TS_FLD) d = ts_next(tsc, in, NULL, 0);
+      if (reply(out, b->clscnt, seps, r, err->fld) != 0) return 0; }
+    else {                      /* if the record is valid */
+      tpl_fromas(b->tpls[0]);   /* classify it as a batch */
+      if ((classify(b, 1) != 0) /* with a single tuple */
+      ||  (result(b, 0)   != 0)) return -1;
+      if (reply(out, b->clscnt, seps, 0, 0) != 0) return 0;
+    }                           /* reply with the result */
+    #ifdef BCX_POSIX            /* between two records */
+    if (!defer && ((m = fetch(&ldr)) != NULL)) {
+      r = install(m, b, flags, 1, seps);
+      if (r < 0) return -1;     /* install a reloaded classifier */
+      if (r > 0) { repend(&ldr, m); defer = 1; }
+    }                           /* (if the fields of the session */
+    #endif                      /*  cannot be bound, wait for the */
+    r = as_read(attset, in, f); /*  next session to install it) */
+  }                             /* read the next record */
+  return 0;                     /* return 'ok' */
+}  /* serve() */
+
+/*--------------------------------------------------------------------*/
+#ifdef BCX_POSIX
+
+static int sockserve (const char *path, BATCH *b, int flags,
+                      CCHAR *seps)
+{                               /* --- serve on a Unix domain socket */
+  int    sd, cd;                /* socket descriptors */
+  struct sockaddr_un addr;      /* address of the socket */
+
+  assert(path && b);            /* check the function arguments */
+  if (strlen(path) >= sizeof(addr.sun_path)) return -2;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;    /* build the socket address */
+  strcpy(addr.sun_path, path);  /* and create the socket */
+  sd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sd < 0) return -2;        /* remove a stale socket file */
+  unlink(path);                 /* and bind the socket to the path */
+  if ((bind(sd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+  ||  (listen(sd, 16) != 0)) { close(sd); return -2; }
+  while (1) {                   /* connection loop */
+    cd = accept(sd, NULL, NULL);
+    if (cd < 0) continue;       /* accept the next client */
+    in  = fdopen(cd, "r");      /* and open streams for reading */
+    out = (in) ? fdopen(dup(cd), "w") : NULL;  /* and writing */
+    if (in && out && (serve(in, out, b, flags, seps) != 0)) {
+      close(sd); return -1; }   /* serve the client until it */
+    tokcut(flags);              /* closes the connection and */
+    if (out) fclose(out);       /* remove the tokens of the session */
+    if (in)  fclose(in); else close(cd);
+    in = out = NULL;            /* close the streams */
+  }                             /* (the server runs until it */
+}  /* sockserve() */            /*  is terminated by a signal) */
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
 int main (int argc, char* argv[])
 {                               /* --- main function */
-  int    i, k = 0, f;           /* loop variables, buffer */
+  int    i, k = 0, f, t, n;     /* loop variables, buffer */
   char   *s;                    /* to traverse options */
   char   **optarg = NULL;       /* option argument */
   char   *fn_hdr  = NULL;       /* name of table header file */
   char   *fn_tab  = NULL;       /* name of table file */
   char   *fn_bc   = NULL;       /* name of classifier file */
   char   *fn_out  = NULL;       /* name of output file */
+  char   *fn_sock = NULL;       /* name of Unix domain socket */
   char   *blanks  = NULL;       /* blanks */
   char   *fldseps = NULL;       /* field  separators */
   char   *recseps = NULL;       /* record separators */
   char   *nullchs = NULL;       /* null value characters */
   char   *comment = NULL;       /* comment characters */
   double lcorr    = -DBL_MAX;   /* Laplace correction value */
-  double thresh   = 0.5;        /* classification threshold */
   int    dwnull   = 0;          /* distribute weight of null values */
   int    maxllh   = 0;          /* max. likelihood est. of variance */
   int    inflags  = 0;          /* table file read  flags */
   int    outflags = AS_ATT;     /* table file write flags */
+  int    serv     = 0;          /* flag for server mode */
+  int    thcnt    = 1;          /* number of threads */
+  int    par;                   /* flag for parallel execution */
+  PART   *p;                    /* to traverse the table parts */
   int    tplcnt   = 0;          /* number of tuples */
   double tplwgt   = 0;          /* weight of tuples */
   double errcnt   = 0;          /* number of misclassifications */
-  int    clscnt;                /* number of classes */
-  int    attid;                 /* loop variable for attributes */
   float  wgt;                   /* tuple/instantiation weight */
-  int    mode;                  /* classifier setup mode */
   TSINFO *err;                  /* error information */
+  char   seps[8];               /* separator characters */
+  MODEL  mdl;                   /* loaded classifier */
+  #ifdef BCX_POSIX
+  struct sigaction sa;          /* signal action for reloading */
+  #ifdef NBC_THREADS
+  pthread_t thd;                /* loader thread */
+  #endif
+  #endif
+  BATCH  b = { 256, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0.5 };
 
   prgname = argv[0];            /* get program name for error msgs. */
 
@@ -241,6 +1246,8 @@ int main (int argc, char* argv[])
   else {                        /* if no argument given */
     printf("usage: %s [options] bcfile "
                      "[-d|-h hdrfile] tabfile [outfile]\n", argv[0]);
+    printf("       %s -S|-U# [options] bcfile "
+                     "[-d|-h hdrfile]\n", argv[0]);
     printf("%s\n", DESCRIPTION);
     printf("%s\n", VERSION);
     printf("-c#      classification field name "
@@ -253,7 +1260,11 @@ int main (int argc, char* argv[])
     printf("-L#      Laplace correction "
                     "(default: as specified in classifier)\n");
     printf("-t#      probability threshold "
-                    "(two class problems only, default: %g)\n", thresh);
+                    "(two class problems only, default: %g)\n", b.thresh);
+    printf("-B#      number of tuples to classify at once "
+                    "(default: %d)\n", b.size);
+    printf("-T#      number of threads "
+                    "(default: %d, ordered output)\n", thcnt);
     printf("-v/V     (do not) distribute tuple weight "
                     "for null values\n");
     printf("-m/M     (do not) use maximum likelihood estimate "
@@ -266,7 +1277,16 @@ int main (int argc, char* argv[])
     printf("-C#      comment characters    (default: \"#\")\n");
     printf("-u#      null value characters (default: \"?*\")\n");
     printf("-n       number of tuple occurrences in last field\n");
+    printf("-S       serve requests on stdin/stdout "
+                    "(one reply per record)\n");
+    #ifdef BCX_POSIX
+    printf("-U#      serve requests on Unix domain socket #\n");
+    printf("-R       reload the classifier if its file changes "
+                    "or on SIGHUP\n");
+    printf("         (server mode only, swapped in between records)\n");
+    #endif
     printf("bcfile   file containing classifier description\n");
+    printf("         (or binary classifier file written by bci -z)\n");
     printf("-d       use default table header "
                     "(field names = field numbers)\n");
     printf("-h       read table header (field names) from hdrfile\n");
@@ -289,7 +1309,9 @@ int main (int argc, char* argv[])
           case 'o': optarg    = &res.format;        break;
           case 'x': res.all   = 1;                  break;
           case 'L': lcorr     = strtod(s, &s);      break;
-          case 't': thresh    = strtod(s, &s);      break;
+          case 't': b.thresh  = strtod(s, &s);      break;
+          case 'B': b.size = (int)strtol(s, &s, 0); break;
+          case 'T': thcnt  = (int)strtol(s, &s, 0); break;
           case 'v': dwnull    = NBC_ALL;            break;
           case 'V': dwnull   |= NBC_DWNULL|NBC_ALL; break;
           case 'm': maxllh    = NBC_ALL;            break;
@@ -305,6 +1327,9 @@ int main (int argc, char* argv[])
           case 'C': optarg    = &comment;           break;
           case 'd': inflags  |= AS_DFLT;            break;
           case 'h': optarg    = &fn_hdr;            break;
+          case 'S': serv      = 1;                  break;
+          case 'U': optarg    = &fn_sock; serv = 1; break;
+          case 'R': ldr.reload = 1;                 break;
           default : error(E_OPTION, *--s);          break;
         }                       /* set option variables */
         if (!*s) break;         /* if at end of string, abort loop */
@@ -320,133 +1345,244 @@ int main (int argc, char* argv[])
     }
   }
   if (optarg) error(E_OPTARG);  /* check the option argument */
-  if ((k < 2) || (k > 3))       /* and the number of arguments */
-    error(E_ARGCNT);
+  if (serv ? (k != 1)           /* and the number of arguments */
+           : ((k < 2) || (k > 3))) error(E_ARGCNT);
+  #ifndef BCX_POSIX
+  if (fn_sock) error(E_SOCKET, fn_sock);
+  #endif                        /* check for socket support */
   if (fn_hdr && (strcmp(fn_hdr, "-") == 0))
     fn_hdr = "";                /* convert "-" to "" */
   i = (!fn_bc  || !*fn_bc) ? 1 : 0;
-  if  (!fn_tab || !*fn_tab) i++;
+  if  (serv ? !fn_sock : (!fn_tab || !*fn_tab)) i++;
   if  ( fn_hdr && !*fn_hdr) i++;/* check assignments of stdin: */
   if (i > 1) error(E_STDIN);    /* stdin must not be used twice */
   if ((lcorr < 0) && (lcorr > -DBL_MAX))
     error(E_NEGLC);             /* check the Laplace correction */
+  if (b.size < 1) error(E_BATCH);  /* and the batch size */
+  if (serv) b.size = 1;         /* serve requests one by one */
   if (fn_hdr)                   /* set the header file flag */
     inflags = AS_ATT | (inflags & ~AS_DFLT);
   if ((outflags & AS_ATT) && (outflags & AS_ALIGN))
     outflags |= AS_ALNHDR;      /* set align to header flag */
 
   /* --- read Bayes classifier --- */
-  scan = sc_create(fn_bc);      /* create a scanner */
-  if (!scan) error((!fn_bc || !*fn_bc) ? E_NOMEM : E_FOPEN, fn_bc);
-  attset = as_create("domains", att_delete);
-  if (!attset) error(E_NOMEM);  /* create an attribute set */
-  fprintf(stderr, "\nreading %s ... ", sc_fname(scan));
-  if ((sc_nexter(scan)   <  0)  /* start scanning (get first token) */
-  ||  (as_parse(attset, scan, AT_ALL) != 0)
-  ||  (as_attcnt(attset) <= 0)) /* parse attribute set */
-    error(E_PARSE, sc_fname(scan));
-  if ((sc_token(scan) == T_ID)  /* determine classifier type */
-  &&  (strcmp(sc_value(scan), "fbc") == 0))
-       fbc = fbc_parse(attset, scan);
-  else nbc = nbc_parse(attset, scan);
-  if ((!fbc && !nbc)            /* parse the Bayes classifier */
-  ||   !sc_eof(scan))           /* and check for end of file */
-    error(E_PARSE, sc_fname(scan));
-  sc_delete(scan); scan = NULL; /* delete the scanner */
-  fprintf(stderr, "[%d attribute(s)] done.\n", as_attcnt(attset));
-  if ((lcorr >= 0) || dwnull || maxllh) {
-    if (lcorr < 0)              /* get the classifier's parameters */
-      lcorr = (fbc) ? fbc_lcorr(fbc) : nbc_lcorr(nbc);
-    mode    = (fbc) ? fbc_mode(fbc)  : nbc_mode(nbc);
-    if (dwnull) mode = (mode & ~NBC_DWNULL) | dwnull;
-    if (maxllh) mode = (mode & ~NBC_MAXLLH) | maxllh;
-                                /* adapt the estimation parameters */
-    if (fbc) fbc_setup(fbc, mode, lcorr);
-    else     nbc_setup(nbc, mode, lcorr);
-  }                             /* set up the classifier anew */
+  ldr.fname    = fn_bc;         /* note the loader parameters */
+  ldr.lcorr    = lcorr;  ldr.dwnull = dwnull; ldr.maxllh = maxllh;
+  ldr.chars[0] = recseps; ldr.chars[1] = fldseps;
+  ldr.chars[2] = blanks;  ldr.chars[3] = nullchs;
+  ldr.chars[4] = comment; /* (also needed to reload the classifier) */
+  if (!fn_bc || !*fn_bc) { fn_bc = "<stdin>"; ldr.reload = 0; }
+  fprintf(stderr, "\nreading %s ... ", fn_bc);
+  i = load(&mdl, &ldr);         /* load the Bayes classifier */
+  if (i != 0) error(i, fn_bc);  /* (binary file or description) */
+  attset = mdl.attset; nbc = mdl.nbc; fbc = mdl.fbc; vmaps = mdl.vmaps;
+  fprintf(stderr, "[%d attribute(s)] ", as_attcnt(attset));
+  if (nbc && nbc_quant(nbc))    /* print the error bound */
+    fprintf(stderr, "[log. posterior error <= %g] ", nbc_qerr(nbc));
+  if (nbc && (nbc_bktcnt(nbc) > 0))  /* print the number of buckets */
+    fprintf(stderr, "[%d hash bucket(s)] ", nbc_bktcnt(nbc));
+  fprintf(stderr, "done.\n");  /* of a quantized classifier */
   if (fbc) {                    /* if full Bayes classifier */
-    clscnt  = fbc_clscnt(fbc);  /* get class information */
+    b.clscnt = fbc_clscnt(fbc); /* get class information */
     res.att = as_att(attset, fbc_clsid(fbc)); }
   else {                        /* if naive Bayes classifier */
-    clscnt  = nbc_clscnt(nbc);  /* get class information */
+    b.clscnt = nbc_clscnt(nbc); /* get class information */
     res.att = as_att(attset, nbc_clsid(nbc));
+    if (vmaps) {                /* if the classifier is binary */
+      b.cols = (INST*)malloc((size_t)b.size *nbc_attcnt(nbc)
+                            *sizeof(INST));
+      if (!b.cols) error(E_NOMEM);
+    }                           /* create a column block */
   }                             /* (class att. and num. of classes) */
 
   /* --- read table header --- */
-  for (attid = as_attcnt(attset); --attid >= 0; )
-    att_setmark(as_att(attset, attid), 1);
-  att_setmark(res.att, 0);      /* mark all attribs. except the class */
-  as_chars(attset, recseps, fldseps, blanks, nullchs, comment);
-  in = io_hdr(attset, fn_hdr, fn_tab, inflags|AS_MARKED, 1);
-  if (!in) error(1);            /* read the table header */
+  marks();                      /* mark the attributes to read */
+  memcpy(seps, as_chars(attset, NULL, NULL, NULL, NULL, NULL),
+         sizeof(seps));         /* copy the separator characters */
+                                /* (the attribute set may be reloaded) */
+  if (!serv || fn_hdr) {        /* if not to read a header per client */
+    if (serv) fprintf(stderr, "reading %s ... ", fn_hdr);
+    in = io_hdr(attset, fn_hdr, (serv) ? NULL : fn_tab,
+                inflags|AS_MARKED, !serv);
+    if (!in) error(1);          /* read the table header */
+    if (serv) fprintf(stderr, "[%d attribute(s)] done.\n",
+                      as_attcnt(attset));
+  }                             /* (in server mode: from file only) */
+  if (nbc && (nbc_bktcnt(nbc) > 0)) {
+    b.insts = (SPINST*)malloc((size_t)as_attcnt(attset)
+                             *sizeof(SPINST));
+    if (!b.insts) error(E_NOMEM); /* create a buffer for */
+  }                             /* the hashed token instantiations */
 
   /* --- classify tuples --- */
   if ((att_getmark(res.att) < 0)/* either the class must be present */
-  &&  (k <= 2))                 /* or an output file must be written */
+  &&  (k == 2))                 /* or an output file must be written */
     error(E_CLASS, att_name(res.att), fn_tab);
+  par = (thcnt > 1) && !serv    /* check for parallel execution */
+     && in && (in != stdin)     /* (parts of a table file, but */
+     && !b.insts;               /* tokens are mapped sequentially) */
+  #ifndef NBC_THREADS
+  par = 0;                      /* no threads without thread support */
+  #endif
   if (k > 2) {                  /* if to write an output table */
-    if ((outflags & AS_ALIGN)   /* if to align output file */
-    &&  (in != stdin)) {        /* and not to read from stdin */
-      i = AS_INST | (inflags & ~(AS_ATT|AS_DFLT));
-      while (as_read(attset, in, i) == 0);
-      fclose(in);               /* determine the column widths */
-      fprintf(stderr, "done.\n");
-      in = io_hdr(attset, fn_hdr, fn_tab, inflags|AS_MARKED, 1);
-      if (!in) error(1);        /* reread the table header */
-    }                           /* (necessary because of first tuple) */
     if (fn_out && *fn_out)      /* if a proper file name is given, */
       out = fopen(fn_out, "w"); /* open output file for writing */
     else {                      /* if no proper file name is given, */
       out = stdout; fn_out = "<stdout>"; }       /* write to stdout */
     if (!out) error(E_FOPEN, fn_out);
     k = AS_MARKED|AS_INFO1|AS_RDORD|outflags;
-    if (outflags & AS_ATT)      /* if to write table header */
-      as_write(attset, out, k, infout);
-    k = AS_INST|(k & ~AS_ATT);  /* write the attribute names */
-  }                             /* to the output file */
-  f = AS_INST | (inflags & ~(AS_ATT|AS_DFLT));
-  i = ((inflags & AS_DFLT) && !(inflags & AS_ATT))
-    ? 0 : as_read(attset, in, f);
-  while (i == 0) {              /* record read loop */
-    res.class = (fbc) ? fbc_exec(fbc, NULL, &res.prob)
-                      : nbc_exec(nbc, NULL, &res.prob);
-    if (clscnt <= 2) {          /* if this is a two class problem */
-      if (res.class <= 0) {     /* check and adapt class 0 result */
-	if (res.prob <   thresh) {
-          res.class = 1; res.prob = 1 -res.prob; } }
-      else {                    /* check and adapt class 1 result */
-        if (res.prob < 1-thresh) {
-          res.class = 0; res.prob = 1 -res.prob; }
-      }                         /* (classify as class 0 if prob. */
-    }                           /* of this class is >= threshold) */
-    wgt = as_getwgt(attset);    /* classify tuple */
-    tplwgt += wgt; tplcnt++;    /* count tuple and sum its weight */
-    if (res.class != att_inst(res.att)->i)
-      errcnt += wgt;            /* count classification errors */
-    if (out && (as_write(attset, out, k, infout) != 0))
-      error(E_FWRITE, fn_out);  /* write tuple to output file */
-    i = as_read(attset, in, f); /* try to read the next record */
+    if ((outflags & AS_ALIGN)   /* if to align output file */
+    &&  (in != stdin)) {        /* and not to read from stdin, */
+      if (!par) spl = tmpfile();/* spool the classified tuples, */
+      if (!par && !spl)         /* since the column widths */
+        error(E_FOPEN, "<tmpfile>"); }   /* are known only at the end */
+    else {                      /* (parts spool their own tuples) */
+      if (outflags & AS_ATT)    /* if to write table header */
+        as_write(attset, out, k, infout);
+      k = AS_INST|(k & ~AS_ATT);/* write the attribute names */
+    }                           /* to the output file */
   }
+  b.tpls  = (TUPLE**)malloc(b.size *sizeof(TUPLE*));
+  b.clss  = (int*)   malloc(b.size *sizeof(int));
+  b.confs = (double*)malloc(b.size *(b.clscnt+1) *sizeof(double));
+  if (!b.tpls || !b.clss || !b.confs) error(E_NOMEM);
+  b.posts = b.confs +b.size;    /* create buffers for a batch */
+  for (n = 0; n < b.size; n++){ /* of tuples and their results */
+    b.tpls[n] = tpl_create(attset, 0);
+    if (!b.tpls[n]) error(E_NOMEM);
+  }                             /* create the tuples of a batch */
+  if (serv) {                   /* if to serve requests */
+    #ifdef SIGPIPE              /* ignore broken connections */
+    signal(SIGPIPE, SIG_IGN);   /* (clients may disconnect early) */
+    #endif
+    #ifdef BCX_POSIX
+    if (ldr.reload) {           /* if to reload the classifier */
+      changed(&ldr); ldr.settled = 1;  /* note the file status */
+      memset(&sa, 0, sizeof(sa));      /* and catch SIGHUP */
+      sa.sa_handler = sighup;   /* (restart interrupted reads */
+      sa.sa_flags   = SA_RESTART;      /* of client requests) */
+      sigemptyset(&sa.sa_mask); sigaction(SIGHUP, &sa, NULL);
+      #ifdef NBC_THREADS        /* start a loader thread */
+      pthread_mutex_init(&ldr.mutex, NULL);
+      ldr.async = (pthread_create(&thd, NULL, _rldthd, &ldr) == 0);
+      if (ldr.async) pthread_detach(thd);
+      #endif                    /* (without threads the file */
+    }                           /*  is polled between records) */
+    if (fn_sock) {              /* if to serve on a socket */
+      fprintf(stderr, "serving on %s ...\n", fn_sock);
+      i = sockserve(fn_sock, &b, inflags, seps);
+      error((i == -2) ? E_SOCKET : E_NOMEM, fn_sock);
+    }                           /* (returns only on error) */
+    #endif
+    fprintf(stderr, "serving on <stdin> ...\n");
+    if (serve(stdin, stdout, &b, inflags, seps) != 0)
+      error(E_NOMEM);           /* serve requests on stdin/stdout */
+    fprintf(stderr, "done.\n"); /* until the client closes stdin */
+    in = NULL; k = 0;           /* (skip the batch read loop) */
+  }
+  if (par) {                    /* if to execute in parallel */
+    i = split(in, fn_tab, inflags, thcnt, b.clscnt);
+    fclose(in); in = NULL;      /* split the table body into parts */
+    if (i == E_FREAD) error(E_FREAD, fn_tab);
+    if (i != 0)       error(E_NOMEM);
+    fprintf(stderr, "[%d part(s)] ", partcnt);
+    for (p = parts +partcnt; out && (--p >= parts); )
+      if (!(p->out = tmpfile())) error(E_FOPEN, "<tmpfile>");
+    if (prunall(thcnt, (outflags & AS_ALIGN) ? -1 : k, &b) != 0)
+      error(E_NOMEM);           /* process the parts with threads */
+    for (i = 0; i < partcnt; i++) {
+      p = parts +i;             /* traverse the parts in file order */
+      for (t = 0; t < p->tplcnt; t++) {
+        wgt = p->infs[t].wgt;   /* count the tuples and sum their */
+        tplwgt += wgt; tplcnt++;/* weights in the same order as */
+        if (p->infs[t].miss) errcnt += wgt;   /* in a serial run */
+      }                         /* (so that the sums are identical) */
+      if (out && !(outflags & AS_ALIGN) && (fcopy(p->out, out) != 0))
+        error(E_FWRITE, fn_out);/* copy the output of the part */
+      if (p->err == E_FOPEN)  error(E_FOPEN,  fn_tab);
+      if (p->err == E_FWRITE) error(E_FWRITE, "<tmpfile>");
+      if (p->err <  0) {        /* if an error occurred, */
+        err = as_err(p->attset);/* get the error information */
+        tplcnt += (inflags & (AS_ATT|AS_DFLT)) ? 1 : 2;
+        io_error(p->err, fn_tab, tplcnt, err->s, err->fld, err->exp);
+        error(1);               /* print an error message */
+      }                         /* and abort the program */
+    }
+    if (out && (outflags & AS_ALIGN)) {
+      widths();                 /* unify the column widths */
+      if (k & AS_ATT)           /* if to write table header */
+        as_write(attset, out, k, infout);
+      k = AS_INST|(k & ~AS_ATT);/* write the attribute names */
+      for (i = 0; i < partcnt; i++) {
+        p = parts +i;           /* traverse the parts in file order */
+        p->res.w_class = res.w_class; p->res.w_prob = res.w_prob;
+        if (unspool(p->out, out, p->attset, &p->res, k, b.clscnt) != 0)
+          error(E_FWRITE, fn_out);
+      }                         /* write the spooled tuples aligned */
+    }                           /* (with the final column widths) */
+    pclear();                   /* delete the table parts */
+  }
+  f = AS_INST | (inflags & ~(AS_ATT|AS_DFLT));
+  if (in) ts_attach(as_tabscan(attset), in);
+  i = (!in) ? 1 : ((inflags & AS_DFLT) && !(inflags & AS_ATT))
+    ? 0 : as_read(attset, in, f);  /* read the body buffered */
+  while (i == 0) {              /* batch read loop */
+    n = 0;                      /* collect a batch of tuples */
+    do { tpl_fromas(b.tpls[n++]);  /* (stop at end of the input) */
+    } while ((n < b.size) && ((i = as_read(attset, in, f)) == 0));
+    if (classify(&b, n) != 0)   /* classify the batch of tuples */
+      error(E_NOMEM);           /* (block or naive Bayes batch) */
+    for (t = 0; t < n; t++) {   /* traverse the tuples of the batch */
+      if (result(&b, t) != 0)   /* restore the instantiation and */
+        error(E_NOMEM);         /* get the classification result */
+      wgt = as_getwgt(attset);  /* classify tuple */
+      tplwgt += wgt; tplcnt++;  /* count tuple and sum its weight */
+      if (res.class != att_inst(res.att)->i)
+        errcnt += wgt;          /* count classification errors */
+      if (spl) {                /* if to spool the tuple */
+        if (spool(spl, attset, &res, b.clscnt) != 0)
+          error(E_FWRITE, "<tmpfile>"); }
+      else if (out && (as_write(attset, out, k, infout) != 0))
+        error(E_FWRITE, fn_out); /* write tuple to output file */
+    }                           /* (process the batch of tuples) */
+    if (i == 0) i = as_read(attset, in, f);
+  }                             /* try to read the next record */
   if (i < 0) {                  /* if an error occurred, */
     err = as_err(attset);       /* get the error information */
     tplcnt += (inflags & (AS_ATT|AS_DFLT)) ? 1 : 2;
     io_error(i, fn_tab, tplcnt, err->s, err->fld, err->exp);
     error(1);                   /* print an error message */
   }                             /* and abort the program */
-  if (in != stdin) fclose(in);  /* close the table file and */
-  in = NULL;                    /* clear the file variable */
+  ts_detach(as_tabscan(attset));/* release the read buffer */
+  if (in && (in != stdin)) fclose(in);  /* close the table file */
+  in = NULL;                    /* and clear the file variable */
+  if (spl) {                    /* if the tuples have been spooled, */
+    if (k & AS_ATT)             /* write the table header */
+      as_write(attset, out, k, infout);
+    k = AS_INST|(k & ~AS_ATT);  /* and the spooled tuples */
+    if (unspool(spl, out, attset, &res, k, b.clscnt) != 0)
+      error(E_FWRITE, fn_out);  /* (with the final column widths) */
+    fclose(spl); spl = NULL;    /* close (and thus delete) */
+  }                             /* the spool file */
   if (out && (out != stdout)) { /* if an output file exists, */
     i = fclose(out); out = NULL;/* close the output file */
     if (i) error(E_FWRITE, fn_out);
   }                             /* print a sucess message */
-  fprintf(stderr, "[%d/%g tuple(s)] done.\n", tplcnt, tplwgt);
-  if (att_getmark(res.att) >= 0) {
+  if (!serv) fprintf(stderr, "[%d/%g tuple(s)] done.\n",
+                     tplcnt, tplwgt);
+  if (!serv && (att_getmark(res.att) >= 0)) {
     fprintf(stderr, "%g error(s) (%.2f%%)\n", errcnt,
             (tplwgt > 0) ? 100*(errcnt /tplwgt) : 0);
   }                             /* if class found, print errors */
 
   /* --- clean up --- */
   #ifndef NDEBUG
+  for (n = b.size; --n >= 0; )  /* delete the tuples of a batch */
+    tpl_delete(b.tpls[n]);      /* and the result buffers */
+  free(b.tpls); free(b.clss); free(b.confs);
+  if (b.cols)  free(b.cols);    /* delete the column block */
+  if (b.insts) free(b.insts);   /* and the token buffer */
+  if (vmaps) vmdelete(vmaps, nbc_attcnt(nbc));
   if (fbc) fbc_delete(fbc, 1);  /* delete full  Bayes classifier */
   if (nbc) nbc_delete(nbc, 1);  /* or     naive Bayes classifier */
   #endif                        /* and underlying attribute set */
@@ -13,6 +13,11 @@
             2007.02.13 adapted to modified module attset
             2007.03.21 function fbc_exec extended (posterior probs.)
             2007.10.19 bug in fbc_exec fixed (posterior probs.)
+            2026.10.17 reentrant function fbc_exec_r added
+            2026.10.17 copy-on-write cloning (mode FBC_COW) added
+            2026.10.17 function fbc_merge added (sum of statistics)
+            2026.10.17 new classes merged in the order of their occurrence
+            2026.10.17 evaluation buffer per classifier (not per distrib.)
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -81,25 +86,70 @@ static int _clsrsz (FBC *fbc, int clscnt)
 #endif
 /*--------------------------------------------------------------------*/
 
-static void _getvals (FBC *fbc, const TUPLE *tpl)
+static int _mvnown (FBC *fbc, int cls)
+{                               /* --- unshare a class distribution */
+  MVNORM *mvn;                  /* copy of the shared distribution */
+
+  assert(fbc && (cls >= 0) && (cls < fbc->clscnt));
+  if (mvn_refs(fbc->mvns[cls]) <= 1)
+    return 0;                   /* if not shared, abort */
+  mvn = mvn_clone(fbc->mvns[cls]);
+  if (!mvn) return -1;          /* copy the shared distribution */
+  mvn_delete(fbc->mvns[cls]);   /* and release the shared one */
+  fbc->mvns[cls] = mvn;         /* (only decrements its counter) */
+  return 0;                     /* return 'ok' */
+}  /* _mvnown() */
+
+/*--------------------------------------------------------------------*/
+
+static void _getvals (const FBC *fbc, const INST *insts,
+                      double *vals)
 {                               /* --- get the attribute values */
-  int    i;                     /* loop variable */
-  const  INST *inst;            /* to traverse the instances */
-  FBCID  *p;                    /* to traverse the attribute ids. */
-  double *v;                    /* to traverse the att. value vector */
+  int         i;                /* loop variable */
+  const INST  *inst;            /* to traverse the instances */
+  const FBCID *p;               /* to traverse the attribute ids. */
 
-  assert(fbc);                  /* check the function argument */
-  v = fbc->vals +fbc->numcnt;   /* get the attribute value vector */
+  assert(fbc && vals);          /* check the function arguments */
+  vals += fbc->numcnt;          /* get the attribute value vector */
   for (p = fbc->numids +(i = fbc->numcnt); --i >= 0; ) {
     --p;                        /* traverse the numeric attributes */
-    inst = (tpl) ? tpl_colval(tpl, p->id) : att_inst(p->att);
+    inst = (insts) ? insts +p->id : att_inst(p->att);
     if (p->type == AT_REAL)     /* if the attribute is real-valued */
-      *--v = (inst->f <= NV_REAL) ? MVN_NULL : (double)inst->f;
+      *--vals = (inst->f <= NV_REAL) ? MVN_NULL : (double)inst->f;
     else                        /* if the attribute is integer-valued */
-      *--v = (inst->i <= NV_INT)  ? MVN_NULL : (double)inst->i;
+      *--vals = (inst->i <= NV_INT)  ? MVN_NULL : (double)inst->i;
   }                             /* (collect attribute values) */
 }  /* _getvals() */
 
+/*--------------------------------------------------------------------*/
+
+static int _exec (const FBC *fbc, const double *vals,
+                  double *posts, double *buf, double *conf)
+{                               /* --- execute a full Bayes class. */
+  int          i;               /* loop variable */
+  const double *s;              /* to traverse the prior probs. */
+  double       *d, *p;          /* to traverse the posterior probs. */
+  MVNORM       **mvn;           /* to traverse the distributions */
+  double       sum;             /* sum of class probabilities */
+
+  assert(fbc && vals && posts); /* check the function arguments */
+  s = fbc->priors +fbc->clscnt; /* get the prior     distribution */
+  d = posts       +fbc->clscnt; /* and the posterior distribution */
+  for (mvn = fbc->mvns +(i = fbc->clscnt); --i >= 0; ) {
+    --mvn;                      /* traverse the cond. distributions */
+    *--d = *--s * mvn_eval_r(*mvn, vals, buf);
+  }                             /* compute the posterior probability */
+  for (p = d, sum = *p, i = fbc->clscnt; --i > 0; ) {
+    if (*++p > *d) d = p;       /* find the most probable class */
+    sum += *p;                  /* and sum all probabilities */
+  }                             /* (for the later normalization) */
+  sum = (sum > 0) ? 1/sum : 1;  /* compute normalization factor */
+  for (i = fbc->clscnt; --i >= 0; )
+    posts[i] *= sum;            /* normalize probabilities */
+  if (conf) *conf = *d;         /* get the confidence value and */
+  return (int)(d -posts);       /* return the classification result */
+}  /* _exec() */
+
 /*----------------------------------------------------------------------
   Main Functions
 ----------------------------------------------------------------------*/
@@ -134,6 +184,7 @@ FBC* fbc_create (ATTSET *attset, int clsid)
   fbc->frqs   = fbc->priors = fbc->posts = NULL;
   fbc->vals   = NULL;           /* clear pointers for a */
   fbc->mvns   = NULL;           /* proper cleanup on error */
+  fbc->asrefs = NULL;           /* (attribute set is not shared) */
 
   /* --- create the attribute information --- */
   fbc->numids = p = (FBCID*)malloc(fbc->attcnt *sizeof(FBCID));
@@ -145,9 +196,10 @@ FBC* fbc_create (ATTSET *attset, int clsid)
     p->att = att; p++;          /* and note their identifications */
   }                             /* and types */
   fbc->numcnt = (int)(p -fbc->numids);
-  fbc->vals = (double*)malloc(fbc->attcnt *sizeof(double));
+  fbc->vals = (double*)malloc(fbc->attcnt *3 *sizeof(double));
   if (!fbc->vals) { fbc_delete(fbc, 0); return NULL; }
-                                /* create an attribute value buffer */
+  fbc->buf  = fbc->vals +fbc->attcnt;  /* create an attribute value */
+                                /* buffer and an evaluation buffer */
 
   /* --- initialize the distributions --- */
   if (fbc->clscnt > 0) {        /* if there are classes, */
@@ -171,9 +223,10 @@ FBC* fbc_create (ATTSET *attset, int clsid)
 
 /*--------------------------------------------------------------------*/
 
-FBC* fbc_clone (const FBC *fbc, int cloneas)
+FBC* fbc_clone (FBC *fbc, int mode)
 {                               /* --- clone a full Bayes classifier */
   int    i;                     /* loop variable */
+  int    cloneas;               /* whether to clone the att. set */
   FBC    *clone;                /* created classifier clone */
   ATTSET *attset;               /* clone of attribute set */
   double *df; const double *sf; /* to traverse the frequency vectors */
@@ -183,7 +236,13 @@ FBC* fbc_clone (const FBC *fbc, int cloneas)
   assert(fbc);                  /* check the function argument */
 
   /* --- copy the classifier body --- */
-  attset = fbc->attset;         /* get the attribute set */
+  if ((mode & FBC_COW) && (mode & FBC_CLONE) && !fbc->asrefs) {
+    fbc->asrefs = (int*)malloc(sizeof(int));
+    if (!fbc->asrefs) return NULL;
+    *fbc->asrefs = 1;           /* create a reference counter */
+  }                             /* for a shared attribute set */
+  cloneas = (mode & FBC_CLONE) && !(mode & FBC_COW);
+  attset  = fbc->attset;        /* get the attribute set */
   if (cloneas) {                /* if the corresp. flag is set, */
     attset = as_clone(attset);  /* clone the attribute set */
     if (!attset) return NULL;   /* of the original classifier, */
@@ -203,6 +262,7 @@ FBC* fbc_clone (const FBC *fbc, int cloneas)
   clone->frqs   = clone->priors = clone->posts = NULL;
   clone->vals   = NULL;         /* clear pointers for a */
   clone->mvns   = NULL;         /* proper cleanup on error */
+  clone->asrefs = NULL;         /* (attribute set is not shared yet) */
 
   /* --- copy the attribute information --- */
   clone->numids = di = (FBCID*)malloc(clone->attcnt *sizeof(FBCID));
@@ -210,9 +270,13 @@ FBC* fbc_clone (const FBC *fbc, int cloneas)
   si = fbc->numids +clone->numcnt;
   for (di += i = clone->numcnt; --i >= 0; )
     *--di = *--si;              /* copy the attribute identifications */
-  clone->vals = (double*)malloc(clone->attcnt *sizeof(double));
+  clone->vals = (double*)malloc(clone->attcnt *3 *sizeof(double));
   if (!clone->vals) { fbc_delete(clone, cloneas); return NULL; }
+  clone->buf  = clone->vals +clone->attcnt;
                                 /* create an attribute value buffer */
+                                /* and an evaluation buffer (the */
+                                /* buffers of the distributions must */
+                                /* not be used, as they are shared) */
 
   /* --- copy the distributions --- */
   if (clone->clscnt > 0) {      /* if there are classes, */
@@ -228,13 +292,16 @@ FBC* fbc_clone (const FBC *fbc, int cloneas)
     mvn = (MVNORM**)calloc(clone->clscnt, sizeof(MVNORM*));
     if (!mvn) { fbc_delete(clone, cloneas); return NULL; }
     for (mvn += i = clone->clscnt; --i >= 0; ) {
+      if (mode & FBC_COW) {     /* if to share the distributions, */
+        *--mvn = mvn_share(fbc->mvns[i]); continue; }
       *--mvn = mvn_clone(fbc->mvns[i]);
       if (!*mvn) { fbc_delete(clone, cloneas); return NULL; }
-    }                           /* copy all multivariate */
-  }                             /* normal distributions */
-
-  return clone;                 /* return the created clone */
-}  /* fbc_clone() */
+    }                           /* share or copy all */
+  }                             /* multivariate normal distributions */
+  if ((mode & FBC_COW) && (mode & FBC_CLONE))
+    rc_inc(clone->asrefs = fbc->asrefs);
+  return clone;                 /* reference the attribute set and */
+}  /* fbc_clone() */            /* return the created clone */
 
 /*--------------------------------------------------------------------*/
 
@@ -252,23 +319,35 @@ void fbc_delete (FBC *fbc, int delas)
   if (fbc->frqs)   free(fbc->frqs);
   if (fbc->vals)   free(fbc->vals);
   if (fbc->numids) free(fbc->numids);
+  if (fbc->asrefs) {            /* if the attribute set is shared, */
+    if (rc_dec(fbc->asrefs) > 0)/* delete it only with */
+      delas = 0;                /* the last classifier */
+    else free(fbc->asrefs);     /* that references it */
+  }
   if (delas)       as_delete(fbc->attset);
   free(fbc);                    /* delete the classifier body */
 }  /* fbc_delete() */
 
 /*--------------------------------------------------------------------*/
 
-void fbc_clear (FBC *fbc)
+int fbc_clear (FBC *fbc)
 {                               /* --- clear a full Bayes classifier */
   int    i;                     /* loop variables */
   double *frq;                  /* to traverse the frequency vectors */
+  MVNORM *mvn;                  /* new (unshared) distribution */
 
   assert(fbc);                  /* check the function argument */
   fbc->total = 0;               /* clear the total number of cases */
   for (frq = fbc->frqs +(i = fbc->clscnt); --i >= 0; ) {
     *--frq = 0;                 /* clear the frequency distribution */
-    mvn_clear(fbc->mvns[i]);    /* and the multivariate normal */
-  }                             /* distributions */
+    if (mvn_refs(fbc->mvns[i]) <= 1) {
+      mvn_clear(fbc->mvns[i]); continue; }
+    mvn = mvn_create(fbc->numcnt);
+    if (!mvn) return -1;        /* replace a shared distribution */
+    mvn_delete(fbc->mvns[i]);   /* by a new (empty) one */
+    fbc->mvns[i] = mvn;         /* (no need to copy the old one), */
+  }                             /* otherwise clear the multivariate */
+  return 0;                     /* normal distribution */
 }  /* fbc_clear() */
 
 /*--------------------------------------------------------------------*/
@@ -300,7 +379,9 @@ int fbc_add (FBC *fbc, const TUPLE *tpl)
   fbc->total     += wgt;        /* and the total frequency */
 
   /* --- update the conditional distributions --- */
-  _getvals(fbc, tpl);           /* get the attribute value vector */
+  if (_mvnown(fbc, cls) != 0)   /* unshare the distribution */
+    return -1;                  /* of the class (if necessary) */
+  _getvals(fbc, (tpl) ? tpl_colval(tpl, 0) : NULL, fbc->vals);
   mvn_add(fbc->mvns[cls], fbc->vals, wgt);
   return 0;                     /* add inst. to the cond. distrib. */
 }  /* fbc_add() */              /* return 'ok' */
@@ -329,7 +410,8 @@ FBC* fbc_induce (TABLE *table, int clsid, int mode, double lcorr)
   /* --- build the classifier --- */
   for (i = tab_tplcnt(table); --i >= 0; )
     fbc_add(fbc, tab_tpl(table, i));        /* add all tuples */
-  fbc_setup(fbc, mode, lcorr);   /* and set up the classifier */
+  if (fbc_setup(fbc, mode, lcorr) != 0) { /* and set up the */
+    fbc_delete(fbc, mode & FBC_CLONE); return NULL; }  /* classifier */
 
   return fbc;                    /* return the created classifier */
 }  /* fbc_induce() */
@@ -350,10 +432,68 @@ int fbc_mark (FBC *fbc)
   return fbc->numcnt +1;        /* mark the class attribute and */
 }  /* fbc_mark() */             /* return the number of marked atts. */
 
+/*--------------------------------------------------------------------*/
+
+int fbc_merge (FBC *dst, const FBC *src)
+{                               /* --- merge two full Bayes class. */
+  int       i, k, n;            /* loop variables, buffer */
+  int       *map;               /* map of numeric attributes */
+  int       *cls;               /* map of class values */
+  ATT       *att;               /* class attribute of destination */
+  const ATT *sa;                /* class attribute of source */
+  MVNORM    **mvn;              /* to traverse the distributions */
+
+  assert(dst && src);           /* check the function arguments */
+  att = as_att(dst->attset, dst->clsid);
+  sa  = as_att(src->attset, src->clsid);
+  if ((strcmp(att_name(att), att_name(sa)) != 0)
+  ||  (src->numcnt != dst->numcnt))
+    return -2;                  /* check class and numeric atts. */
+  map = (int*)malloc((src->numcnt +src->clscnt +1) *sizeof(int));
+  if (!map) return -1;          /* create the identifier maps */
+  cls = map +src->numcnt;       /* (numeric attributes, classes) */
+
+  /* --- map the numeric attributes --- */
+  for (i = src->numcnt; --i >= 0; ) {
+    n = as_attid(dst->attset, att_name(src->numids[i].att));
+    for (k = dst->numcnt; --k >= 0; )
+      if (dst->numids[k].id == n) break;
+    if ((k < 0) || (dst->numids[k].type != src->numids[i].type)) {
+      free(map); return -2; }   /* find the corresponding numeric */
+    map[i] = k;                 /* attribute of the destination */
+    att_valcopy(dst->numids[k].att, src->numids[i].att, 0);
+  }                             /* and extend its range of values */
+
+  /* --- map the classes --- */
+  for (n = i = 0; i < src->clscnt; i++) {
+    if (att_valadd(att, att_valname(sa, i), NULL) < 0) {
+      free(map); return -1; }   /* add the class to the destination */
+    cls[i] = att_inst(att)->i;  /* class attribute (if it is new) */
+    if (cls[i] >= n) n = cls[i]+1;  /* and note its identifier */
+  }
+  if ((n > dst->clscnt)         /* resize the class dependent vectors */
+  &&  (_clsrsz(dst, n) != 0)) { /* if there are new classes */
+    free(map); return -1; }
+
+  /* --- merge the distributions --- */
+  for (mvn = src->mvns +(i = src->clscnt); --i >= 0; ) {
+    --mvn; k = cls[i];          /* traverse the source classes */
+    if (src->frqs[i] <= 0)      /* skip empty classes (a parsed */
+      continue;                 /* distribution has >= 2 cases) */
+    dst->frqs[k] += src->frqs[i];
+    dst->total   += src->frqs[i];
+    if (_mvnown(dst, k) != 0) { /* add the class frequency and */
+      free(map); return -1; }   /* unshare the distribution */
+    mvn_merge(dst->mvns[k], *mvn, map);
+  }                             /* add the sums of the source */
+  free(map);                    /* delete the identifier maps */
+  return 0;                     /* return 'ok' */
+}  /* fbc_merge() */
+
 #endif
 /*--------------------------------------------------------------------*/
 
-void fbc_setup (FBC *fbc, int mode, double lcorr)
+int fbc_setup (FBC *fbc, int mode, double lcorr)
 {                               /* --- set up a full Bayes classifier */
   int    i, n;                  /* loop variables */
   double cnt;                   /* number of cases, sum of priors */
@@ -377,37 +517,61 @@ void fbc_setup (FBC *fbc, int mode, double lcorr)
 
   /* --- estimate conditional probabilities --- */
   mode |= MVN_EXPVAR|MVN_COVAR|MVN_INVERSE|MVN_DECOM;
-  for (mvn = fbc->mvns +(i = fbc->clscnt); --i >= 0; )
+  for (mvn = fbc->mvns +(i = fbc->clscnt); --i >= 0; ) {
+    if (_mvnown(fbc, i) != 0)   /* unshare the distribution */
+      return -1;                /* (if necessary) */
     mvn_calc(*--mvn, mode);     /* calculate all parameters */
+  }
+  return 0;                     /* return 'ok' */
 }  /* fbc_setup() */
 
 /*--------------------------------------------------------------------*/
 
 int fbc_exec (FBC *fbc, const TUPLE *tpl, double *conf)
 {                               /* --- execute a full Bayes class. */
-  int    i;                     /* loop variable */
-  double *s, *d;                /* to traverse the probabilities */
-  MVNORM **mvn;                 /* to traverse the distributions */
-  double sum;                   /* sum of class probabilities */
+  assert(fbc);                  /* check the function argument */
+  _getvals(fbc, (tpl) ? tpl_colval(tpl, 0) : NULL, fbc->vals);
+  return _exec(fbc, fbc->vals, fbc->posts, fbc->buf, conf);
+}  /* fbc_exec() */             /* get values and execute classifier */
+
+/*--------------------------------------------------------------------*/
+
+FBCWS* fbc_wscreate (const FBC *fbc)
+{                               /* --- create an execution workspace */
+  FBCWS *ws;                    /* created workspace */
 
   assert(fbc);                  /* check the function argument */
-  _getvals(fbc, tpl);           /* get the attribute value vector */
-  s = fbc->priors +fbc->clscnt; /* get the prior     distribution */
-  d = fbc->posts  +fbc->clscnt; /* and the posterior distribution */
-  for (mvn = fbc->mvns +(i = fbc->clscnt); --i >= 0; ) {
-    --mvn;                      /* traverse the cond. distributions */
-    *--d = *--s * mvn_eval(*mvn, fbc->vals);
-  }                             /* compute the posterior probability */
-  for (s = d, sum = *s, i = fbc->clscnt; --i > 0; ) {
-    if (*++s > *d) d = s;       /* find the most probable class */
-    sum += *s;                  /* and sum all probabilities */
-  }                             /* (for the later normalization) */
-  sum = (sum > 0) ? 1/sum : 1;  /* compute normalization factor */
-  for (i = fbc->clscnt; --i >= 0; )
-    fbc->posts[i] *= sum;       /* normalize probabilities */
-  if (conf) *conf = *d;         /* get the confidence value and */
-  return (int)(d -fbc->posts);  /* return the classification result */
-}  /* fbc_exec() */
+  ws = (FBCWS*)malloc(sizeof(FBCWS));
+  if (!ws) return NULL;         /* create the workspace body */
+  ws->clscnt = (fbc->clscnt > 0) ? fbc->clscnt : 1;
+  ws->numcnt = (fbc->numcnt > 0) ? fbc->numcnt : 1;
+  ws->posts  = (double*)malloc((ws->clscnt +3 *ws->numcnt)
+                              *sizeof(double));
+  if (!ws->posts) { free(ws); return NULL; }
+  ws->vals   = ws->posts +ws->clscnt;
+  ws->buf    = ws->vals  +ws->numcnt;
+  return ws;                    /* organize the allocated vector */
+}  /* fbc_wscreate() */         /* and return the workspace */
+
+/*--------------------------------------------------------------------*/
+
+void fbc_wsdelete (FBCWS *ws)
+{                               /* --- delete an execution workspace */
+  assert(ws);                   /* check the function argument */
+  free(ws->posts);              /* delete the vectors */
+  free(ws);                     /* and the workspace body */
+}  /* fbc_wsdelete() */
+
+/*--------------------------------------------------------------------*/
+
+int fbc_exec_r (const FBC *fbc, FBCWS *ws, const INST *insts,
+                double *conf)
+{                               /* --- execute a full Bayes class. */
+  assert(fbc && ws && insts     /* check the function arguments */
+      && (ws->clscnt >= fbc->clscnt) && (ws->numcnt >= fbc->numcnt));
+  _getvals(fbc, insts, ws->vals);
+  return _exec(fbc, ws->vals, ws->posts, ws->buf, conf);
+}  /* fbc_exec_r() */           /* get values and execute classifier */
 
 /*--------------------------------------------------------------------*/
 
@@ -424,7 +588,7 @@ double* fbc_rand (FBC *fbc, double drand (void))
   if (i >= fbc->clscnt)         /* find the class that corresponds */
     i = fbc->clscnt -1;         /* to the generated random number */
   att_inst(as_att(fbc->attset, fbc->clsid))->i = i;
-  p = mvn_rand(fbc->mvns[i], drand);   /* generate a random point */
+  p = mvn_rand_r(fbc->mvns[i], drand, fbc->buf);  /* gen. a point */
   for (q = fbc->numids +(i = fbc->numcnt); --i >= 0; ) {
     --q; att_inst(q->att)->f = (float)p[i]; }
   return p;                     /* copy the point to the att. set */
@@ -734,7 +898,8 @@ FBC* fbc_parse (ATTSET *attset, SCAN *scan)
     if (fbc) fbc_delete(fbc,0); /* parse a full Bayes classifier */
     return NULL;                /* if an error occurred, */
   }                             /* delete the classifier and abort */
-  fbc_setup(fbc, fbc->mode, fbc->lcorr);
+  if (fbc_setup(fbc, fbc->mode, fbc->lcorr) != 0) {
+    fbc_delete(fbc, 0); return NULL; }
   return fbc;                   /* set up the created classifier */
 }  /* fbc_parse() */            /* and then return it */
 
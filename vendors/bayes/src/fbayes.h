@@ -8,6 +8,10 @@
             2003.04.26 function fbc_rand added
             2004.08.12 adapted to new module parse
             2007.03.21 function fbc_post added (posterior prob.)
+            2026.10.17 execution workspace and function fbc_exec_r added
+            2026.10.17 copy-on-write cloning (mode FBC_COW) added
+            2026.10.17 function fbc_merge added
+            2026.10.17 evaluation buffer per classifier (not per distrib.)
 ----------------------------------------------------------------------*/
 #ifndef __FBAYES__
 #define __FBAYES__
@@ -31,6 +35,10 @@
 /* --- setup/induction modes --- */
 #define FBC_MAXLLH  0x0080      /* use max. likelihood est. of var. */
 
+/* --- clone modes --- */
+/*      FBC_CLONE   0x0001         clone attribute set (see above) */
+#define FBC_COW     0x0100      /* share distributions (copy on write) */
+
 /* --- description modes --- */
 #define FBC_TITLE   0x0001      /* print a title (as a comment) */
 #define FBC_REL     0x0002      /* print relative numbers */
@@ -59,17 +67,27 @@ typedef struct {                /* --- full Bayes classifier --- */
   double *priors;               /* prior     class probabilities */
   double *posts;                /* posterior class probabilities */
   double *vals;                 /* vector of attribute values */
+  double *buf;                  /* buffer for density evaluation */
   MVNORM **mvns;                /* multivariate normal distributions */
+  int    *asrefs;               /* reference counter of att. set */
   int    flags[1];              /* attribute flags */
 } FBC;                          /* (full Bayes classifier) */
 
+typedef struct {                /* --- execution workspace --- */
+  int    clscnt;                /* number of classes */
+  int    numcnt;                /* number of numeric attributes */
+  double *posts;                /* posterior class probabilities */
+  double *vals;                 /* vector of attribute values */
+  double *buf;                  /* buffer for density evaluation */
+} FBCWS;                        /* (full Bayes execution workspace) */
+
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
 extern FBC*    fbc_create (ATTSET *attset, int clsid);
-extern FBC*    fbc_clone  (const FBC *fbc, int cloneas);
+extern FBC*    fbc_clone  (FBC *fbc, int mode);
 extern void    fbc_delete (FBC *fbc, int delas);
-extern void    fbc_clear  (FBC *fbc);
+extern int     fbc_clear  (FBC *fbc);
 
 extern ATTSET* fbc_attset (const FBC *fbc);
 extern int     fbc_attcnt (const FBC *fbc);
@@ -83,9 +101,10 @@ extern int     fbc_add    (FBC *fbc, const TUPLE *tpl);
 extern FBC*    fbc_induce (TABLE *table, int clsid,
                            int mode, double lcorr);
 extern int     fbc_mark   (FBC *fbc);
+extern int     fbc_merge  (FBC *dst, const FBC *src);
 #endif
 
-extern void    fbc_setup  (FBC *fbc, int mode, double lcorr);
+extern int     fbc_setup  (FBC *fbc, int mode, double lcorr);
 extern double  fbc_lcorr  (const FBC *fbc);
 extern int     fbc_mode   (const FBC *fbc);
 
@@ -93,6 +112,11 @@ extern double  fbc_prior  (const FBC *fbc, int clsid);
 extern MVNORM* fbc_mvnorm (FBC *fbc, int clsid);
 extern double  fbc_post   (const FBC *fbc, int clsid);
 extern int     fbc_exec   (FBC *fbc, const TUPLE *tpl, double *conf);
+extern FBCWS*  fbc_wscreate (const FBC *fbc);
+extern void    fbc_wsdelete (FBCWS *ws);
+extern int     fbc_exec_r (const FBC *fbc, FBCWS *ws,
+                           const INST *insts, double *conf);
+extern double  fbc_wspost (const FBCWS *ws, int clsid);
 extern double* fbc_rand   (FBC *fbc, double drand (void));
 
 extern int     fbc_desc   (FBC *fbc, FILE *file, int mode, int maxlen);
@@ -116,5 +140,6 @@ extern FBC*    fbc_parse  (ATTSET *attset, SCAN *scan);
 #define fbc_prior(b,c)      ((b)->priors[c])
 #define fbc_mvnorm(b,c)     ((b)->mvns[c])
 #define fbc_post(b,c)       ((b)->posts[c])
+#define fbc_wspost(w,c)     ((w)->posts[c])
 
 #endif
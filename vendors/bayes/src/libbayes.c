@@ -0,0 +1,432 @@
+/*----------------------------------------------------------------------
+  File    : libbayes.c
+  Contents: embeddable Bayes classifier library (opaque handles)
+  Author  : agent
+  History : 2026.10.17 file created
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+#include <assert.h>
+#ifndef SC_SCAN
+#define SC_SCAN
+#endif
+#include "scan.h"
+#ifndef AS_RDWR
+#define AS_RDWR
+#endif
+#ifndef AS_PARSE
+#define AS_PARSE
+#endif
+#include "attset.h"
+#ifndef NBC_INDUCE
+#define NBC_INDUCE
+#endif
+#ifndef NBC_PARSE
+#define NBC_PARSE
+#endif
+#include "nbayes.h"
+#ifndef FBC_INDUCE
+#define FBC_INDUCE
+#endif
+#ifndef FBC_PARSE
+#define FBC_PARSE
+#endif
+#include "fbayes.h"
+#include "libbayes.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  The library wraps the classifier modules behind two opaque handles:
+  a model (attribute set and naive or full Bayes classifier) and an
+  execution workspace. There is no process-global state: a model is
+  modified only by bc_add and bc_setup, while bc_exec reads it only,
+  so any number of threads may classify with the same model as long
+  as each of them uses its own workspace.
+----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+struct bcmodel {                /* --- classifier model --- */
+  ATTSET *attset;               /* attribute set of the classifier */
+  NBC    *nbc;                  /* naive Bayes classifier or */
+  FBC    *fbc;                  /* full  Bayes classifier */
+  int    clsid;                 /* identifier of class attribute */
+};
+
+struct bcwork {                 /* --- execution workspace --- */
+  int    attcnt;                /* number of attributes */
+  int    clscnt;                /* number of classes */
+  INST   *insts;                /* buffer for the instances */
+  NBCWS  *nws;                  /* naive Bayes workspace or */
+  FBCWS  *fws;                  /* full  Bayes workspace */
+};
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static BCMODEL* _error (BCMODEL *model, int *err, int code)
+{                               /* --- clean up after an error */
+  if (model) bc_delete(model);  /* delete the partial model */
+  if (err)   *err = code;       /* store the error code */
+  return NULL;                  /* and return 'failure' */
+}  /* _error() */
+
+/*--------------------------------------------------------------------*/
+
+static void _null (ATT *att, INST *inst)
+{                               /* --- set a null value */
+  switch (att_type(att)) {      /* evaluate the attribute type */
+    case AT_NOM: inst->i = NV_NOM;  break;
+    case AT_INT: inst->i = NV_INT;  break;
+    default    : inst->f = NV_REAL; break;
+  }                             /* set the null value */
+}  /* _null() */                /* of the attribute type */
+
+/*--------------------------------------------------------------------*/
+
+static int _number (ATT *att, const char *s, INST *inst)
+{                               /* --- convert a numeric value */
+  long   i;                     /* buffer for an integer value */
+  double f;                     /* buffer for a real     value */
+  char   *e;                    /* end pointer for conversion */
+
+  if (att_type(att) == AT_INT){ /* if the attribute is integer */
+    i = strtol(s, &e, 10);      /* convert the value */
+    if ((e == s) || *e || (i <= NV_INT) || (i > INT_MAX))
+      return BC_EVALUE;         /* check for a valid integer */
+    inst->i = (int)i; }         /* store the integer value */
+  else {                        /* if the attribute is real-valued */
+    f = strtod(s, &e);          /* convert the value */
+    if ((e == s) || *e || (f <= NV_REAL) || (f > FLT_MAX))
+      return BC_EVALUE;         /* check for a valid real number */
+    inst->f = (float)f;         /* store the real value */
+  }
+  return 0;                     /* return 'ok' */
+}  /* _number() */
+
+/*----------------------------------------------------------------------
+  Model Functions
+----------------------------------------------------------------------*/
+
+BCMODEL* bc_create (const char *domfile, const char *clsname,
+                    int type, int *err)
+{                               /* --- create a classifier */
+  int     i, k;                 /* loop variables, buffers */
+  int     attcnt;               /* number of attributes */
+  BCMODEL *model;               /* created classifier model */
+  SCAN    *scan;                /* scanner for the domain file */
+  ATT     *att;                 /* to traverse the attributes */
+
+  assert(domfile);              /* check the function arguments */
+  model = (BCMODEL*)calloc(1, sizeof(BCMODEL));
+  if (!model) return _error(NULL, err, BC_ENOMEM);
+  model->attset = as_create("domains", att_delete);
+  if (!model->attset) return _error(model, err, BC_ENOMEM);
+
+  /* --- read the attribute domains --- */
+  scan = sc_create(domfile);    /* create a scanner */
+  if (!scan) return _error(model, err, (*domfile) ? BC_EFOPEN:BC_ENOMEM);
+  k = (sc_nexter(scan)   <  0)  /* start scanning (get first token) */
+   || (as_parse(model->attset, scan, AT_ALL) != 0)
+   || (as_attcnt(model->attset) <= 0)
+   || !sc_eof(scan);            /* parse the attribute set and */
+  sc_delete(scan);              /* check for end of file */
+  if (k) return _error(model, err, BC_EPARSE);
+
+  /* --- filter attributes --- */
+  attcnt = as_attcnt(model->attset);
+  for (i = attcnt; --i >= 0; ) {
+    att = as_att(model->attset, i);
+    k   = att_getdir(att);      /* traverse the attributes */
+    att_setmark(att, ((k == DIR_IN) || (k == DIR_OUT)) ? -1 : +1);
+  }                             /* mark input and output attributes */
+  as_attcut(NULL, model->attset, AS_MARKED);
+  attcnt = as_attcnt(model->attset);
+  for (i = attcnt; --i >= 0; )  /* cut all other attributes and */
+    att_setmark(as_att(model->attset, i), 0);  /* clear the markers */
+  if (attcnt <= 0) return _error(model, err, BC_ECLASS);
+
+  /* --- determine the class attribute --- */
+  if (clsname) {                /* if a class att. name is given */
+    for (i = attcnt; --i >= 0;) /* remove all attribute directions */
+      att_setdir(as_att(model->attset, i), DIR_IN);
+    model->clsid = as_attid(model->attset, clsname); }
+  else {                        /* if no class att. name is given */
+    for (model->clsid = -1, i = attcnt; --i >= 0; ) {
+      if (att_getdir(as_att(model->attset, i)) != DIR_OUT) continue;
+      if (model->clsid >= 0) return _error(model, err, BC_ECLASS);
+      model->clsid = i;         /* find a (unique) output attribute */
+    }                           /* (by default use the last one) */
+    if (model->clsid < 0) model->clsid = attcnt -1;
+  }
+  if (model->clsid < 0) return _error(model, err, BC_ECLASS);
+  att = as_att(model->attset, model->clsid);
+  att_setdir(att, DIR_OUT);     /* set the class attribute direction */
+  if (att_type(att) != AT_NOM)  /* and check its type */
+    return _error(model, err, BC_ECLASS);
+
+  /* --- create the classifier --- */
+  if (type == BC_FULL) model->fbc = fbc_create(model->attset,
+                                               model->clsid);
+  else                 model->nbc = nbc_create(model->attset,
+                                               model->clsid);
+  if (!model->fbc && !model->nbc) return _error(model, err, BC_ENOMEM);
+  if (err) *err = BC_OK;        /* create a naive/full classifier */
+  return model;                 /* and return the created model */
+}  /* bc_create() */
+
+/*--------------------------------------------------------------------*/
+
+BCMODEL* bc_load (const char *fname, int *err)
+{                               /* --- load a classifier */
+  int     k;                    /* result of parsing */
+  BCMODEL *model;               /* loaded classifier model */
+  SCAN    *scan;                /* scanner for the model file */
+
+  assert(fname);                /* check the function arguments */
+  model = (BCMODEL*)calloc(1, sizeof(BCMODEL));
+  if (!model) return _error(NULL, err, BC_ENOMEM);
+  if (*fname && nbc_isbin(fname)) {
+    model->nbc = nbc_load(fname, 0);  /* map a binary class. file */
+    if (!model->nbc) return _error(model, err, BC_EPARSE);
+    model->attset = nbc_attset(model->nbc); }
+  else {                        /* if to parse a description */
+    scan = sc_create(fname);    /* create a scanner */
+    if (!scan) return _error(model, err, (*fname) ? BC_EFOPEN:BC_ENOMEM);
+    model->attset = as_create("domains", att_delete);
+    if (!model->attset) { sc_delete(scan);
+      return _error(model, err, BC_ENOMEM); }
+    if ((sc_nexter(scan)   >= 0)/* start scanning (get first token) */
+    &&  (as_parse(model->attset, scan, AT_ALL) == 0)
+    &&  (as_attcnt(model->attset) > 0)) {  /* parse attribute set */
+      if ((sc_token(scan) == T_ID)         /* and the classifier */
+      &&  (strcmp(sc_value(scan), "fbc") == 0))
+           model->fbc = fbc_parse(model->attset, scan);
+      else model->nbc = nbc_parse(model->attset, scan);
+    }                           /* (determine classifier type) */
+    k = (!model->fbc && !model->nbc) || !sc_eof(scan);
+    sc_delete(scan);            /* check the classifier */
+    if (k) return _error(model, err, BC_EPARSE);
+  }                             /* and for end of file */
+  if (model->nbc) {             /* if naive Bayes classifier */
+    if (nbc_bktcnt(model->nbc) > 0)     /* hashed token attributes */
+      return _error(model, err, BC_EMODEL);  /* cannot be given */
+    if (!nbc_compiled(model->nbc) /* as a value vector */
+    &&  (nbc_compile(model->nbc) != 0)) /* compile an execution */
+      return _error(model, err, BC_ENOMEM);   /* plan (if needed) */
+    model->clsid = nbc_clsid(model->nbc); }
+  else                          /* get the class attribute id */
+    model->clsid = fbc_clsid(model->fbc);
+  if (err) *err = BC_OK;        /* set the error code */
+  return model;                 /* and return the loaded model */
+}  /* bc_load() */
+
+/*--------------------------------------------------------------------*/
+
+void bc_delete (BCMODEL *model)
+{                               /* --- delete a classifier */
+  assert(model);                /* check the function argument */
+  if      (model->nbc) nbc_delete(model->nbc, 1);
+  else if (model->fbc) fbc_delete(model->fbc, 1);
+  else if (model->attset) as_delete(model->attset);
+  free(model);                  /* delete the classifier, */
+}  /* bc_delete() */            /* the att. set, and the model body */
+
+/*--------------------------------------------------------------------*/
+
+int bc_save (const BCMODEL *model, const char *fname, int mode)
+{                               /* --- save a classifier */
+  int  r;                       /* result of writing */
+  FILE *out;                    /* output file */
+
+  assert(model && fname);       /* check the function arguments */
+  if (mode == BC_BINARY) {      /* if to write a binary file */
+    if (!model->nbc) return BC_EMODEL;
+    out = fopen(fname, "wb");   /* open the output file */
+    if (!out) return BC_EFOPEN; /* and write the classifier */
+    r = nbc_save(model->nbc, out, 0);
+    if (r == -2) { fclose(out); return BC_EMODEL; } }
+  else {                        /* if to write a description */
+    if (model->nbc && nbc_binary(model->nbc))
+      return BC_EMODEL;         /* (binary files lack value names) */
+    out = fopen(fname, "w");    /* open the output file */
+    if (!out) return BC_EFOPEN; /* and describe the domains */
+    r = as_desc(model->attset, out, AS_TITLE|AS_IVALS, 0);
+    if (r == 0) {               /* leave one line empty and */
+      fputc('\n', out);         /* describe the classifier */
+      r = (model->fbc) ? fbc_desc(model->fbc, out, FBC_TITLE, 0)
+        :                nbc_desc(model->nbc, out, NBC_TITLE, 0);
+    }
+  }
+  if (fclose(out) != 0) r = -1; /* close the output file */
+  return (r != 0) ? BC_EFWRITE : BC_OK;
+}  /* bc_save() */              /* return an error indicator */
+
+/*--------------------------------------------------------------------*/
+
+int bc_type (const BCMODEL *model)
+{ return (model->fbc) ? BC_FULL : BC_NAIVE; }
+
+/*--------------------------------------------------------------------*/
+
+int bc_attcnt (const BCMODEL *model)
+{ return as_attcnt(model->attset); }
+
+/*--------------------------------------------------------------------*/
+
+const char* bc_attname (const BCMODEL *model, int attid)
+{                               /* --- get the name of an attribute */
+  assert(model && (attid >= 0) && (attid < as_attcnt(model->attset)));
+  return att_name(as_att(model->attset, attid));
+}  /* bc_attname() */
+
+/*--------------------------------------------------------------------*/
+
+int bc_attid (const BCMODEL *model, const char *name)
+{ return as_attid(model->attset, name); }
+
+/*--------------------------------------------------------------------*/
+
+int bc_clsid (const BCMODEL *model)
+{ return model->clsid; }
+
+/*--------------------------------------------------------------------*/
+
+int bc_clscnt (const BCMODEL *model)
+{ return (model->fbc) ? fbc_clscnt(model->fbc) : nbc_clscnt(model->nbc); }
+
+/*--------------------------------------------------------------------*/
+
+const char* bc_clsname (const BCMODEL *model, int cls)
+{                               /* --- get the name of a class */
+  ATT *att;                     /* class attribute */
+
+  assert(model);                /* check the function argument */
+  att = as_att(model->attset, model->clsid);
+  return ((cls >= 0) && (cls < att_valcnt(att)))
+       ? att_valname(att, cls) : NULL;
+}  /* bc_clsname() */           /* return the class value name */
+
+/*----------------------------------------------------------------------
+  Training Functions
+----------------------------------------------------------------------*/
+
+int bc_add (BCMODEL *model, const char *const *vals, double wgt)
+{                               /* --- add a training case */
+  int  i, r;                    /* loop variable, result buffer */
+  ATT  *att;                    /* to traverse the attributes */
+
+  assert(model && vals && (wgt >= 0));
+  if (model->nbc                /* classifiers from binary files */
+  && (nbc_binary(model->nbc) || nbc_quant(model->nbc)))
+    return BC_EMODEL;           /* cannot be trained further */
+  for (i = as_attcnt(model->attset); --i >= 0; ) {
+    att = as_att(model->attset, i);    /* traverse the attributes */
+    if (!vals[i] || !*vals[i]) {/* if the value is missing, */
+      _null(att, att_inst(att)); continue; }      /* set a null value */
+    r = att_valadd(att, vals[i], NULL);
+    if (r == -1) return BC_ENOMEM;   /* add the value to the domain */
+    if (r <  -1) return BC_EVALUE;   /* and check for an error */
+  }
+  as_setwgt(model->attset, (float)wgt);
+  r = (model->fbc) ? fbc_add(model->fbc, NULL)
+    :                nbc_add(model->nbc, NULL);
+  return (r != 0) ? BC_ENOMEM : BC_OK;
+}  /* bc_add() */               /* add the case to the classifier */
+
+/*--------------------------------------------------------------------*/
+
+int bc_setup (BCMODEL *model, int mode, double lcorr)
+{                               /* --- set up a classifier */
+  assert(model);                /* check the function argument */
+  mode &= BC_DWNULL|BC_MAXLLH;  /* (only estimation flags) */
+  if (model->fbc)               /* if full Bayes classifier */
+    return (fbc_setup(model->fbc, mode, lcorr) != 0)
+         ? BC_ENOMEM : BC_OK;
+  if (nbc_binary(model->nbc) || nbc_quant(model->nbc))
+    return BC_EMODEL;           /* check for distributions */
+  if (nbc_setup(model->nbc, mode|NBC_ALL, lcorr) != 0)
+    return BC_ENOMEM;           /* estimate the parameters */
+  return (nbc_compile(model->nbc) != 0) ? BC_ENOMEM : BC_OK;
+}  /* bc_setup() */             /* compile an execution plan */
+
+/*----------------------------------------------------------------------
+  Classification Functions
+----------------------------------------------------------------------*/
+
+BCWORK* bc_wscreate (const BCMODEL *model)
+{                               /* --- create an execution workspace */
+  BCWORK *ws;                   /* created workspace */
+
+  assert(model);                /* check the function argument */
+  ws = (BCWORK*)calloc(1, sizeof(BCWORK));
+  if (!ws) return NULL;         /* create the workspace body */
+  ws->attcnt = as_attcnt(model->attset);
+  ws->clscnt = bc_clscnt(model);
+  ws->insts  = (INST*)malloc(ws->attcnt *sizeof(INST));
+  if (model->fbc) ws->fws = fbc_wscreate(model->fbc);
+  else            ws->nws = nbc_wscreate(model->nbc);
+  if (!ws->insts || (!ws->fws && !ws->nws)) {
+    bc_wsdelete(ws); return NULL; }
+  return ws;                    /* create the instance buffer and */
+}  /* bc_wscreate() */          /* the classifier's workspace */
+
+/*--------------------------------------------------------------------*/
+
+void bc_wsdelete (BCWORK *ws)
+{                               /* --- delete an execution workspace */
+  assert(ws);                   /* check the function argument */
+  if (ws->nws)   nbc_wsdelete(ws->nws);
+  if (ws->fws)   fbc_wsdelete(ws->fws);
+  if (ws->insts) free(ws->insts);
+  free(ws);                     /* delete the workspaces, */
+}  /* bc_wsdelete() */          /* the buffer, and the body */
+
+/*--------------------------------------------------------------------*/
+
+int bc_exec (const BCMODEL *model, BCWORK *ws,
+             const char *const *vals, double *conf)
+{                               /* --- classify a case */
+  int  i, k;                    /* loop variable, value identifier */
+  int  attcnt;                  /* number of attributes */
+  ATT  *att;                    /* to traverse the attributes */
+  INST *inst;                   /* to traverse the instances */
+
+  assert(model && ws && vals);  /* check the function arguments */
+  attcnt = as_attcnt(model->attset);
+  if ((ws->attcnt <  attcnt)
+  ||  (ws->clscnt <  bc_clscnt(model))
+  ||  (model->fbc && !ws->fws) || (model->nbc && !ws->nws))
+    return BC_EMODEL;           /* check the workspace */
+  for (i = attcnt; --i >= 0; ) {
+    att  = as_att(model->attset, i);
+    inst = ws->insts +i;        /* traverse the attributes */
+    if ((i == model->clsid) || !vals[i] || !*vals[i]) {
+      _null(att, inst); continue; }     /* set missing values */
+    if (att_type(att) == AT_NOM) {      /* if nominal attribute */
+      k = (model->nbc) ? nbc_valid(model->nbc, i, vals[i])
+        :                att_valid(att, vals[i]);
+      inst->i = (k >= 0) ? k : NV_NOM; }   /* (unknown values are */
+    else                                   /*  treated as null) */
+    if (_number(att, vals[i], inst) != 0)
+      return BC_EVALUE;         /* convert a numeric value */
+  }
+  return (model->fbc) ? fbc_exec_r(model->fbc, ws->fws, ws->insts, conf)
+       :                nbc_exec_r(model->nbc, ws->nws, ws->insts, conf);
+}  /* bc_exec() */              /* execute the classifier */
+
+/*--------------------------------------------------------------------*/
+
+double bc_post (const BCWORK *ws, int cls)
+{                               /* --- get a posterior probability */
+  assert(ws && (cls >= 0) && (cls < ws->clscnt));
+  return (ws->fws) ? fbc_wspost(ws->fws, cls)
+       :             nbc_wspost(ws->nws, cls);
+}  /* bc_post() */
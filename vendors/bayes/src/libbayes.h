@@ -0,0 +1,69 @@
+/*----------------------------------------------------------------------
+  File    : libbayes.h
+  Contents: embeddable Bayes classifier library (opaque handles)
+  Author  : agent
+  History : 2026.10.17 file created
+----------------------------------------------------------------------*/
+#ifndef __LIBBAYES__
+#define __LIBBAYES__
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+/* --- classifier types --- */
+#define BC_NAIVE    0           /* naive Bayes classifier */
+#define BC_FULL     1           /* full  Bayes classifier */
+
+/* --- setup modes --- */
+#define BC_DWNULL   0x0040      /* distribute weight for null values */
+#define BC_MAXLLH   0x0080      /* max. likelihood estim. of variance */
+
+/* --- save modes --- */
+#define BC_TEXT     0           /* human readable description */
+#define BC_BINARY   1           /* binary model file (naive only) */
+
+/* --- error codes --- */
+#define BC_OK         0         /* no error */
+#define BC_ENOMEM   (-1)        /* not enough memory */
+#define BC_EFOPEN   (-2)        /* cannot open file */
+#define BC_EPARSE   (-3)        /* parse error in domain/model file */
+#define BC_EVALUE   (-4)        /* invalid attribute value */
+#define BC_ECLASS   (-5)        /* missing or invalid class attribute */
+#define BC_EFWRITE  (-6)        /* write error on file */
+#define BC_EMODEL   (-7)        /* operation not supported by model */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct bcmodel BCMODEL; /* (classifier model, opaque) */
+typedef struct bcwork  BCWORK;  /* (execution workspace, opaque) */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+extern BCMODEL*    bc_create   (const char *domfile, const char *clsname,
+                                int type, int *err);
+extern BCMODEL*    bc_load     (const char *fname, int *err);
+extern void        bc_delete   (BCMODEL *model);
+extern int         bc_save     (const BCMODEL *model, const char *fname,
+                                int mode);
+
+extern int         bc_type     (const BCMODEL *model);
+extern int         bc_attcnt   (const BCMODEL *model);
+extern const char* bc_attname  (const BCMODEL *model, int attid);
+extern int         bc_attid    (const BCMODEL *model, const char *name);
+extern int         bc_clsid    (const BCMODEL *model);
+extern int         bc_clscnt   (const BCMODEL *model);
+extern const char* bc_clsname  (const BCMODEL *model, int cls);
+
+extern int         bc_add      (BCMODEL *model, const char *const *vals,
+                                double wgt);
+extern int         bc_setup    (BCMODEL *model, int mode, double lcorr);
+
+extern BCWORK*     bc_wscreate (const BCMODEL *model);
+extern void        bc_wsdelete (BCWORK *ws);
+extern int         bc_exec     (const BCMODEL *model, BCWORK *ws,
+                                const char *const *vals, double *conf);
+extern double      bc_post     (const BCWORK *ws, int cls);
+
+#endif
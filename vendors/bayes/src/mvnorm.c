@@ -10,6 +10,10 @@
             2004.04.15 treatment of decomposition failure improved
             2004.08.12 adapted to new module parse
             2005.09.05 bug in function _decom (recomputation) fixed
+            2026.10.17 function mvn_eval_r added (caller buffer)
+            2026.10.17 reference counter added (shared distributions)
+            2026.10.17 function mvn_merge added (sum of statistics)
+            2026.10.17 atomic reference counter, function mvn_rand_r
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -125,6 +129,7 @@ static MVNORM* _create (int size)
   if (size <= 0) size = 1;      /* check and adapt the matrix size */
   mvn = (MVNORM*)calloc(1, sizeof(MVNORM) +(size-1) *sizeof(MVNROW*));
   if (!mvn) return NULL;        /* create the base structure */
+  mvn->refs  = 1;               /* init. the reference counter */
   mvn->size  = size;            /* and store the matrix size */
   mvn->covs  = (double**)malloc(4*size *sizeof(double*));
   if (!mvn->covs) { free(mvn); return NULL; }
@@ -198,6 +203,8 @@ void mvn_delete (MVNORM *mvn)
   MVNROW **row;                 /* to traverse the matrix rows */
 
   assert(mvn);                  /* check the function argument */
+  if (rc_dec(&mvn->refs) > 0)   /* if the distribution is */
+    return;                     /* still referenced, abort */
   for (row = mvn->rows +(i = mvn->size); --i >= 0; )
     if (*--row) free(*row);     /* delete all statistics rows, */
   if (mvn->exps) free(mvn->exps);    /* the parameter vectors, */
@@ -284,6 +291,42 @@ void mvn_addx (MVNORM *mvn, const double vals[], double cnt)
 
 /*--------------------------------------------------------------------*/
 
+void mvn_merge (MVNORM *dst, const MVNORM *src, const int *map)
+{                               /* --- merge two normal distributions */
+  int           i, k, a, b;     /* loop variables, mapped indices */
+  MVNROW        *dr;            /* to traverse the matrix rows */
+  const MVNROW  *sr;            /* of destination and source */
+  MVNELEM       *de;            /* to traverse the matrix elements */
+  const MVNELEM *se;            /* of destination and source */
+
+  assert(dst && src             /* check the function arguments */
+      && (dst->size >= src->size));
+  for (i = src->size; --i >= 0; ) {
+    sr = src->rows[i];          /* traverse the source rows */
+    a  = (map) ? map[i] : i;    /* get the destination row */
+    dr = dst->rows[a];          /* and add the terms needed */
+    dr->cnt += sr->cnt;         /* to compute the expected value */
+    dr->sv  += sr->sv;          /* and the variance */
+    dr->sv2 += sr->sv2;
+    for (se = sr->elems +(k = i); --k >= 0; ) {
+      --se; b = (map) ? map[k] : k;
+      if (a > b) {              /* if the index order is kept, */
+        de = dst->rows[a]->elems +b;   /* add the sums directly */
+        de->cnt += se->cnt; de->src += se->src;
+        de->sr  += se->sr;  de->sr2 += se->sr2;
+        de->sc  += se->sc;  de->sc2 += se->sc2; }
+      else {                    /* if the index order is reversed, */
+        de = dst->rows[b]->elems +a;   /* exchange row and column */
+        de->cnt += se->cnt; de->src += se->src;
+        de->sr  += se->sc;  de->sr2 += se->sc2;
+        de->sc  += se->sr;  de->sc2 += se->sr2;
+      }                         /* add the terms needed */
+    }                           /* to compute the covariance */
+  }
+}  /* mvn_merge() */
+
+/*--------------------------------------------------------------------*/
+
 int mvn_calc (MVNORM *mvn, int mode)
 {                               /* --- calc. parameters from data */
   int     i, k;                 /* loop variables */
@@ -351,17 +394,26 @@ int mvn_calc (MVNORM *mvn, int mode)
 /*--------------------------------------------------------------------*/
 
 double mvn_eval (MVNORM *mvn, const double vals[])
+{                               /* --- evaluate a normal distribution */
+  assert(mvn && vals);          /* check the function arguments */
+  return mvn_eval_r(mvn, vals, mvn->diff);
+}  /* mvn_eval() */             /* use the internal buffers */
+
+/*--------------------------------------------------------------------*/
+
+double mvn_eval_r (const MVNORM *mvn, const double vals[], double *buf)
 {                               /* --- evaluate a normal distribution */
   int    i, k;                  /* loop variables */
-  double *d, *x, *p;            /* to traverse vectors and matrices */
+  double *d, *p;                /* to traverse vectors and matrices */
+  const double *x;              /* to traverse the parameters */
   double t;                     /* temporary buffer for exponent */
 
-  assert(mvn && vals);          /* check the function arguments */
-  d = mvn->diff +mvn->size;     /* traverse the data values and the */
+  assert(mvn && vals && buf);   /* check the function arguments */
+  d = buf +mvn->size;           /* traverse the data values and the */
   x = mvn->exps +mvn->size;     /* corresponding expected values */
   for (vals += (i = mvn->size); --i >= 0; )
     *--d = *--vals - *--x;      /* compute the difference vector d */
-  p = mvn->buf +mvn->size;      /* get buffer for intermediate result */
+  p = buf +2*mvn->size;         /* get buffer for intermediate result */
   for (i = mvn->size; --i >= 0; ) {
     *--p = 0;                   /* traverse the matrix columns */
     for (d += k = mvn->size; --k > i; )
@@ -373,16 +425,27 @@ double mvn_eval (MVNORM *mvn, const double vals[])
   for (t = 0, p += i = mvn->size; --i >= 0; )
     t += *--d * *--p;           /* calc. product with d^T * \Sigma^-1 */
   return mvn->norm *exp(-0.5 *t);      /* return the value */
-}  /* mvn_eval() */             /* of the density function */
+}  /* mvn_eval_r() */           /* of the density function */
 
 /*--------------------------------------------------------------------*/
 
 double* mvn_rand (MVNORM *mvn, double drand (void))
+{                               /* --- generate random sample point */
+  assert(mvn && drand);         /* check the function arguments */
+  return mvn_rand_r(mvn, drand, mvn->buf);
+}  /* mvn_rand() */             /* use the internal buffer */
+
+/*--------------------------------------------------------------------*/
+
+double* mvn_rand_r (const MVNORM *mvn, double drand (void),
+                    double *buf)
 {                               /* --- generate random sample point */
   int    i, k;                  /* loop variables */
-  double *b, *r;                /* to access the buffer/matrix rows */
+  double *b;                    /* to access the buffer */
+  const double *r;              /* to traverse the matrix rows */
 
-  for (b = mvn->buf +(i = mvn->size); --i >= 0; )
+  assert(mvn && drand && buf);  /* check the function arguments */
+  for (b = buf +(i = mvn->size); --i >= 0; )
     *--b = _normd(drand);       /* generate points from N(0,1)^n */
   for (i = mvn->size; --i >= 0; ) {
     r = mvn->decom[i] +i;       /* traverse the matrix rows */
@@ -393,7 +456,7 @@ double* mvn_rand (MVNORM *mvn, double drand (void))
   for (b += (i = mvn->size); --i >= 0; )
     *--b += mvn->exps[i];       /* add the expected value vector */
   return b;                     /* return the created sample point */
-}  /* mvn_rand() */
+}  /* mvn_rand_r() */
 
 /*--------------------------------------------------------------------*/
 
@@ -7,11 +7,16 @@
             2001.05.24 possibilistic parameter added
             2004.04.22 functions mvn_addx and mvn_cnt added
             2004.08.12 adapted to new module parse
+            2026.10.17 function mvn_eval_r added (caller buffer)
+            2026.10.17 reference counter added (function mvn_share)
+            2026.10.17 function mvn_merge added
+            2026.10.17 atomic reference counter, function mvn_rand_r added
 ----------------------------------------------------------------------*/
 #ifndef __MVNORM__
 #define __MVNORM__
 #include <stdio.h>
 #include <float.h>
+#include "refcnt.h"
 #ifdef MVN_PARSE
 #include "parse.h"
 #endif
@@ -53,6 +58,7 @@ typedef struct {                /* --- matrix row --- */
 } MVNROW;                       /* (matrix row) */
 
 typedef struct {                /* --- multivariate normal dist. --- */
+  int     refs;                 /* reference counter */
   int     size;                 /* number of rows / columns */
   double  *exps;                /* expected values */
   double  **covs;               /* covariance matrix */
@@ -73,14 +79,22 @@ typedef struct {                /* --- multivariate normal dist. --- */
 extern MVNORM* mvn_create (int size);
 extern MVNORM* mvn_clone  (const MVNORM *mvn);
 extern void    mvn_delete (MVNORM *mvn);
+extern MVNORM* mvn_share  (MVNORM *mvn);
+extern int     mvn_refs   (const MVNORM *mvn);
 extern int     mvn_size   (const MVNORM *mvn);
 
 extern void    mvn_clear  (MVNORM *mvn);
 extern void    mvn_add    (MVNORM *mvn, const double vals[],double cnt);
 extern void    mvn_addx   (MVNORM *mvn, const double vals[],double cnt);
+extern void    mvn_merge  (MVNORM *dst, const MVNORM *src,
+                           const int *map);
 extern int     mvn_calc   (MVNORM *mvn, int flags);
 extern double  mvn_eval   (MVNORM *mvn, const double vals[]);
+extern double  mvn_eval_r (const MVNORM *mvn, const double vals[],
+                           double *buf);
 extern double* mvn_rand   (MVNORM *mvn, double drand (void));
+extern double* mvn_rand_r (const MVNORM *mvn, double drand (void),
+                           double *buf);
 
 extern double  mvn_cnt    (MVNORM *mvn, int index);
 extern double  mvn_exp    (MVNORM *mvn, int index);
@@ -101,6 +115,8 @@ extern int     mvn_parse  (MVNORM *mvn, SCAN *scan, double cnt);
 /*----------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------*/
+#define mvn_share(d)      (rc_inc(&(d)->refs), (d))
+#define mvn_refs(d)       rc_get(&(d)->refs)
 #define mvn_size(d)       ((d)->size)
 
 #define mvn_cnt(d,i)      ((d)->rows[i]->cnt)
@@ -26,13 +26,45 @@
             2004.08.12 adapted to new module parse
             2007.02.13 adapted to modified module attset
             2007.03.21 function nbc_exec extended (posterior probs.)
+            2026.10.17 sparse functions nbc_addsp and nbc_execsp added
+            2026.10.17 execution in log-space (logarithms precomputed)
+            2026.10.17 reentrant function nbc_exec_r added
+            2026.10.17 batch execution functions added
+            2026.10.17 compiled execution plan added (nbc_compile)
+            2026.10.17 functions nbc_sub and nbc_subsp added
+            2026.10.17 incremental setup of changed attributes added
+            2026.10.17 multi-threaded evaluation of selectable atts.
+            2026.10.17 log. posteriors of tuples cached during selection
+            2026.10.17 distributions allocated lazily from memory slabs
+            2026.10.17 copy-on-write cloning (mode NBC_COW) added
+            2026.10.17 binary model files (nbc_save, nbc_load) added
+            2026.10.17 load mode NBC_READ added (no map of the file)
+            2026.10.17 function nbc_merge added (sum of statistics)
+            2026.10.17 new values merged in the order of their occurrence
+            2026.10.17 quantized log. probabilities in binary model files
+            2026.10.17 feature hashing of token attributes added
+            2026.10.17 heavy hitter tracking of token attributes added
+            2026.10.17 multinomial model for count attributes (NBC_MULTI)
+            2026.10.17 atomic reference counters, sole owner writes in place
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <float.h>
 #include <math.h>
 #include <assert.h>
 #include "nbayes.h"
+#include "refcnt.h"
+#if defined NBC_INDUCE && defined NBC_THREADS
+#include <pthread.h>
+#endif
+#if !defined NBC_NOMMAP && (defined __unix__ || defined __APPLE__)
+#define NBC_MMAP                /* map binary files into memory */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 #ifdef STORAGE
 #include "storage.h"
 #endif
@@ -43,18 +75,447 @@
 #define	M_PI        3.14159265358979323846  /* \pi */
 #define EPSILON     1e-12       /* to handle roundoff errors */
 #define BLKSIZE     16          /* block size for vectors */
+#define EVALBLKS    64          /* number of tuple blocks (eval.) */
+#define SLABSIZE    4096        /* size of first memory slab */
+#define BINBOM      0x01020304  /* byte order mark of binary files */
+#define BINALIGN    8           /* alignment of binary file sections */
+
+/* --- number of doubles needed for a vector of structures --- */
+#define NDBL(n,t)   (((size_t)(n) *sizeof(t) +sizeof(double)-1) \
+                    / sizeof(double))
 
 /*----------------------------------------------------------------------
   Type Definitions
 ----------------------------------------------------------------------*/
+typedef struct freeblk {        /* --- free block of a memory slab */
+  struct freeblk *succ;         /* successor in free list */
+  size_t size;                  /* number of doubles in block */
+} FREEBLK;                      /* (free block) */
+
 typedef struct {                /* --- selectable attribute --- */
   int    attid;                 /* attribute identifier */
   double errs;                  /* number of misclassifications */
 } SELATT;                       /* (selectable attribute) */
 
+typedef struct {                /* --- evaluation job --- */
+  const NBC    *nbc;            /* classifier to evaluate */
+  TABLE        *table;          /* table with the training tuples */
+  int          mode;            /* selection mode (add/remove) */
+  const SELATT *savec;          /* vector of selectable attributes */
+  int          cnt;             /* number of selectable attributes */
+  int          blkcnt;          /* total number of tuple blocks */
+  int          first;           /* first tuple block of the job */
+  int          step;            /* step between tuple blocks */
+  const double *lps;            /* log. posteriors of the tuples */
+  double       *errs;           /* error counters of the blocks */
+  double       *buf;            /* buffer for log. probabilities */
+} EVALJOB;                      /* (evaluation job) */
+
+typedef unsigned int BINOFF;    /* offset in a binary model file */
+
+typedef struct {                /* --- binary file header --- */
+  char   magic[4];              /* magic number (NBC_MAGIC) */
+  int    version;               /* version of the file format */
+  int    bom;                   /* byte order mark (BINBOM) */
+  int    hdrsz;                 /* size of the header */
+  int    attsz;                 /* size of an attribute record */
+  int    dblsz;                 /* size of a double */
+  int    attcnt;                /* number of attributes */
+  int    clsid;                 /* identifier of class attribute */
+  int    clscnt;                /* number of classes */
+  int    mode;                  /* estimation mode (e.g. NBC_MAXLLH) */
+  int    quant;                 /* quantization of the plan tables */
+  int    bktcnt;                /* number of hash buckets (0: none) */
+  unsigned int seed;            /* seed of the hash function */
+  int    hmode;                 /* feature hashing mode (NBC_HSIGN) */
+  double lcorr;                 /* Laplace correction */
+  double total;                 /* total number of cases */
+  double qerr;                  /* bound for the log. posterior error */
+  BINOFF size;                  /* size of the file */
+  BINOFF atts;                  /* attribute records */
+  BINOFF frqs;                  /* class frqs., priors, log. priors */
+} BINHDR;                       /* (binary file header) */
+
+typedef struct {                /* --- binary attribute record --- */
+  BINOFF name;                  /* attribute name */
+  int    type;                  /* attribute type (e.g. AT_NOM) */
+  int    mark;                  /* mark of distribution vector */
+  int    valcnt;                /* number of attribute values */
+  int    valwd[2];              /* widths of the value names */
+  BINOFF vals;                  /* value names (vector of offsets) */
+  BINOFF vhash;                 /* hash table of the value names */
+  int    vhsz;                  /* size of the hash table */
+  BINOFF dists;                 /* conditional distributions */
+  BINOFF tab;                   /* table of compiled plan */
+  double scale;                 /* scale of fixed-point log. probs. */
+} BINATT;                       /* (binary attribute record) */
+
+typedef struct {                /* --- binary output buffer --- */
+  char   *buf;                  /* buffer for the file contents */
+  size_t size;                  /* size of the buffer */
+  size_t used;                  /* number of bytes used */
+  int    err;                   /* whether an error occurred */
+} BINBUF;                       /* (binary output buffer) */
+
 /*----------------------------------------------------------------------
   Auxiliary Functions
 ----------------------------------------------------------------------*/
+
+static int _flist (size_t n)
+{                               /* --- free list for a block size */
+  int i = 0;                    /* index of free list */
+
+  while ((n >>= 1) > 0) i++;    /* compute floor(log_2(n)), i.e., */
+  return (i < NBC_FREES) ? i : NBC_FREES-1;
+}  /* _flist() */               /* list i has sizes in [2^i, 2^(i+1)) */
+
+/*--------------------------------------------------------------------*/
+
+static void _free (NBC *nbc, void *p, size_t n)
+{                               /* --- return a block to a slab */
+  FREEBLK *b, *h;               /* block to add, head of a free list */
+  int     i;                    /* index of a free list */
+
+  assert(nbc);                  /* check the function argument */
+  if (!p || (n < NDBL(1, FREEBLK)))
+    return;                     /* too small blocks stay unused */
+  b = (FREEBLK*)p;              /* get the block to add */
+  for (i = NBC_FREES; --i >= 0; ) {
+    h = (FREEBLK*)nbc->frees[i];/* traverse the heads of the lists */
+    if (!h) continue;           /* (vectors that are replaced */
+    if      ((double*)h +h->size == (double*)b) b = h;
+    else if ((double*)b +n == (double*)h) ;
+    else continue;              /*  one after the other are often */
+    nbc->frees[i] = h->succ;    /*  adjacent, e.g. the vectors of */
+    n += h->size;               /*  all classes of an attribute) */
+  }                             /* merge adjacent free blocks */
+  b->size = n;                  /* note the size of the block */
+  i = _flist(n);                /* and add it to its free list */
+  b->succ = (FREEBLK*)nbc->frees[i]; nbc->frees[i] = b;
+}  /* _free() */
+
+/*--------------------------------------------------------------------*/
+
+static void* _alloc (NBC *nbc, size_t n)
+{                               /* --- allocate from memory slabs */
+  SLAB    *slab;                /* current memory slab */
+  FREEBLK *b;                   /* block taken from a free list */
+  size_t  z;                    /* size of a new slab */
+  int     i;                    /* index of a free list */
+
+  assert(nbc);                  /* check the function argument */
+  if (n <= 0) n = 1;            /* allocate at least one element */
+  i = _flist(n);                /* (all blocks in the lists from */
+  if (((size_t)1 << i) < n) i++;/*  index ceil(log_2(n)) suffice) */
+  for ( ; i < NBC_FREES; i++) { /* traverse the free lists */
+    b = (FREEBLK*)nbc->frees[i];
+    if (!b || (b->size < n)) continue;
+    nbc->frees[i] = b->succ;    /* remove the first block and */
+    z = b->size;                /* return the unused rest of it */
+    _free(nbc, (double*)b +n, z -n);
+    return b;                   /* return a block */
+  }                             /* that was replaced before */
+  slab = nbc->slabs;            /* get the current memory slab */
+  if (!slab || (slab->used +n > slab->size)) {
+    z = (slab) ? slab->size << 1 : SLABSIZE;
+    if (z < n) z = n;           /* compute the size of a new slab */
+    slab = (SLAB*)malloc(sizeof(SLAB) +(z-1) *sizeof(double));
+    if (!slab) return NULL;     /* allocate a new memory slab */
+    slab->size = z;             /* (slab sizes grow geometrically) */
+    slab->used = 0;             /* and add it to the slab list */
+    slab->succ = nbc->slabs; nbc->slabs = slab;
+    slab = slab->succ;          /* put the rest of the old slab */
+    if (slab) {                 /* into a free list */
+      _free(nbc, slab->data +slab->used, slab->size -slab->used);
+      slab->used = slab->size;  /* (it is used up afterwards) */
+    }
+    slab = nbc->slabs;          /* get the new memory slab */
+  }
+  slab->used += n;              /* allocate from the current slab */
+  return slab->data +slab->used -n;
+}  /* _alloc() */               /* return the allocated memory */
+
+/*--------------------------------------------------------------------*/
+
+static int _attinit (NBC *nbc, DVEC *dvec)
+{                               /* --- create distribs. of attribute */
+  int    k;                     /* loop variable */
+  DISCD  *discd;                /* to traverse the discrete distribs. */
+  NORMD  *normd;                /* to traverse the normal   distribs. */
+  double *frq;                  /* to traverse the frequency vectors */
+
+  assert(nbc && dvec && (dvec->type != 0));
+  if (dvec->discds || dvec->normds)  /* if the distributions */
+    return 0;                   /* already exist, abort */
+  if (nbc->clsvsz <= 0)         /* if there are no classes, */
+    return 0;                   /* there is nothing to do */
+  if (dvec->type == AT_NOM) {   /* -- if the attribute is nominal */
+    discd = (DISCD*)_alloc(nbc, NDBL(nbc->clsvsz, DISCD));
+    if (!discd) return -1;      /* create a vector of discrete dists. */
+    for (k = nbc->clsvsz; --k >= 0; ) {
+      discd[k].cnt  = 0;        /* clear the distributions */
+      discd[k].frqs = discd[k].probs = discd[k].lprobs = NULL;
+    }
+    dvec->valvsz = dvec->valcnt;/* create vectors for all values */
+    if (dvec->valvsz > 0) {     /* if the attribute has values */
+      frq = (double*)_alloc(nbc, (size_t)nbc->clscnt *dvec->valvsz *3);
+      if (!frq) return -1;      /* create the value freq. vectors */
+      for (k = nbc->clscnt *dvec->valvsz *3; --k >= 0; )
+        frq[k] = 0;             /* clear the value frequencies */
+      for (k = 0; k < nbc->clscnt; k++) {
+        discd[k].frqs   = frq;  /* set the value frequency */
+        discd[k].probs  = frq +dvec->valvsz;       /* and the */
+        discd[k].lprobs = discd[k].probs +dvec->valvsz;
+        frq += dvec->valvsz *3; /* probabilities vectors */
+      }                         /* (frequencies, probabilities, */
+    }                           /* and logarithms of probabilities */
+    dvec->discds = discd; }     /* are stored in one memory block) */
+  else {                        /* -- if the attribute is numeric */
+    normd = (NORMD*)_alloc(nbc, NDBL(nbc->clsvsz, NORMD));
+    if (!normd) return -1;      /* create a vector of normal dists. */
+    for (k = nbc->clsvsz; --k >= 0; ) {
+      normd[k].cnt = normd[k].sv  = normd[k].sv2  = 0;
+      normd[k].exp = normd[k].var = normd[k].ivar = normd[k].lnrm = 0;
+    }                           /* clear the sums and the estimates */
+    dvec->normds = normd;       /* (expected value and variance */
+  }                             /*  are computed in nbc_setup) */
+  return 0;                     /* return 'ok' */
+}  /* _attinit() */
+
+/*--------------------------------------------------------------------*/
+
+static int _attcopy (NBC *nbc, DVEC *dst, const DVEC *src)
+{                               /* --- copy distribs. of attribute */
+  int         k, n;             /* loop variable, buffer */
+  DISCD       *dd;              /* to traverse the discrete distribs. */
+  const DISCD *sd;              /* of destination and source */
+  NORMD       *dn;              /* to traverse the normal   distribs. */
+  const NORMD *sn;              /* of destination and source */
+
+  assert(nbc && dst && src      /* check the function arguments */
+      && !dst->discds && !dst->normds && (dst->valcnt == src->valcnt));
+  if (_attinit(nbc, dst) != 0)  /* create the distributions */
+    return -1;                  /* in the own memory slabs */
+  if      (dst->discds) {       /* -- if the attribute is nominal */
+    n  = dst->valcnt *sizeof(double);
+    sd = src->discds +nbc->clscnt;
+    dd = dst->discds +nbc->clscnt;
+    for (k = nbc->clscnt; --k >= 0; ) {
+      (--dd)->cnt = (--sd)->cnt;  /* copy the total frequency */
+      if (n <= 0) continue;     /* and the value distributions */
+      memcpy(dd->frqs,   sd->frqs,   n);
+      memcpy(dd->probs,  sd->probs,  n);
+      memcpy(dd->lprobs, sd->lprobs, n);
+    } }                         /* (frequencies and probabilities) */
+  else if (dst->normds) {       /* -- if the attribute is numeric */
+    sn = src->normds +nbc->clscnt;
+    dn = dst->normds +nbc->clscnt;
+    for (k = nbc->clscnt; --k >= 0; )
+      *--dn = *--sn;            /* copy the normal distributions */
+  }                             /* (including computed estimates) */
+  return 0;                     /* return 'ok' */
+}  /* _attcopy() */
+
+/*--------------------------------------------------------------------*/
+
+static int _excl (const NBC *nbc)
+{                               /* --- check for exclusive memory */
+  const NBCSHR *shr;            /* to traverse the shared memory */
+
+  assert(nbc);                  /* check the function argument */
+  for (shr = nbc->shr; shr; shr = shr->base)
+    if (shr->map || (rc_get(&shr->refs) > 1))
+      return 0;                 /* check for a binary model file */
+  return 1;                     /* and for other classifiers */
+}  /* _excl() */                /* that reference the memory */
+
+/*--------------------------------------------------------------------*/
+
+static int _attown (NBC *nbc, DVEC *dvec)
+{                               /* --- unshare distribs. of attribute */
+  DVEC old;                     /* old (shared) distribution vector */
+
+  assert(nbc && dvec);          /* check the function arguments */
+  if (!dvec->shared)            /* if the distributions are not */
+    return 0;                   /* shared, there is nothing to do */
+  if (_excl(nbc)) {             /* if all clones have been deleted, */
+    dvec->shared = 0; return 0; }   /* the memory can be changed */
+  old = *dvec;                  /* note the shared distributions */
+  dvec->discds = NULL; dvec->normds = NULL;
+  if (_attcopy(nbc, dvec, &old) != 0) {
+    *dvec = old; return -1; }   /* copy the shared distributions */
+  dvec->shared = 0;             /* (the old ones remain in the */
+  return 0;                     /*  shared memory slabs until */
+}  /* _attown() */              /*  the last clone is deleted) */
+
+/*--------------------------------------------------------------------*/
+
+static unsigned int _strhash (const char *s)
+{                               /* --- compute hash value of a name */
+  unsigned int h = 0;           /* hash value */
+
+  assert(s);                    /* check the function argument */
+  while (*s) h = h *31 +(unsigned char)*s++;
+  return h;                     /* combine the characters */
+}  /* _strhash() */             /* and return the hash value */
+
+/*--------------------------------------------------------------------*/
+
+static unsigned int _hash (const char *s, unsigned int seed)
+{                               /* --- compute seeded hash of a token */
+  unsigned int h = seed ^ 0x811c9dc5U;   /* hash value */
+
+  assert(s);                    /* check the function argument */
+  while (*s) {                  /* traverse the characters */
+    h ^= (unsigned char)*s++; h *= 0x01000193U; }   /* (FNV-1a) */
+  h ^= h >> 16; h *= 0x85ebca6bU;   /* mix the bits, so that all */
+  h ^= h >> 13; h *= 0xc2b2ae35U;   /* bits depend on all characters */
+  h ^= h >> 16;                 /* (finalizer of MurmurHash3) */
+  return h;                     /* return the hash value */
+}  /* _hash() */
+
+/*--------------------------------------------------------------------*/
+
+static void _htclear (NBC *nbc)
+{                               /* --- delete the token maps */
+  HTOK *ht;                     /* to traverse the token maps */
+
+  assert(nbc);                  /* check the function argument */
+  for (ht = nbc->htoks +nbc->htcnt; --nbc->htcnt >= 0; )
+    if ((--ht)->ids) free(ht->ids);
+  if (nbc->htoks) free(nbc->htoks);
+  nbc->htoks = NULL; nbc->htcnt = 0; nbc->htset = NULL;
+  nbc->ctrused = 0;             /* clear the map vector */
+}  /* _htclear() */             /* and the heavy hitter counters */
+
+/*--------------------------------------------------------------------*/
+
+static void _hhup (NBC *nbc, int i)
+{                               /* --- sift a counter up the heap */
+  int   k;                      /* index of parent counter */
+  HHCTR t;                      /* exchange buffer */
+
+  assert(nbc && (i >= 0) && (i < nbc->ctrused));
+  for (t = nbc->ctrs[i]; i > 0; i = k) {
+    k = (i-1) >> 1;             /* traverse the parent counters */
+    if (nbc->ctrs[k].frq <= t.frq) break;
+    nbc->ctrs[i] = nbc->ctrs[k];/* shift larger parents down */
+    nbc->htoks[nbc->ctrs[i].tok].ctr = i;
+  }                             /* (and note their new positions) */
+  nbc->ctrs[i] = t;             /* store the counter */
+  nbc->htoks[t.tok].ctr = i;    /* at its new position */
+}  /* _hhup() */
+
+/*--------------------------------------------------------------------*/
+
+static void _hhdown (NBC *nbc, int i)
+{                               /* --- sift a counter down the heap */
+  int   k;                      /* index of child counter */
+  HHCTR t;                      /* exchange buffer */
+
+  assert(nbc && (i >= 0) && (i < nbc->ctrused));
+  for (t = nbc->ctrs[i]; (k = i+i+1) < nbc->ctrused; i = k) {
+    if ((k+1 < nbc->ctrused)    /* find the smaller child */
+    &&  (nbc->ctrs[k+1].frq < nbc->ctrs[k].frq)) k++;
+    if (nbc->ctrs[k].frq >= t.frq) break;
+    nbc->ctrs[i] = nbc->ctrs[k];/* shift smaller children up */
+    nbc->htoks[nbc->ctrs[i].tok].ctr = i;
+  }                             /* (and note their new positions) */
+  nbc->ctrs[i] = t;             /* store the counter */
+  nbc->htoks[t.tok].ctr = i;    /* at its new position */
+}  /* _hhdown() */
+
+/*--------------------------------------------------------------------*/
+
+static double _hhcount (NBC *nbc, int tok, double wgt)
+{                               /* --- count a token (space saving) */
+  HTOK  *ht;                    /* token map of the token */
+  HHCTR *c;                     /* counter of the token */
+
+  assert(nbc && (tok >= 0) && (tok < nbc->htcnt) && (wgt >= 0));
+  ht = nbc->htoks +tok;         /* get the token map */
+  if      (ht->ctr >= 0) {      /* if the token has a counter, */
+    nbc->ctrs[ht->ctr].frq += wgt;   /* simply increment it */
+    _hhdown(nbc, ht->ctr); }
+  else if (nbc->ctrused < nbc->ctrcnt) {
+    c = nbc->ctrs +nbc->ctrused++;   /* if there is a free counter, */
+    c->tok = tok; c->frq = wgt; c->err = 0;       /* use it */
+    _hhup(nbc, nbc->ctrused-1); }
+  else {                        /* if all counters are in use, */
+    c = nbc->ctrs;              /* take over the smallest counter */
+    nbc->htoks[c->tok].ctr = -1;/* (the evicted token may still be */
+    c->tok = tok;               /*  frequent, but its frequency */
+    c->err = c->frq;            /*  is at most the minimal count, */
+    c->frq += wgt;              /*  which becomes the error bound */
+    _hhdown(nbc, 0);            /*  of the new token) */
+  }
+  return nbc->ctrs[ht->ctr].frq;/* return the estimated frequency */
+}  /* _hhcount() */
+
+/*--------------------------------------------------------------------*/
+
+static void _hhrem (NBC *nbc, int i)
+{                               /* --- remove a counter from the heap */
+  int tok;                      /* token of the last counter */
+
+  assert(nbc && (i >= 0) && (i < nbc->ctrused));
+  if (i >= --nbc->ctrused) return;
+  tok = nbc->ctrs[nbc->ctrused].tok;   /* replace the counter */
+  nbc->ctrs[i] = nbc->ctrs[nbc->ctrused];  /* by the last one */
+  _hhup  (nbc, i);              /* and restore the heap property */
+  _hhdown(nbc, nbc->htoks[tok].ctr);
+}  /* _hhrem() */
+
+/*--------------------------------------------------------------------*/
+
+static int _track (NBC *nbc, int tok, double wgt, const char *name)
+{                               /* --- track a token */
+  HTOK *ht;                     /* token map of the token */
+  int  r;                       /* result of renaming the slot */
+
+  assert(nbc && (tok >= 0) && (tok < nbc->htcnt) && name);
+  if (_hhcount(nbc, tok, wgt) < nbc->minfrq)
+    return 0;                   /* count the token occurrence */
+  ht = nbc->htoks +tok;         /* if the token has become frequent, */
+  _hhrem(nbc, ht->ctr);         /* it needs no counter anymore */
+  ht->ctr = -3;                 /* (it is either materialized */
+  if (nbc->slotused >= nbc->slotcnt) {
+    nbc->dropped++; return 0; } /*  or dropped for lack of slots) */
+  r = att_rename(as_att(nbc->attset, nbc->slotused+1), name);
+  if (r != 0) return r;         /* name the next free token slot */
+  ht->bkt = ++nbc->slotused;    /* and map the token to it */
+  return 1;                     /* return 'token materialized' */
+}  /* _track() */
+
+/*--------------------------------------------------------------------*/
+
+static void _unmap (NBCSHR *shr)
+{                               /* --- release a binary model file */
+  assert(shr && shr->map);      /* check the function argument */
+  #ifdef NBC_MMAP
+  if (shr->mapped) munmap(shr->map, shr->size);
+  else             free(shr->map);
+  #else                         /* unmap the file or delete */
+  free(shr->map);               /* the memory it was read into */
+  #endif
+  shr->map = NULL;              /* clear the file pointer */
+}  /* _unmap() */
+
+/*--------------------------------------------------------------------*/
+
+static const char* _valname (const NBC *nbc, int attid, int valid)
+{                               /* --- get the name of a value */
+  const BINATT *ba;             /* attribute record of binary file */
+
+  assert(nbc && (attid >= 0) && (attid < nbc->attcnt));
+  if (!nbc->bin)                /* if not loaded from a binary file, */
+    return att_valname(as_att(nbc->attset, attid), valid);
+  ba = (const BINATT*)(nbc->bin +((const BINHDR*)nbc->bin)->atts);
+  ba += attid;                  /* get the attribute record */
+  return nbc->bin +((const BINOFF*)(nbc->bin +ba->vals))[valid];
+}  /* _valname() */             /* return the value name */
+
+/*--------------------------------------------------------------------*/
 #ifdef NBC_INDUCE
 
 static int _clsrsz (NBC *nbc, int clscnt)
@@ -67,125 +528,181 @@ static int _clsrsz (NBC *nbc, int clscnt)
   double *frq;                  /* to traverse the frequency vectors */
 
   assert(nbc && (clscnt >= 0)); /* check the function arguments */
+  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; )
+    if (_attown(nbc, --dvec) != 0)
+      return -1;                /* unshare all distributions */
 
   /* --- resize the class dependent vectors --- */
   clsvsz = nbc->clsvsz;         /* get the class dep. vector size */
   if (clscnt >= clsvsz) {       /* if the vectors are too small */
     clsvsz += (clsvsz > BLKSIZE) ? clsvsz >> 1 : BLKSIZE;
     if (clscnt >= clsvsz) clsvsz = clscnt;
-    frq = (double*)realloc(nbc->frqs, clsvsz *4 *sizeof(double));
+    frq = (double*)realloc(nbc->frqs, clsvsz *5 *sizeof(double));
     if (!frq) return -1;        /* resize the frequencies vector */
-    nbc->frqs   = frq;          /* and set the new vector */
-    nbc->priors = nbc->frqs   +clsvsz;  /* organize the rest */
-    nbc->posts  = nbc->priors +clsvsz;  /* of the allocated */
-    nbc->cond   = nbc->posts  +clsvsz;  /* memory block */
+    nbc->frqs    = frq;         /* and set the new vector */
+    nbc->priors  = nbc->frqs    +clsvsz;  /* organize the rest */
+    nbc->lpriors = nbc->priors  +clsvsz;  /* of the allocated */
+    nbc->posts   = nbc->lpriors +clsvsz;  /* memory block */
+    nbc->cond    = nbc->posts   +clsvsz;
     n = clsvsz -nbc->clsvsz;    /* calc. number of new vector fields */
     for (frq += clsvsz, k = n; --k >= 0; )
       *--frq = 0;               /* clear the new vector fields */
     for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
       if ((--dvec)->type == 0)  /* traverse all attributes */
         continue;               /* except the class attribute */
-      if (dvec->type == AT_NOM){/* if the attribute is nominal */
-        discd = (DISCD*)realloc(dvec->discds, clsvsz *sizeof(DISCD));
-        if (!discd) return -1;  /* resize the discrete dists. vector */
-        dvec->discds = discd;   /* and set the new vector */
+      if (dvec->discds) {       /* if the attribute is nominal */
+        discd = (DISCD*)_alloc(nbc, NDBL(clsvsz, DISCD));
+        if (!discd) return -1;  /* get a new discrete dists. vector */
+        memcpy(discd, dvec->discds, nbc->clsvsz *sizeof(DISCD));
+        _free(nbc, dvec->discds, NDBL(nbc->clsvsz, DISCD));
+        dvec->discds = discd;   /* copy the old vector fields */
         for (discd += clsvsz, k = n; --k >= 0; ) {
-          (--discd)->cnt = 0; discd->frqs = NULL;
-        } }                     /* clear the new vector fields */
-      else {                    /* if the attribute is numeric */
-        normd = (NORMD*)realloc(dvec->normds, clsvsz *sizeof(NORMD));
-        if (!normd) return -1;  /* resize the normal dists. vector */
-        dvec->normds = normd;   /* and set the new vector */
+          (--discd)->cnt = 0;   /* clear the new vector fields */
+          discd->frqs = discd->probs = discd->lprobs = NULL;
+        } }                     /* (the value frequency vectors */
+      else if (dvec->normds) {  /* are created further below) */
+        normd = (NORMD*)_alloc(nbc, NDBL(clsvsz, NORMD));
+        if (!normd) return -1;  /* get a new normal dists. vector */
+        memcpy(normd, dvec->normds, nbc->clsvsz *sizeof(NORMD));
+        _free(nbc, dvec->normds, NDBL(nbc->clsvsz, NORMD));
+        dvec->normds = normd;   /* copy the old vector fields */
         for (normd += clsvsz, k = n; --k >= 0; ) {
           (--normd)->cnt = 0; normd->sv = normd->sv2 = 0; }
       }                         /* clear the new vector fields */
-    }  /* for (dvec = ... */
-    nbc->clsvsz = clsvsz;       /* set new size of the class vectors */
+    }  /* for (dvec = ... */    /* (attributes without data */
+    nbc->clsvsz = clsvsz;       /* have no vectors yet) */
   }  /* if (clscnt >= clsvsz) ... */
 
   /* --- create new value frequency vectors --- */
+  n = clscnt -nbc->clscnt;      /* get the number of new classes */
   for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
-    if ((--dvec)->type != AT_NOM)
-      continue;                 /* traverse all nominal attributes */
+    if (!(--dvec)->discds       /* traverse all nominal attributes */
+    ||  (dvec->valvsz <= 0))    /* with value frequency vectors */
+      continue;
+    frq = (double*)_alloc(nbc, (size_t)n *dvec->valvsz *3);
+    if (!frq) return -1;        /* get the vectors for the new classes */
+    for (k = n *dvec->valvsz *3; --k >= 0; )
+      frq[k] = 0;               /* clear the value frequencies */
     discd = dvec->discds +clscnt;
-    for (k = clscnt -nbc->clscnt; --k >= 0; ) {
-      (--discd)->frqs =         /* allocate a value frequency vector */
-      frq = (double*)malloc(dvec->valvsz *2 *sizeof(double));
-      if (!frq) break;          /* set the probabilities vector */
-      discd->probs = frq +dvec->valvsz;
-      for (frq += n = dvec->valvsz; --n >= 0; )
-        *--frq = 0;             /* traverse the frequency vectors */
-    }                           /* and init. the value frequencies */
-    if (k >= 0) break;          /* on error abort the loop */
+    for (k = n; --k >= 0; frq += dvec->valvsz *3) {
+      (--discd)->frqs = frq;    /* set the value frequency vectors */
+      discd->probs  = frq +dvec->valvsz;
+      discd->lprobs = discd->probs +dvec->valvsz;
+    }                           /* and the probabilities vectors */
   }
-  if (i >= 0) {                 /* if an error occurred */
-    for (i = nbc->attcnt -i; --i >= 0; dvec++) {
-      if ((--dvec)->type != AT_NOM) continue;
-      discd = dvec->discds +clscnt;
-      for (k = clscnt -nbc->clscnt; --k >= 0; )
-        if ((--discd)->frqs) { free(discd->frqs); discd->frqs = NULL; }
-    }                           /* delete the newly created value */
-    return -1;                  /* frequency vectors of the nominal */
-  }                             /* attributes and abort the function */
-
   nbc->clscnt = clscnt;         /* set the new number of classes */
+  nbc->dcnt   = -1;             /* all attributes need a new setup */
   return 0;                     /* return 'ok' */
 }  /* _clsrsz() */
 
 /*--------------------------------------------------------------------*/
 
-static int _valrsz (DVEC *dvec, int clscnt, int valcnt)
+static int _valrsz (NBC *nbc, DVEC *dvec, int valcnt)
 {                               /* --- resize the value freq. vectors */
-  int    i, k, n;               /* loop variables, num. of new elems. */
+  int    i, k;                  /* loop variables */
   int    valvsz;                /* size of the value freq. vectors */
-  int    bsz;                   /* size of vector in bytes */
   DISCD  *discd;                /* to traverse the discrete distribs. */
   double *frq;                  /* to traverse the frequency vectors */
 
-  assert(dvec                   /* check the function argument */
-     && (dvec->type == AT_NOM) && (clscnt >= 0) && (valcnt >= 0));
+  assert(nbc && dvec            /* check the function arguments */
+     && (dvec->type == AT_NOM) && dvec->discds && (valcnt >= 0));
   valvsz = dvec->valvsz;        /* get the value freq. vector size */
   if (valcnt > valvsz) {        /* if the vectors are too small */
     valvsz += (valvsz > BLKSIZE) ? valvsz >> 1 : BLKSIZE;
     if (valcnt > valvsz) valvsz = valcnt;
-    n   = valvsz -dvec->valcnt; /* get the number of new elements */
-    bsz = valvsz *2 *sizeof(double);                     
-    for (discd = dvec->discds +(i = clscnt); --i >= 0; ) {
+    frq = (double*)_alloc(nbc, (size_t)nbc->clscnt *valvsz *3);
+    if (!frq) return -1;        /* get new value frequency vectors */
+    for (k = nbc->clscnt *valvsz *3; --k >= 0; )
+      frq[k] = 0;               /* clear the new vectors */
+    for (discd = dvec->discds +(i = nbc->clscnt); --i >= 0; ) {
       --discd;                  /* traverse the discrete distribs. */
-      frq = (double*)realloc(discd->frqs, bsz);
-      if (!frq) break;          /* resize the value freq. vector */
-      discd->frqs  = frq;       /* and the probabilities vector */
-      discd->probs = frq +valvsz;    /* and set the new vectors */
-      for (frq += valvsz, k = n; --k >= 0; )
-        *--frq = 0;             /* clear the new vector elements */
-    }
-    if (i < 0) {                /* if an error occurred */
-      bsz = dvec->valvsz *2 *sizeof(double);
-      for (i = clscnt -i -1; --i >= 0; ) {
-        ++discd;                /* traverse the processed distribs. */
-        discd->frqs  = (double*)realloc(discd->frqs, bsz);
-        discd->probs = discd->frqs +dvec->valvsz;
-      }                         /* shrink all value freq. vectors */
-      return -1;                /* to their old size */
-    }                           /* and then abort */
-  }
+      k = i *valvsz *3;         /* copy the old value frequencies */
+      if (discd->frqs) memcpy(frq +k, discd->frqs,
+                              dvec->valvsz *sizeof(double));
+      _free(nbc, discd->frqs, (size_t)dvec->valvsz *3);
+      discd->frqs   = frq +k;   /* set the new value freq. vector */
+      discd->probs  = discd->frqs  +valvsz;
+      discd->lprobs = discd->probs +valvsz;
+    }                           /* set the probabilities vectors */
+    dvec->valvsz = valvsz;      /* (the old vectors are returned */
+  }                             /* to the memory slabs for reuse) */
   dvec->valcnt = valcnt;        /* set the new number of values */
   return 0;                     /* return 'ok' */
 }  /* _valrsz() */
 
+/*--------------------------------------------------------------------*/
+
+static int _add (NBC *nbc, int attid, int cls, float wgt,
+                 const INST *inst)
+{                               /* --- add a value for one attribute */
+  DVEC   *dvec;                 /* distribution vector of attribute */
+  NORMD  *normd;                /* to access normal   distributions */
+  DISCD  *discd;                /* to access discrete distributions */
+  double v;                     /* buffer (for an attribute value) */
+
+  assert(nbc && inst            /* check the function arguments */
+      && (attid >= 0) && (attid < nbc->attcnt)
+      && (cls   >= 0) && (cls   < nbc->clscnt));
+  dvec = nbc->dvecs +attid;     /* get the distribution vector */
+  assert(dvec->type != 0);      /* and check the attribute type */
+  if (dvec->type == AT_NOM) {   /* -- if the attribute is nominal */
+    if (inst->i < 0)            /* if the attribute value is null, */
+      return 0;                 /* there is nothing to do */
+    if (_attown(nbc, dvec) != 0) return -1;
+    if (!dvec->discds) {        /* if the attribute has no data yet, */
+      if ((wgt < 0) && !(nbc->hmode & NBC_HSIGN))
+        return 0;               /* there is nothing to remove */
+      if (_attinit(nbc, dvec) != 0) return -1;
+    }                           /* create the distributions */
+    if (inst->i >= dvec->valcnt) {
+      if ((wgt < 0) && !(nbc->hmode & NBC_HSIGN))
+        return 0;               /* a value that was never added */
+      if (_valrsz(nbc, dvec, inst->i+1) != 0)
+        return -1;              /* cannot be removed, otherwise */
+    }                           /* resize the value freq. vectors */
+    discd = dvec->discds +cls;     /* get the proper distribution */
+    discd->frqs[inst->i] += wgt;   /* and update the value frequency */
+    discd->cnt += wgt; }           /* and the total frequency */
+  else {                        /* -- if the attribute is numeric */
+    if (dvec->type == AT_REAL){ /* if the attribute is real valued */
+      if (inst->f <= NV_REAL) return 0;
+      v = (double)inst->f; }    /* check and get the attribute value */
+    else {                      /* if the attribute is integer valued */
+      if (inst->i <= NV_INT)  return 0;
+      v = (double)inst->i;      /* check and get the attribute value */
+    }                           /* (convert it to double) */
+    if (_attown(nbc, dvec) != 0) return -1;
+    if (!dvec->normds) {        /* if the attribute has no data yet, */
+      if (wgt < 0) return 0;    /* there is nothing to remove */
+      if (_attinit(nbc, dvec) != 0) return -1;
+    }                           /* create the distributions */
+    normd = dvec->normds +cls;  /* get the proper distribution */
+    normd->cnt += wgt;          /* update the case counter */
+    normd->sv  += wgt *v;       /* the sum of the values, and */
+    normd->sv2 += wgt *v*v;     /* the sum of their squares */
+  }                             /* (expected value and variance */
+                                /*  are computed in nbc_setup) */
+  if ((nbc->dcnt >= 0) && !dvec->dirty) {
+    dvec->dirty = 1;            /* note the attribute as changed */
+    nbc->dlist[nbc->dcnt++] = attid;
+  }                             /* (for an incremental setup) */
+  return 0;                     /* return 'ok' */
+}  /* _add() */
+
 #endif
 /*--------------------------------------------------------------------*/
 
-static int _exec (const NBC *nbc, int attid, const INST *inst)
+static int _exec (const NBC *nbc, int attid, const INST *inst,
+                  double *cond)
 {                               /* --- execute for one attribute */
   int         i, k;             /* loop variable, buffer */
   const DVEC  *dvec;            /* to traverse the distrib. vectors */
   const NORMD *normd;           /* to traverse the normal   distribs. */
   const DISCD *discd;           /* to traverse the discrete distribs. */
   double      *prob;            /* to traverse the class probs. */
-  double      v, d, s;          /* temporary buffers */
+  double      v, d;             /* temporary buffers */
 
-  assert(nbc && inst            /* check the function arguments */
+  assert(nbc && inst && cond    /* check the function arguments */
       && (attid >= 0) && (attid < nbc->attcnt));
   dvec = nbc->dvecs +attid;     /* get the distribution vector */
   assert(dvec->type != 0);      /* and check the attribute type */
@@ -193,11 +710,10 @@ static int _exec (const NBC *nbc, int attid, const INST *inst)
     k = inst->i;                /* get and check the attribute value */
     if ((k < 0) || (k >= dvec->valcnt)) return -1;
     discd = dvec->discds +nbc->clscnt;
-    prob  = nbc->cond    +nbc->clscnt;
-    for (i = nbc->clscnt; --i >= 0; ) {
-      d = (--discd)->probs[k];  /* traverse the discrete distribs. */
-      *--prob = (d > 0) ? d : EPSILON;
-    } }                         /* copy the class probabilities */
+    prob  = cond         +nbc->clscnt;
+    for (i = nbc->clscnt; --i >= 0; )
+      *--prob = (--discd)->lprobs[k]; }
+                                /* copy the log. of the class probs. */
   else {                        /* --- if the attribute is numeric */
     if (dvec->type == AT_REAL){ /* if the attribute is real valued */
       if (inst->f <= NV_REAL) return -1;
@@ -207,19 +723,458 @@ static int _exec (const NBC *nbc, int attid, const INST *inst)
       v = (double)inst->i;      /* check and get the attribute value */
     }                           /* (convert it to double) */
     normd = dvec->normds +nbc->clscnt;
-    prob  = nbc->cond    +nbc->clscnt;
+    prob  = cond         +nbc->clscnt;
+    if ((nbc->mode & NBC_MULTI) && (dvec->type == AT_INT)) {
+      if (v <= 0) return -1;    /* if multinomial model for counts */
+      for (i = nbc->clscnt; --i >= 0; )
+        *--prob = v *(--normd)->lnrm;
+      return 0;                 /* multiply the log. of the token */
+    }                           /* probability with the count */
     for (i = nbc->clscnt; --i >= 0; ) {
       d = v -(--normd)->exp;    /* traverse the normal distributions */
-      s = 2 *normd->var;        /* and get their parameters */
-      if (s < EPSILON) s = EPSILON;
-      *--prob = exp(-d*d/s) /sqrt(M_PI*s);
-    }                           /* compute the probability density */
+      *--prob = normd->lnrm -d*d *normd->ivar;
+    }                           /* compute the log. of the density */
   }                             /* at the value of the attribute */
   return 0;                     /* return 'ok' */
 }  /* _exec() */
 
 /*--------------------------------------------------------------------*/
 
+static void _init (const NBC *nbc, double *posts)
+{                               /* --- initialize the log. posteriors */
+  int          k;               /* loop variable */
+  const double *s;              /* to traverse the prior probs. */
+
+  assert(nbc && posts);         /* check the function arguments */
+  s = nbc->lpriors +nbc->clscnt;/* init. the posterior distribution */
+  posts += nbc->clscnt;         /* with  the prior     distribution */
+  for (k = nbc->clscnt; --k >= 0; ) *--posts = *--s;
+}  /* _init() */
+
+/*--------------------------------------------------------------------*/
+
+static void _mult (double *posts, const double *cond, int clscnt)
+{                               /* --- multiply with cond. probs. */
+  assert(posts && cond);        /* check the function arguments */
+  posts += clscnt;              /* traverse the posterior distrib. */
+  cond  += clscnt;              /* and the cond. probabilities */
+  while (--clscnt >= 0)         /* and add the logarithms */
+    *--posts += *--cond;        /* of the cond. probabilities */
+}  /* _mult() */
+
+/*--------------------------------------------------------------------*/
+
+static int _norm (double *posts, int clscnt, double *conf)
+{                               /* --- normalize the posterior dist. */
+  int    k;                     /* loop variable */
+  double *s, *d;                /* to traverse the probabilities */
+  double max, sum;              /* maximum and sum of probabilities */
+
+  assert(posts && (clscnt > 0));/* check the function arguments */
+  s = d = posts;                /* traverse the log. posteriors */
+  for (k = clscnt; --k > 0; )
+    if (*++s > *d) d = s;       /* find the most probable class */
+  max = *d;                     /* note the maximum log. posterior */
+  if (max < -DBL_MAX) {         /* if all classes are impossible, */
+    for (k = clscnt; --k >= 0; )
+      posts[k] = 0;             /* clear the posterior distribution */
+    if (conf) *conf = 0;        /* clear the confidence value and */
+    return 0;                   /* return the first class */
+  }                             /* (as no class can be predicted) */
+  s = posts +clscnt;            /* traverse the log. posteriors */
+  for (sum = 0, k = clscnt; --k >= 0; ) {
+    --s; sum += *s = exp(*s -max);
+  }                             /* exponentiate relative to maximum */
+  sum = 1/sum;                  /* compute normalization factor */
+  for (k = clscnt; --k >= 0; )
+    posts[k] *= sum;            /* normalize probabilities */
+  if (conf) *conf = *d;         /* get the confidence value and */
+  return (int)(d -posts);       /* return the classification result */
+}  /* _norm() */
+
+/*--------------------------------------------------------------------*/
+
+static void _plandel (NBCPLAN *plan)
+{                               /* --- delete an execution plan */
+  assert(plan);                 /* check the function argument */
+  free(plan->tabs);             /* delete the attribute tables */
+  free(plan);                   /* and the plan body */
+}  /* _plandel() */
+
+/*--------------------------------------------------------------------*/
+
+static NBCPLAN* _plancopy (const NBCPLAN *plan)
+{                               /* --- copy a plan of a binary file */
+  NBCPLAN *copy;                /* created copy of the plan */
+  size_t  z;                    /* size of the plan body */
+
+  assert(plan && !plan->tabs);  /* check the function argument */
+  z = sizeof(NBCPLAN) +((plan->cnt > 0) ? plan->cnt-1 : 0) *sizeof(CATT);
+  copy = (NBCPLAN*)malloc(z);   /* create a plan body and copy the */
+  if (!copy) return NULL;       /* compiled attributes (the tables */
+  memcpy(copy, plan, z);        /* are in the binary model file, */
+  return copy;                  /* which is shared with the clone) */
+}  /* _plancopy() */
+
+/*--------------------------------------------------------------------*/
+
+static void _cexec (const NBC *nbc, const INST *insts, int step,
+                    double *posts)
+{                               /* --- execute a compiled plan */
+  int          i, k, c;         /* loop variables, buffer */
+  int          clscnt;          /* number of classes */
+  const CATT   *att;            /* to traverse the compiled atts. */
+  const INST   *inst;           /* attribute instantiation */
+  const double *tab;            /* to traverse the attribute tables */
+  const float  *f32;            /* to traverse a float table */
+  const unsigned short *q16;    /* to traverse a 16 bit table */
+  const unsigned char  *q8;     /* to traverse an 8 bit table */
+  double       v, d;            /* attribute value, buffer */
+
+  assert(nbc && nbc->plan && posts);  /* check the arguments */
+  clscnt = nbc->clscnt;         /* get the number of classes */
+  att    = nbc->plan->atts;     /* traverse the compiled attributes */
+  for (i = nbc->plan->cnt; --i >= 0; att++) {
+    inst = (insts)              /* get the attribute instantiation */
+         ? insts +(size_t)att->attid *step
+         : att_inst(as_att(nbc->attset, att->attid));
+    if (att->type == AT_NOM) {  /* -- if the attribute is nominal */
+      k = inst->i;              /* get and check the attribute value */
+      if ((k < 0) || (k >= att->valcnt)) continue;
+      switch (nbc->quant) {     /* evaluate the quantization mode */
+        case NBC_F32:           /* if 32 bit floats */
+          f32 = (const float*)att->tab +(size_t)k *clscnt;
+          for (c = clscnt; --c >= 0; ) posts[c] += f32[c];
+          break;                /* add the log. of the cond. probs. */
+        case NBC_Q16:           /* if 16 bit fixed-point numbers */
+          q16 = (const unsigned short*)att->tab +(size_t)k *clscnt;
+          for (c = clscnt; --c >= 0; ) posts[c] -= q16[c] *att->scale;
+          break;                /* subtract the scaled distances */
+        case NBC_Q8:            /* if  8 bit fixed-point numbers */
+          q8  = (const unsigned char*) att->tab +(size_t)k *clscnt;
+          for (c = clscnt; --c >= 0; ) posts[c] -= q8[c]  *att->scale;
+          break;                /* (to the row maximum) */
+        default:                /* if doubles (no quantization) */
+          tab = (const double*)att->tab +(size_t)k *clscnt;
+          for (c = clscnt; --c >= 0; ) posts[c] += tab[c];
+          break;                /* add the log. of the cond. probs. */
+      } }
+    else {                      /* -- if the attribute is numeric */
+      if (att->type == AT_REAL){/* if the attribute is real valued */
+        if (inst->f <= NV_REAL) continue;
+        v = (double)inst->f; }  /* check and get the attribute value */
+      else {                    /* if the attribute is integer valued */
+        if (inst->i <= NV_INT)  continue;
+        v = (double)inst->i;    /* check and get the attribute value */
+      }                         /* (convert it to double) */
+      tab = (const double*)att->tab +3 *clscnt;
+      if ((nbc->mode & NBC_MULTI) && (att->type == AT_INT)) {
+        if (v <= 0) continue;   /* if multinomial model for counts, */
+        for (c = clscnt; --c >= 0; ) {  /* add the count times */
+          tab -= 3; posts[c] += v *tab[2]; }
+        continue;               /* the log. of the token probability */
+      }                         /* (stored in place of lnrm) */
+      for (c = clscnt; --c >= 0; ) {  /* traverse the normal dists. */
+        tab -= 3; d = v -tab[0];/* (exp, ivar, lnrm) per class */
+        posts[c] += tab[2] -d*d *tab[1];
+      }                         /* add the log. of the density */
+    }                           /* (same computation as in _exec, */
+  }                             /* so that the results are identical) */
+}  /* _cexec() */
+
+/*--------------------------------------------------------------------*/
+
+static void _logpost (const NBC *nbc, const INST *insts,
+                      double *posts, double *cond)
+{                               /* --- compute log. posteriors */
+  int        i;                 /* loop variable */
+  const DVEC *dvec;             /* to traverse the distrib. vectors */
+  const INST *inst;             /* to traverse the instances */
+
+  assert(nbc && posts && cond); /* check the function arguments */
+  _init(nbc, posts);            /* start with the prior distribution */
+  if (nbc->plan) {              /* if there is a compiled plan, */
+    _cexec(nbc, insts, 1, posts); return; }  /* execute it */
+  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
+    if (((--dvec)->type == 0)   /* traverse all attributes */
+    ||  (   dvec ->mark <  0))  /* except the class attribute */
+      continue;                 /* and all unmarked attributes */
+    inst = (insts)              /* get the attribute instantiation */
+         ? insts +i             /* from the instances or att. set */
+         : att_inst(as_att(nbc->attset, i));
+    if (_exec(nbc, i, inst, cond) == 0)
+      _mult(posts, cond, nbc->clscnt);
+  }                             /* execute the classifier for the */
+}  /* _logpost() */             /* attribute and add the log. probs. */
+
+/*--------------------------------------------------------------------*/
+
+static void _ccol (const NBC *nbc, const CATT *att,
+                   const INST *col, int n, double *scores)
+{                               /* --- execute a compiled attribute */
+  int          k, c, t;         /* loop variables, buffer */
+  int          clscnt;          /* number of classes */
+  size_t       z;               /* size of a table row */
+  const double *tab;            /* to traverse the attribute table */
+  const float  *f32;            /* to traverse a float table */
+  const unsigned short *q16;    /* to traverse a 16 bit table */
+  const unsigned char  *q8;     /* to traverse an 8 bit table */
+  double       *s;              /* to traverse the log. posteriors */
+  double       v, d;            /* attribute value, buffer */
+
+  assert(nbc && att && col && scores);  /* check the arguments */
+  clscnt = nbc->clscnt;         /* get the number of classes */
+  z      = (size_t)clscnt;      /* and the size of a table row */
+  if (att->type == AT_NOM) {    /* -- if the attribute is nominal */
+    for (c = clscnt; --c >= 0; ) {
+      s = scores +(size_t)c *n; /* traverse the classes */
+      switch (nbc->quant) {     /* evaluate the quantization mode */
+        case NBC_F32:           /* if 32 bit floats */
+          f32 = (const float*)att->tab +c;
+          for (t = n; --t >= 0; ) {
+            k = col[t].i;       /* get and check the attribute value */
+            if ((k >= 0) && (k < att->valcnt)) s[t] += f32[k*z];
+          } break;              /* add the log. of the cond. prob. */
+        case NBC_Q16:           /* if 16 bit fixed-point numbers */
+          q16 = (const unsigned short*)att->tab +c;
+          for (t = n; --t >= 0; ) {
+            k = col[t].i;       /* get and check the attribute value */
+            if ((k >= 0) && (k < att->valcnt))
+              s[t] -= q16[k*z] *att->scale;
+          } break;              /* subtract the scaled distance */
+        case NBC_Q8:            /* if  8 bit fixed-point numbers */
+          q8  = (const unsigned char*) att->tab +c;
+          for (t = n; --t >= 0; ) {
+            k = col[t].i;       /* get and check the attribute value */
+            if ((k >= 0) && (k < att->valcnt))
+              s[t] -= q8[k*z]  *att->scale;
+          } break;              /* subtract the scaled distance */
+        default:                /* if doubles (no quantization) */
+          tab = (const double*)att->tab +c;
+          for (t = n; --t >= 0; ) {
+            k = col[t].i;       /* get and check the attribute value */
+            if ((k >= 0) && (k < att->valcnt)) s[t] += tab[k*z];
+          } break;              /* add the log. of the cond. prob. */
+      }                         /* (same computations as in _cexec, */
+    }                           /* so that the results of nbc_exec */
+    return;                     /* are reproduced exactly) */
+  }
+  for (c = clscnt; --c >= 0; ) {/* -- if the attribute is numeric */
+    tab = (const double*)att->tab +3 *(size_t)c;
+    s   = scores +(size_t)c *n; /* (exp, ivar, lnrm) of the class */
+    for (t = n; --t >= 0; ) {   /* traverse the tuples */
+      if (att->type == AT_REAL) {   /* if real valued attribute */
+        if (col[t].f <= NV_REAL) continue;
+        v = (double)col[t].f; }     /* check and get the value */
+      else {                        /* if integer valued attribute */
+        if (col[t].i <= NV_INT)  continue;
+        v = (double)col[t].i;       /* check and get the value */
+      }                             /* (convert it to double) */
+      if ((nbc->mode & NBC_MULTI) && (att->type == AT_INT)) {
+        if (v > 0) s[t] += v *tab[2];
+        continue;               /* if multinomial model for counts, */
+      }                         /* add count times log. token prob. */
+      d = v -tab[0];            /* add the log. of the density */
+      s[t] += tab[2] -d*d *tab[1];
+    }
+  }
+}  /* _ccol() */
+
+/*--------------------------------------------------------------------*/
+
+static void _dcol (const NBC *nbc, const DVEC *dvec,
+                   const INST *col, int n, double *scores)
+{                               /* --- execute an attribute */
+  int         k, c, t;          /* loop variables, buffer */
+  int         multi;            /* whether multinomial for counts */
+  const NORMD *normd;           /* to traverse the normal distribs. */
+  const double *lpr;            /* to traverse the log. probs. */
+  double      *s;               /* to traverse the log. posteriors */
+  double      v, d;             /* attribute value, buffer */
+
+  assert(nbc && dvec && col && scores);  /* check the arguments */
+  if (dvec->type == AT_NOM) {   /* -- if the attribute is nominal */
+    for (c = nbc->clscnt; --c >= 0; ) {
+      lpr = dvec->discds[c].lprobs;   /* traverse the classes */
+      s   = scores +(size_t)c *n;     /* and the tuples */
+      for (t = n; --t >= 0; ) {
+        k = col[t].i;           /* get and check the attribute value */
+        if ((k >= 0) && (k < dvec->valcnt)) s[t] += lpr[k];
+      }                         /* add the log. of the cond. prob. */
+    }
+    return;                     /* abort the function */
+  }
+  multi = (nbc->mode & NBC_MULTI) && (dvec->type == AT_INT);
+  for (c = nbc->clscnt; --c >= 0; ) { /* -- if attribute is numeric */
+    normd = dvec->normds +c;          /* traverse the classes */
+    s     = scores +(size_t)c *n;     /* and the tuples */
+    for (t = n; --t >= 0; ) {
+      if (dvec->type == AT_REAL) {    /* if real valued attribute */
+        if (col[t].f <= NV_REAL) continue;
+        v = (double)col[t].f; }       /* check and get the value */
+      else {                          /* if integer valued att. */
+        if (col[t].i <= NV_INT)  continue;
+        v = (double)col[t].i;         /* check and get the value */
+      }                               /* (convert it to double) */
+      if (multi) {              /* if multinomial model for counts, */
+        if (v > 0) s[t] += v *normd->lnrm;
+        continue;               /* add the count times the log. */
+      }                         /* of the token probability */
+      d = v -normd->exp;        /* add the log. of the density */
+      s[t] += normd->lnrm -d*d *normd->ivar;
+    }                           /* (same computation as in _exec, */
+  }                             /* so that the results of nbc_exec */
+}  /* _dcol() */                /* are reproduced exactly) */
+
+/*--------------------------------------------------------------------*/
+
+static int _batch (const NBC *nbc, TUPLE *const *tpls,
+                   const INST *cols, int n,
+                   int *classes, double *confs, double *posts)
+{                               /* --- execute on a block of tuples */
+  int         i, k, c, t;       /* loop variables, buffers */
+  int         clscnt;           /* number of classes */
+  const DVEC  *dvec;            /* to traverse the distrib. vectors */
+  const CATT  *catt;            /* to traverse the compiled atts. */
+  const INST  *col;             /* column of attribute instances */
+  INST        *buf = NULL;      /* buffer for a column of instances */
+  double      *scores;          /* log. posteriors (class major) */
+  double      *s, *row;         /* to traverse the log. posteriors */
+
+  assert(nbc && (tpls || cols) && (n > 0) && classes);
+  clscnt = nbc->clscnt;         /* get the number of classes */
+  scores = (double*)malloc((size_t)(n+1) *clscnt *sizeof(double));
+  if (!scores) return -1;       /* allocate the log. posteriors */
+  if (tpls) {                   /* if tuples are given, */
+    buf = (INST*)malloc((size_t)n *sizeof(INST));
+    if (!buf) { free(scores); return -1; }
+  }                             /* create a column buffer */
+
+  /* --- initialize --- */
+  for (c = clscnt; --c >= 0; ){ /* traverse the classes and */
+    s = scores +(size_t)c *n;   /* init. the posterior distributions */
+    for (t = n; --t >= 0; ) s[t] = nbc->lpriors[c];
+  }                             /* with the prior distribution */
+
+  /* --- process attribute values --- */
+  catt = (nbc->plan) ? nbc->plan->atts : NULL;
+  dvec = nbc->dvecs +nbc->attcnt;
+  for (i = (catt) ? nbc->plan->cnt : nbc->attcnt; --i >= 0; ) {
+    if (catt)                   /* if there is a compiled plan, */
+      k = catt->attid;          /* traverse the compiled attributes */
+    else {                      /* otherwise traverse all attributes */
+      if (((--dvec)->type == 0) /* except the class attribute */
+      ||  (   dvec ->mark <  0))/* and all unmarked attributes */
+        continue;               /* (in the same order as _cexec */
+      k = i;                    /*  and _logpost, respectively, */
+    }                           /*  so that the sums are identical) */
+    if (!tpls)                  /* get the instances of the attribute */
+      col = cols +(size_t)k *n; /* from the column block */
+    else {                      /* or from the tuples */
+      for (t = n; --t >= 0; ) buf[t] = *tpl_colval(tpls[t], k);
+      col = buf;                /* collect the attribute instances */
+    }                           /* in the column buffer */
+    if (catt) _ccol(nbc, catt++, col, n, scores);
+    else      _dcol(nbc, dvec,   col, n, scores);
+  }                             /* add the log. probabilities */
+
+  /* --- normalize the posterior distributions --- */
+  for (t = 0; t < n; t++) {     /* traverse the tuples */
+    row = (posts) ? posts +(size_t)t *clscnt : scores +(size_t)n *clscnt;
+    for (c = clscnt; --c >= 0; ) row[c] = scores[(size_t)c *n +t];
+    classes[t] = _norm(row, clscnt, (confs) ? confs +t : NULL);
+  }                             /* compute the classification */
+  if (buf) free(buf);           /* delete the column buffer */
+  free(scores);                 /* and the log. posteriors */
+  return 0;                     /* return 'ok' */
+}  /* _batch() */
+
+/*--------------------------------------------------------------------*/
+
+static int _estim (NBC *nbc, int attid, int mode, double lcorr,
+                   const double *tsum)
+{                               /* --- estimate cond. probabilities */
+  int    k, n;                  /* loop variables */
+  DVEC   *dvec;                 /* distribution vector of attribute */
+  NORMD  *normd;                /* to traverse the normal   distribs. */
+  DISCD  *discd;                /* to traverse the discrete distribs. */
+  double *frq, *prb, *lpr;      /* to traverse the value frqs./probs. */
+  double cnt, sp;               /* number of cases, sum of priors */
+  double sum;                   /* sum of the value frequencies */
+  double add;                   /* Laplace corr. + distributed weight */
+  double leps;                  /* logarithm of EPSILON */
+
+  assert(nbc && (lcorr >= 0)    /* check the function arguments */
+      && (attid >= 0) && (attid < nbc->attcnt));
+  dvec = nbc->dvecs +attid;     /* get the distribution vector */
+  assert(dvec->type != 0);      /* and check the attribute type */
+  leps = log(EPSILON);          /* (log. prob. of impossible values) */
+  if      (mode & NBC_ALL)      /* if to use all attributes, */
+    dvec->mark = 1;             /* mark attribute as used */
+  else if (mode & NBC_MARKED)   /* if to use only marked atts. */
+    dvec->mark = (att_getmark(as_att(nbc->attset, attid)) >= 0)
+               ? 1 : -1;        /* get the attribute mark */
+  if (dvec->mark < 0)           /* otherwise keep the */
+    return 0;                   /* selection of attributes */
+  if ((_attown (nbc, dvec) != 0)   /* unshare the distributions */
+  ||  (_attinit(nbc, dvec) != 0))  /* or create them for attributes */
+    return -1;                  /* without any data (if necessary) */
+  if (dvec->type == AT_NOM) {   /* -- if the attribute is nominal */
+    if (dvec->valcnt <= 0) {    /* if the attribute has no values, */
+      dvec->mark = -1; return 0; }     /* there is nothing to do */
+    sp = dvec->valcnt *lcorr;   /* compute the sum of the priors */
+    for (discd = dvec->discds +(k = nbc->clscnt); --k >= 0; ) {
+      --discd;                  /* traverse the distributions */
+      n   = dvec->valcnt;       /* get the number of att. values */
+      prb = discd->probs +n;    /* and the probability vector */
+      if (nbc->hmode & NBC_HSIGN) {   /* if signed frequencies, */
+        for (sum = 0, frq = discd->frqs +n; --n >= 0; )
+          sum += fabs(*--frq);  /* sum their magnitudes (colliding */
+        n = dvec->valcnt; }     /* tokens with opposite signs cancel */
+      else                      /* each other's frequencies) */
+        sum = discd->cnt;       /* get the frequency of the values */
+      add = (mode & NBC_DWNULL) ? nbc->frqs[k] : sum;
+      if (add < sum) add = sum; /* (collisions within a tuple) */
+      cnt = sp +add;            /* compute denominator of estimator */
+      if (cnt <= 0)             /* if the estimator is invalid, */
+        while (--n >= 0) *--prb = 0;        /* clear all probs. */
+      else {                    /* if the estimator is valid */
+        add = lcorr +(add -sum) /n;
+        if (nbc->hmode & NBC_HSIGN)
+          for (frq = discd->frqs +n; --n >= 0; )
+            *--prb = (fabs(*--frq) +add) /cnt;
+        else                    /* distribute the weight of */
+          for (frq = discd->frqs +n; --n >= 0; )
+            *--prb = (*--frq +add) /cnt;
+      }                         /* the null values uniformly */
+      lpr = discd->lprobs +(n = dvec->valcnt);
+      for (prb += n; --n >= 0; ) {    /* compute the logarithms */
+        --prb; *--lpr = (*prb > 0) ? log(*prb) : leps; }
+    } }                         /* and estimate the probabilities */
+  else {                        /* -- if the attribute is numeric */
+    for (normd = dvec->normds +(k = nbc->clscnt); --k >= 0; ) {
+      cnt = (--normd)->cnt;     /* traverse the distributions */
+      normd->exp = (cnt > 0) ? normd->sv /cnt : 0;
+      if (!(mode & NBC_MAXLLH)) cnt -= 1;
+      normd->var = (cnt > 0)
+                 ? (normd->sv2 -normd->exp *normd->sv) /cnt : 0;
+      sp = 2 *normd->var;       /* estimate the expected value */
+      if (sp < EPSILON) sp = EPSILON;       /* and the variance */
+      normd->ivar = 1/sp;       /* and compute the parameters */
+      normd->lnrm = -0.5 *log(M_PI *sp);    /* of the log. density */
+      if (!tsum || (dvec->type != AT_INT))  /* ln f(x) = lnrm */
+        continue;               /* -(x-exp)^2 *ivar */
+      cnt = normd->sv +lcorr;   /* if multinomial model for counts, */
+      normd->ivar = 0;          /* estimate the token probability */
+      normd->lnrm = ((cnt > 0) && (tsum[k] > 0))
+                  ? log(cnt /tsum[k]) : leps;
+    }                           /* (expected value and variance */
+  }                             /*  are kept for nbc_rand) */
+  return 0;                     /* return 'ok' */
+}  /* _estim() */
+
+/*--------------------------------------------------------------------*/
+
 static double _normd (double drand (void))
 {                               /* --- compute N(0,1) distrib. number */
   static double b;              /* buffer for random number */
@@ -240,48 +1195,177 @@ static double _normd (double drand (void))
 /*--------------------------------------------------------------------*/
 #ifdef NBC_INDUCE
 
-static int _eval (NBC *nbc, TABLE *table, int mode,
-                  SELATT *savec, int cnt)
-{                               /* --- evaluate selectable attributes */
-  int    i, k, n;               /* loop variables, buffers */
-  SELATT *sa;                   /* to traverse the selectable atts. */
-  TUPLE  *tpl;                  /* to traverse the tuples */
-  double *s, *d;                /* to traverse the probabilities */
-  double max, tmp;              /* maximum of probabilities, buffer */
-  int    old, new;              /* old and new predicted class */
-  int    cls;                   /* actual class of a tuple */
-
-  assert(nbc && table && savec  /* check the function arguments */
-     && (cnt > 0) && (mode & (NBC_ADD|NBC_REMOVE)));
-  for (n = tab_tplcnt(table); --n >= 0; ) {
-    tpl = tab_tpl(table, n);    /* traverse the tuples in the table */
+static void _evalblk (const NBC *nbc, TABLE *table, int mode,
+                      const SELATT *savec, int cnt, int lo, int hi,
+                      const double *lps, double *errs, double *cond)
+{                               /* --- evaluate on a block of tuples */
+  int          i, k, n;         /* loop variables, buffers */
+  const SELATT *sa;             /* to traverse the selectable atts. */
+  double       *e;              /* to traverse the error counters */
+  TUPLE        *tpl;            /* to traverse the tuples */
+  const double *posts;          /* log. posteriors of a tuple */
+  const double *s, *d;          /* to traverse the probabilities */
+  double       max, tmp;        /* maximum of probabilities, buffer */
+  int          old, new;        /* old and new predicted class */
+  int          cls;             /* actual class of a tuple */
+
+  for (n = hi; --n >= lo; ) {   /* traverse the tuples of the block */
+    tpl = tab_tpl(table, n);    /* (in the same order as serially) */
     cls = tpl_colval(tpl, nbc->clsid)->i;
     if (cls < 0) continue;      /* skip tuples with an null class */
-    old = nbc_exec(nbc, tpl, NULL);
+    posts = lps +(size_t)n *nbc->clscnt;   /* get the cached */
+    for (s = d = posts, k = nbc->clscnt; --k > 0; )  /* log. posts. */
+      if (*++s > *d) d = s;     /* find the most probable class */
+    old = (int)(d -posts);      /* (classify the tuple) */
+    e   = errs +cnt;            /* traverse the error counters */
     for (sa = savec +(i = cnt); --i >= 0; ) {
-      --sa;                     /* traverse the selectable attributes */
-      if (_exec(nbc, sa->attid, tpl_colval(tpl, sa->attid)) != 0)
+      --sa; --e;                /* traverse the selectable attributes */
+      if (_exec(nbc, sa->attid, tpl_colval(tpl, sa->attid),
+                cond) != 0)
         new = old;              /* evaluate the classifier and */
       else {                    /* on failure use the old class */
-        s = nbc->cond;          /* if a probability distribution */
-        d = nbc->posts;         /* could be determined, traverse it */
+        s = cond;               /* if a probability distribution */
+        d = posts;              /* could be determined, traverse it */
         if (mode & NBC_ADD) {   /* if to add attributes, */
-          max = *d * *s;        /* multiply with cond. probability */
+          max = *d + *s;        /* add the log. of the cond. prob. */
           for (new = 0, k = 1; k < nbc->clscnt; k++) {
-            tmp = *++d * *++s;  /* compute new probability */
+            tmp = *++d + *++s;  /* compute new log. probability */
             if (tmp > max) { max = tmp; new = k; }
           } }                   /* find the most probable class */
         else {                  /* if to remove attributes, */
-          max = *d / *s;        /* divide by cond. probability */
+          max = *d - *s;        /* subtract the log. of cond. prob. */
           for (new = 0, k = 1; k < nbc->clscnt; k++) {
-            tmp = *++d / *++s;  /* compute new probability */
+            tmp = *++d - *++s;  /* compute new log. probability */
             if (tmp > max) { max = tmp; new = k; }
           }                     /* find the most probable class */
         }                       /* for the current tuple */
       }                         /* (det. new classification result) */
-      if (new != cls) sa->errs += tpl_getwgt(tpl);
+      if (new != cls) *e += tpl_getwgt(tpl);
     }                           /* count the misclassifications */
   }                             /* of the modified classifier */
+}  /* _evalblk() */
+
+/*--------------------------------------------------------------------*/
+
+static void _evaljob (EVALJOB *job)
+{                               /* --- process an evaluation job */
+  int b, n;                     /* loop variable, number of tuples */
+  int lo, hi;                   /* range of tuples of a block */
+
+  assert(job);                  /* check the function argument */
+  n = tab_tplcnt(job->table);   /* get the number of tuples */
+  for (b = job->first; b < job->blkcnt; b += job->step) {
+    hi = (int)(((double)n *(job->blkcnt -b))    /* compute the */
+             / job->blkcnt);    /* tuple range of the block */
+    lo = (int)(((double)n *(job->blkcnt -b-1))  /* (block 0 holds */
+             / job->blkcnt);    /* the last tuples of the table) */
+    _evalblk(job->nbc, job->table, job->mode, job->savec, job->cnt,
+             lo, hi, job->lps, job->errs +(size_t)b *job->cnt,
+             job->buf);
+  }                             /* evaluate on the tuple blocks */
+}  /* _evaljob() */              /* assigned to this job */
+
+/*--------------------------------------------------------------------*/
+#ifdef NBC_THREADS
+
+static void* _evalthd (void *job)
+{                               /* --- thread function for eval. */
+  _evaljob((EVALJOB*)job);      /* process the evaluation job */
+  return NULL;                  /* and return a dummy result */
+}  /* _evalthd() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static void _update (NBC *nbc, TABLE *table, double *lps,
+                     int attid, int mode)
+{                               /* --- update cached log. posteriors */
+  int          k, n;            /* loop variables */
+  double       *p;              /* to traverse the log. posteriors */
+  const double *c;              /* to traverse the cond. probs. */
+
+  assert(nbc && table && lps    /* check the function arguments */
+      && (attid >= 0) && (attid < nbc->attcnt));
+  for (n = tab_tplcnt(table); --n >= 0; ) {
+    if (_exec(nbc, attid, tpl_colval(tab_tpl(table, n), attid),
+              nbc->cond) != 0)  /* traverse the tuples and compute */
+      continue;                 /* the cond. probs. of the attribute */
+    p = lps +(size_t)(n+1) *nbc->clscnt;
+    c = nbc->cond +nbc->clscnt; /* get the log. posteriors */
+    if (mode & NBC_ADD)         /* if an attribute was added, */
+      for (k = nbc->clscnt; --k >= 0; ) *--p += *--c;
+    else                        /* add its log. cond. probs., */
+      for (k = nbc->clscnt; --k >= 0; ) *--p -= *--c;
+  }                             /* otherwise subtract them */
+}  /* _update() */
+
+/*--------------------------------------------------------------------*/
+
+static int _eval (NBC *nbc, TABLE *table, int mode,
+                  SELATT *savec, int cnt, const double *lps, int thcnt)
+{                               /* --- evaluate selectable attributes */
+  int     i, b;                 /* loop variables */
+  int     blkcnt;               /* number of tuple blocks */
+  EVALJOB *jobs;                /* evaluation jobs (one per thread) */
+  double  *errs;                /* error counters of the blocks */
+  double  *bufs;                /* class buffers of the jobs */
+  SELATT  *sa;                  /* to traverse the selectable atts. */
+  #ifdef NBC_THREADS
+  pthread_t *thds;              /* worker threads */
+  #endif
+
+  assert(nbc && table && savec  /* check the function arguments */
+     && (cnt > 0) && (mode & (NBC_ADD|NBC_REMOVE)));
+  #ifndef NBC_THREADS
+  thcnt = 1;                    /* no threads without thread support */
+  #endif
+  if (thcnt > EVALBLKS) thcnt = EVALBLKS;
+  if (thcnt < 1)        thcnt = 1;  /* get the number of threads */
+  blkcnt = EVALBLKS;            /* and use the same tuple blocks */
+                                /* for any number of threads, so */
+                                /* that the error sums are the same */
+  jobs = (EVALJOB*)malloc(thcnt *sizeof(EVALJOB));
+  errs = (double*) calloc((size_t)blkcnt *cnt
+                         +(size_t)thcnt  *nbc->clscnt, sizeof(double));
+  if (!jobs || !errs) {         /* allocate the evaluation jobs */
+    if (jobs) free(jobs);
+    if (errs) free(errs);
+    return -1;                  /* on error delete the vectors */
+  }                             /* and abort the function */
+  bufs = errs +(size_t)blkcnt *cnt;
+  for (i = thcnt; --i >= 0; ) { /* initialize the jobs */
+    jobs[i].nbc    = nbc;    jobs[i].table = table;
+    jobs[i].mode   = mode;   jobs[i].savec = savec;
+    jobs[i].cnt    = cnt;    jobs[i].errs  = errs;
+    jobs[i].blkcnt = blkcnt; jobs[i].first = i;
+    jobs[i].step   = thcnt;  /* blocks are assigned round robin */
+    jobs[i].lps    = lps;
+    jobs[i].buf    = bufs +(size_t)i *nbc->clscnt;
+  }                             /* (the block results do not depend */
+                                /* on the thread scheduling) */
+  #ifdef NBC_THREADS
+  thds = (thcnt > 1)            /* create a thread vector */
+       ? (pthread_t*)malloc(thcnt *sizeof(pthread_t)) : NULL;
+  if (thds) {                   /* if worker threads can be used */
+    for (i = 1; i < thcnt; i++) /* start the worker threads */
+      if (pthread_create(thds +i, NULL, _evalthd, jobs +i) != 0)
+        break;                  /* (the first job is processed */
+    _evaljob(jobs);             /* by the calling thread) */
+    for (b = i; b < thcnt; b++) /* process jobs for which no thread */
+      _evaljob(jobs +b);        /* could be created, then wait */
+    while (--i > 0)             /* for the worker threads */
+      pthread_join(thds[i], NULL);
+    free(thds); }               /* delete the thread vector */
+  else
+  #endif
+  for (i = 0; i < thcnt; i++)   /* if no threads are available, */
+    _evaljob(jobs +i);          /* process the jobs sequentially */
+
+  for (b = 0; b < blkcnt; b++){ /* sum the error counters */
+    for (sa = savec +(i = cnt); --i >= 0; )  /* of the blocks */
+      (--sa)->errs += errs[(size_t)b *cnt +i];
+  }                             /* (in a fixed order, so that */
+  free(errs); free(jobs);       /* the result is deterministic) */
   return 0;                     /* return 'ok' */
 }  /* _eval() */
 
@@ -292,12 +1376,10 @@ static int _eval (NBC *nbc, TABLE *table, int mode,
 
 NBC* nbc_create (ATTSET *attset, int clsid)
 {                               /* --- create a naive Bayes class. */
-  int    i, k, n;               /* loop variables */
+  int    i, k;                  /* loop variables */
   NBC    *nbc;                  /* created classifier */
   ATT    *att;                  /* to traverse the attributes */
   DVEC   *dvec;                 /* to traverse the distrib. vectors */
-  DISCD  *discd;                /* to traverse the discrete distribs. */
-  NORMD  *normd;                /* to traverse the normal   distribs. */
   double *frq;                  /* to traverse the frequency vectors */
 
   assert(attset && (clsid >= 0) /* check the function arguments */
@@ -310,8 +1392,28 @@ NBC* nbc_create (ATTSET *attset, int clsid)
   if (!nbc) return NULL;        /* allocate the classifier body */
   for (dvec = nbc->dvecs +(k = i); --k >= 0; ) {
     (--dvec)->discds = NULL; dvec->normds = NULL;
+    dvec->dirty = dvec->shared = 0;
   }                             /* clear the distribution vectors */
   nbc->attset = attset;         /* (for a proper clean up on error) */
+  nbc->frqs   = NULL;           /* (no class vectors yet) */
+  nbc->slabs  = NULL;           /* (no memory slabs yet) */
+  for (k = NBC_FREES; --k >= 0; ) nbc->frees[k] = NULL;
+  nbc->shr    = NULL;           /* (no shared memory) */
+  nbc->asrefs = NULL;           /* (attribute set is not shared) */
+  nbc->bin    = NULL;           /* (not loaded from a binary file) */
+  nbc->plan   = NULL;           /* (no compiled plan yet) */
+  nbc->quant  = 0;              /* (plan tables are not quantized) */
+  nbc->qerr   = 0;
+  nbc->bktcnt = 0;              /* (no feature hashing) */
+  nbc->seed   = 0;
+  nbc->hmode  = 0;
+  nbc->htset  = NULL;           /* (no token maps yet) */
+  nbc->htcnt  = 0;
+  nbc->htoks  = NULL;
+  nbc->slotcnt = nbc->slotused = nbc->dropped = 0;
+  nbc->ctrcnt  = nbc->ctrused  = 0;   /* (no token tracking) */
+  nbc->minfrq  = 0;
+  nbc->ctrs    = NULL;
   nbc->attcnt = i;              /* and initialize the other fields */
   nbc->clsid  = clsid;
   nbc->clsvsz = att_valcnt(as_att(attset, clsid));
@@ -319,18 +1421,22 @@ NBC* nbc_create (ATTSET *attset, int clsid)
   nbc->total  = 0;
   nbc->lcorr  = 0;
   nbc->mode   = 0;
+  nbc->dcnt   = -1;             /* (no setup has been done yet) */
+  nbc->dlist  = (int*)malloc(i *sizeof(int));
+  if (!nbc->dlist) { nbc_delete(nbc, 0); return NULL; }
 
   /* --- initialize the class distributions --- */
   if (nbc->clscnt <= 0) {       /* if there are no classes, */
-    nbc->frqs   =               /* no class vectors are needed */
+    nbc->frqs   = nbc->lpriors =/* no class vectors are needed */
     nbc->priors = nbc->posts = nbc->cond = NULL; }
   else {                        /* if there are classes, */
     nbc->frqs =                 /* allocate class vectors */
-    frq = (double*)malloc(nbc->clsvsz *4 *sizeof(double));
+    frq = (double*)malloc(nbc->clsvsz *5 *sizeof(double));
     if (!frq) { nbc_delete(nbc, 0); return NULL; }
-    nbc->priors = frq         +nbc->clsvsz;
-    nbc->posts  = nbc->priors +nbc->clsvsz;
-    nbc->cond   = nbc->posts  +nbc->clsvsz;
+    nbc->priors  = frq          +nbc->clsvsz;
+    nbc->lpriors = nbc->priors  +nbc->clsvsz;
+    nbc->posts   = nbc->lpriors +nbc->clsvsz;
+    nbc->cond    = nbc->posts   +nbc->clsvsz;
     for (frq += k = nbc->clsvsz; --k >= 0; )
       *--frq = 0;               /* traverse the frequency vector */
   }                             /* and init. the class frequencies */
@@ -341,54 +1447,114 @@ NBC* nbc_create (ATTSET *attset, int clsid)
     if (i == clsid) {           /* if this is the class attribute, */
       dvec->type = 0; continue;}/* clear the type for easier recogn. */
     att = as_att(attset, i);    /* get the next attribute */
-    dvec->type = att_type(att); /* and its type */
-    if (dvec->type == AT_NOM) { /* -- if the attribute is nominal */
-      dvec->valcnt =            /* set the number of att. values */
-      dvec->valvsz = att_valcnt(att);
-      if (nbc->clscnt <= 0)     /* if there are no classes, */
-        continue;               /* there is nothing else to do */
-      dvec->discds =            /* create a vector of discrete dists. */
-      discd = (DISCD*)calloc(nbc->clsvsz, sizeof(DISCD));
-      if (!discd) { nbc_delete(nbc, 0); return NULL; }
-      if (dvec->valcnt <= 0)    /* if the attribute has no values, */
-        continue;               /* there is nothing else to do */
-      for (discd += k = nbc->clscnt; --k >= 0; ) {
-        (--discd)->frqs =       /* create a value frequency vector */
-        frq = (double*)malloc(dvec->valvsz *2 *sizeof(double));
-        if (!frq) { nbc_delete(nbc, 0); return NULL; }
-        discd->probs = frq +dvec->valvsz;
-        for (frq += n = dvec->valvsz; --n >= 0; )
-          *--frq = 0;           /* traverse the frequency vectors */
-      } }                       /* and init. the value frequencies */
-    else {                      /* -- if the attribute is numeric */
-      dvec->valcnt = dvec->valvsz = 0;
-      if (nbc->clscnt <= 0)     /* if there are no classes, */
-        continue;               /* there is nothing else to do */
-      dvec->normds =            /* create a vector of normal dists. */
-      normd = (NORMD*)malloc(nbc->clsvsz *sizeof(NORMD));
-      if (!normd) { nbc_delete(nbc, 0); return NULL; }
-      for (normd += k = nbc->clsvsz; --k >= 0; ) {
-        (--normd)->cnt = 0; normd->sv = normd->sv2 = 0; }
-    }                           /* clear the sums from which expected */
-  }                             /* value and variance are computed */
-
+    dvec->type   = att_type(att);   /* and its type */
+    dvec->valcnt = (dvec->type == AT_NOM) ? att_valcnt(att) : 0;
+    dvec->valvsz = 0;           /* set the number of att. values */
+  }                             /* (the distributions are created */
+                                /* when the first value is added) */
   return nbc;                   /* return the created classifier */
 }  /* nbc_create() */
 
 /*--------------------------------------------------------------------*/
 
-NBC* nbc_clone (NBC *nbc, int cloneas)
+static NBC* _tokcreate (ATTSET *attset, int clsid, int cnt,
+                        const char *setname)
+{                               /* --- create a token classifier */
+  int    i;                     /* loop variable */
+  ATTSET *hset;                 /* attribute set of the buckets */
+  ATT    *att;                  /* created attribute */
+  NBC    *nbc;                  /* created classifier */
+  char   name[32];              /* buffer for a bucket name */
+
+  assert(attset && (clsid >= 0) /* check the function arguments */
+      && (clsid < as_attcnt(attset)) && (cnt > 0));
+  hset = as_create(setname, att_delete);
+  if (!hset) return NULL;       /* create an attribute set */
+  att = att_clone(as_att(attset, clsid));
+  if (!att) { as_delete(hset); return NULL; }
+  if (as_attadd(hset, att) != 0) {  /* the class attribute is */
+    att_delete(att); as_delete(hset); return NULL; }  /* the first */
+  for (i = 0; i < cnt; i++) {   /* traverse the buckets/slots */
+    sprintf(name, "#%d", i);    /* ('#' starts a comment in tables, */
+    att = att_create(name, AT_NOM);   /* so no token can clash */
+    if (!att) break;                  /* with a bucket name) */
+    if (as_attadd(hset, att) != 0) { att_delete(att); break; }
+  }                             /* create a nominal attribute */
+  if (i < cnt) { as_delete(hset); return NULL; }
+  nbc = nbc_create(hset, 0);    /* create a classifier */
+  if (!nbc) { as_delete(hset); return NULL; }
+  return nbc;                   /* return the created classifier */
+}  /* _tokcreate() */
+
+/*--------------------------------------------------------------------*/
+
+NBC* nbc_hcreate (ATTSET *attset, int clsid, int bktcnt,
+                  unsigned int seed, int mode)
+{                               /* --- create a hashed classifier */
+  NBC *nbc;                     /* created classifier */
+
+  nbc = _tokcreate(attset, clsid, bktcnt, "buckets");
+  if (!nbc) return NULL;        /* create a classifier */
+  nbc->bktcnt = bktcnt;         /* note the hashing parameters */
+  nbc->seed   = seed;           /* (bucket i is attribute i+1) */
+  nbc->hmode  = mode & NBC_HSIGN;
+  return nbc;                   /* return the created classifier */
+}  /* nbc_hcreate() */
+
+/*--------------------------------------------------------------------*/
+
+NBC* nbc_tcreate (ATTSET *attset, int clsid, int slotcnt,
+                  int ctrcnt, double minfrq)
+{                               /* --- create a tracking classifier */
+  NBC *nbc;                     /* created classifier */
+
+  assert(ctrcnt > 0);           /* check the number of counters */
+  nbc = _tokcreate(attset, clsid, slotcnt, "tokens");
+  if (!nbc) return NULL;        /* create a classifier */
+  nbc->ctrs = (HHCTR*)malloc(ctrcnt *sizeof(HHCTR));
+  if (!nbc->ctrs) { nbc_delete(nbc, 1); return NULL; }
+  nbc->ctrcnt  = ctrcnt;        /* create the heavy hitter counters */
+  nbc->slotcnt = slotcnt;       /* and note the tracking parameters */
+  nbc->minfrq  = minfrq;        /* (slot i is attribute i+1) */
+  return nbc;                   /* return the created classifier */
+}  /* nbc_tcreate() */
+
+/*--------------------------------------------------------------------*/
+
+NBC* nbc_clone (NBC *nbc, int mode)
 {                               /* --- clone a naive Bayes classifier */
   NBC    *clone;                /* created classifier clone */
   ATTSET *attset;               /* clone of attribute set */
-  int    i, k, n;               /* loop variables */
-  DVEC   *dv; const DVEC   *sv; /* to traverse the distrib. vectors */
-  NORMD  *dn; const NORMD  *sn; /* to traverse the normal   distribs. */
-  DISCD  *dd; const DISCD  *sd; /* to traverse the discrete distribs. */
-  double *df; const double *sf; /* to traverse the frequency vectors */
+  NBCSHR *shr;                  /* shared memory of the classifier */
+  int    i, k;                  /* loop variables */
+  int    cloneas;               /* whether to clone the att. set */
+  DVEC   *dv, *sv;              /* to traverse the distrib. vectors */
+  double *df;                   /* buffer for the class vectors */
 
   assert(nbc);                  /* check the function argument */
 
+  /* --- prepare memory sharing --- */
+  if (mode & NBC_COW) {         /* if to share the distributions */
+    if ((mode & NBC_CLONE) && !nbc->asrefs) {
+      nbc->asrefs = (int*)malloc(sizeof(int));
+      if (!nbc->asrefs) return NULL;
+      *nbc->asrefs = 1;         /* create a reference counter */
+    }                           /* for the attribute set */
+    if (nbc->slabs) {           /* if there are unshared slabs, */
+      shr = (NBCSHR*)malloc(sizeof(NBCSHR));
+      if (!shr) return NULL;    /* create a shared memory block */
+      shr->refs   = 1;          /* that takes over the memory slabs */
+      shr->slabs  = nbc->slabs; /* and the older shared memory */
+      shr->base   = nbc->shr;   /* (the slabs are frozen, i.e. */
+      shr->map    = NULL;       /*  new distributions are created */
+      shr->size   = 0;          /*  in new slabs) */
+      shr->mapped = 0;
+      nbc->shr    = shr;
+      nbc->slabs  = NULL;
+    }                           /* (the attribute set is shared */
+  }                             /*  instead of being cloned) */
+  cloneas = (mode & NBC_CLONE) && !(mode & NBC_COW);
+
   /* --- copy the classifier body --- */
   attset = nbc->attset;         /* get the attribute set */
   if (cloneas) {                /* if the corresp. flag is set, */
@@ -399,8 +1565,28 @@ NBC* nbc_clone (NBC *nbc, int cloneas)
   if (!clone) { if (cloneas) as_delete(attset); return NULL; }
   for (dv = clone->dvecs +(i = nbc->attcnt); --i >= 0; ) {
     (--dv)->discds = NULL; dv->normds = NULL;
+    dv->dirty = dv->shared = 0;
   }                             /* clear the distribution vectors */
   clone->attset = attset;       /* (for a proper clean up on error) */
+  clone->frqs   = NULL;         /* (no class vectors yet) */
+  clone->slabs  = NULL;         /* (no memory slabs yet) */
+  for (i = NBC_FREES; --i >= 0; ) clone->frees[i] = NULL;
+  clone->shr    = NULL;         /* (no shared memory yet) */
+  clone->asrefs = NULL;         /* (attribute set is not shared yet) */
+  clone->bin    = nbc->bin;     /* (value names of a binary file) */
+  clone->plan   = NULL;         /* (plan is not copied) */
+  clone->quant  = nbc->quant;   /* (except a quantized plan) */
+  clone->qerr   = nbc->qerr;
+  clone->bktcnt = nbc->bktcnt;  /* copy the hashing parameters */
+  clone->seed   = nbc->seed;
+  clone->hmode  = nbc->hmode;
+  clone->htset  = NULL;         /* (token maps are not copied) */
+  clone->htcnt  = 0;
+  clone->htoks  = NULL;
+  clone->slotcnt = clone->slotused = clone->dropped = 0;
+  clone->ctrcnt  = clone->ctrused  = 0;   /* (token tracking */
+  clone->minfrq  = 0;                     /*  is not copied) */
+  clone->ctrs    = NULL;
   clone->attcnt = nbc->attcnt;  /* and copy the other fields */
   clone->clsid  = nbc->clsid;
   clone->clsvsz = nbc->clscnt;
@@ -408,62 +1594,71 @@ NBC* nbc_clone (NBC *nbc, int cloneas)
   clone->total  = nbc->total;
   clone->lcorr  = nbc->lcorr;
   clone->mode   = nbc->mode;
+  clone->dcnt   = -1;           /* (a full setup is needed) */
+  clone->dlist  = (int*)malloc(nbc->attcnt *sizeof(int));
+  if (!clone->dlist) { nbc_delete(clone, cloneas); return NULL; }
 
   /* --- copy the class distributions --- */
   if (nbc->clscnt <= 0)         /* if there are no classes, */
-    clone->frqs   =             /* no class vectors are needed */
+    clone->frqs   = clone->lpriors =  /* no class vectors needed */
     clone->priors = clone->posts = clone->cond = NULL;
   else {                        /* if there are classes, */
     clone->frqs =               /* allocate class vectors */
-    df = (double*)malloc(clone->clsvsz *4 *sizeof(double));
+    df = (double*)malloc(clone->clsvsz *5 *sizeof(double));
     if (!df) { nbc_delete(clone, cloneas); return NULL; }
-    clone->priors = clone->frqs   +clone->clsvsz;
-    clone->posts  = clone->priors +clone->clsvsz;
-    clone->cond   = clone->posts  +clone->clsvsz;
-    sf = nbc->frqs +2 *clone->clscnt;
-    for (df += k = 2 *clone->clscnt; --k >= 0; )
-      *--df = *--sf;            /* traverse the frequency vector */
-  }                             /* and copy the class frequencies */
+    clone->priors  = clone->frqs    +clone->clsvsz;
+    clone->lpriors = clone->priors  +clone->clsvsz;
+    clone->posts   = clone->lpriors +clone->clsvsz;
+    clone->cond    = clone->posts   +clone->clsvsz;
+    k = clone->clscnt *sizeof(double);
+    memcpy(clone->frqs,    nbc->frqs,    k);
+    memcpy(clone->priors,  nbc->priors,  k);
+    memcpy(clone->lpriors, nbc->lpriors, k);
+  }                             /* copy the class distribution */
+  if (nbc->quant) {             /* if the plan tables are quantized, */
+    clone->plan = _plancopy(nbc->plan);       /* the plan is the */
+    if (!clone->plan) { nbc_delete(clone, cloneas); return NULL; }
+  }                             /* only representation of the */
+                                /* conditional distributions */
+
+  /* --- share the conditional distributions --- */
+  if (mode & NBC_COW) {         /* if to share the distributions */
+    if (nbc->dcnt >= 0) {       /* if the classifier has been set up, */
+      clone->dcnt = nbc->dcnt;  /* copy the list of changed atts. */
+      memcpy(clone->dlist, nbc->dlist, nbc->dcnt *sizeof(int));
+    }                           /* (allows for incremental setups) */
+    sv = nbc->dvecs   +nbc->attcnt;  /* get pointers to the */
+    dv = clone->dvecs +nbc->attcnt;  /* distribution vectors */
+    for (i = nbc->attcnt; --i >= 0; ) {
+      *--dv = *--sv;            /* copy the distribution vectors */
+      if (dv->discds || dv->normds)   /* and mark the */
+        dv->shared = sv->shared = 1;  /* distributions as shared */
+    }                           /* (by both classifiers) */
+    if (nbc->shr)               /* reference the shared memory */
+      rc_inc(&(clone->shr = nbc->shr)->refs);
+    if (mode & NBC_CLONE)       /* reference the attribute set */
+      rc_inc(clone->asrefs = nbc->asrefs);
+    return clone;               /* return the created clone */
+  }
 
   /* --- copy the conditional distributions --- */
+  if (nbc->bin)                 /* keep a mapped binary file alive */
+    rc_inc(&(clone->shr = nbc->shr)->refs);  /* (value names) */
   sv = nbc->dvecs   +nbc->attcnt;  /* get pointers to the */
   dv = clone->dvecs +nbc->attcnt;  /* distribution vectors */
   for (i = nbc->attcnt; --i >= 0; ) {
     --sv; --dv;                 /* traverse the distribution vectors */
     dv->mark   = sv->mark;      /* copy the attribute mark, */
-    dv->type   = sv->type;      /* the attribute type, */
-    dv->valvsz = sv->valcnt;    /* the value vector size, and */
+    dv->type   = sv->type;      /* the attribute type, and */
     dv->valcnt = sv->valcnt;    /* the number of attribute values */
-    if ((sv->type    == 0)      /* if this is the class attribute */
-    ||  (nbc->clscnt <= 0))     /* or if there are no classes, */
+    dv->valvsz = 0;             /* (no value vectors yet) */
+    if ((sv->type == 0)         /* if this is the class attribute */
+    ||  (!sv->discds && !sv->normds))  /* or it has no data, */
       continue;                 /* there is nothing else to do */
-    if (sv->type == AT_NOM) {   /* -- if the attribute is nominal */
-      dv->discds =              /* create a vector of discrete dists. */
-      dd = (DISCD*)calloc(clone->clsvsz, sizeof(DISCD));
-      if (!dd) { nbc_delete(clone, cloneas); return NULL; }
-      if (sv->valcnt <= 0)      /* if the attribute has no values, */
-        continue;               /* there is nothing else to do */
-      sd = sv->discds +nbc->clscnt;
-      for (dd += (k = nbc->clscnt); --k >= 0; ) {
-        --dd; --sd;             /* traverse the discrete distribs. */
-        dd->cnt  = sd->cnt;     /* copy the total frequency and */
-        dd->frqs =              /* create a value frequency vector */
-        df = (double*)malloc(dv->valvsz *2 *sizeof(double));
-        if (!df) { nbc_delete(clone, cloneas); return NULL; }
-        dd->probs = df +dv->valvsz;
-        sf = sd->frqs +2 *dv->valvsz;
-        for (df += n = 2 *dv->valvsz; --n >= 0; )
-          *--df = *--sf;        /* traverse the frequency vectors */
-      } }                       /* and copy the value frequencies */
-    else {                      /* -- if the attribute is numeric */
-      dv->normds =              /* create a vector of normal dists. */
-      dn = (NORMD*)malloc(clone->clsvsz *sizeof(NORMD));
-      if (!dn) { nbc_delete(clone, cloneas); return NULL; }
-      sn = sv->normds +clone->clsvsz;
-      for (dn += k = clone->clsvsz; --k >= 0; )
-        *--dn = *--sn;          /* copy the normal distributions */
-    }                           /* (including computed estimates) */
-  }
+    if (_attcopy(clone, dv, sv) != 0) {
+      nbc_delete(clone, cloneas); return NULL; }
+  }                             /* copy the distributions */
+
   return clone;                 /* return the created clone */
 }  /* nbc_clone() */
 
@@ -471,21 +1666,31 @@ NBC* nbc_clone (NBC *nbc, int cloneas)
 
 void nbc_delete (NBC *nbc, int delas)
 {                               /* --- delete a naive Bayes class. */
-  int   i, k;                   /* loop variables */
-  DVEC  *dvec;                  /* to traverse the distrib. vectors */
-  DISCD *discd;                 /* to traverse the discrete distribs. */
+  SLAB   *slab;                 /* to traverse the memory slabs */
+  NBCSHR *shr;                  /* to traverse the shared memory */
 
   assert(nbc);                  /* check the function argument */
-  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
-    if ((--dvec)->discds) {     /* traverse the attributes */
-      for (discd = dvec->discds +(k = nbc->clscnt); --k >= 0; )
-        if ((--discd)->frqs) free(discd->frqs);
-      free(dvec->discds);       /* delete all frequency vectors */
-    }                           /* and the distribution vectors */
-    if (dvec->normds) free(dvec->normds);
-  }                             /* delete the normal distributions */
-  if (nbc->frqs) free(nbc->frqs);
-  if (delas)     as_delete(nbc->attset);
+  while (nbc->slabs) {          /* traverse the memory slabs */
+    slab = nbc->slabs; nbc->slabs = slab->succ; free(slab); }
+  while (nbc->shr && (rc_dec(&nbc->shr->refs) <= 0)) {
+    shr = nbc->shr;             /* traverse the unreferenced */
+    while (shr->slabs) {        /* shared memory blocks */
+      slab = shr->slabs; shr->slabs = slab->succ; free(slab); }
+    if (shr->map) _unmap(shr);  /* delete the memory slabs, */
+    nbc->shr = shr->base;       /* unmap a binary model file, */
+    free(shr);                  /* and the shared memory block */
+  }                             /* (release the older memory) */
+  if (nbc->asrefs) {            /* if the attribute set is shared, */
+    if (rc_dec(nbc->asrefs) > 0)/* delete it only with */
+      delas = 0;                /* the last classifier */
+    else free(nbc->asrefs);     /* that references it */
+  }
+  if (nbc->frqs) free(nbc->frqs);  /* delete all distributions */
+  if (nbc->plan)  _plandel(nbc->plan);
+  if (nbc->dlist) free(nbc->dlist);
+  if (nbc->htoks) _htclear(nbc);
+  if (nbc->ctrs)  free(nbc->ctrs);
+  if (delas)      as_delete(nbc->attset);
   free(nbc);                    /* delete the classifier body */
 }  /* nbc_delete() */
 
@@ -501,11 +1706,16 @@ void nbc_clear (NBC *nbc)
 
   assert(nbc);                  /* check the function argument */
   nbc->total = 0;               /* clear the total number of cases */
+  nbc->dcnt  = -1;              /* all attributes need a new setup */
   for (frq = nbc->frqs +(i = nbc->clscnt); --i >= 0; )
     *--frq = 0;                 /* clear the frequency distribution */
   for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
-    if ((--dvec)->type == 0)    /* traverse all attributes */
-      continue;                 /* except the class attribute */
+    if (((--dvec)->type == 0)   /* traverse all attributes except */
+    ||  (!dvec->discds && !dvec->normds))   /* the class attribute */
+      continue;                 /* and those without distributions */
+    if (dvec->shared) {         /* if the distributions are shared, */
+      dvec->discds = NULL; dvec->normds = NULL;  /* only drop them */
+      dvec->valvsz = dvec->shared = 0; continue; }
     if (dvec->type == AT_NOM) { /* if the attribute is nominal */
       for (discd = dvec->discds +(k = nbc->clscnt); --k >= 0; ) {
         (--discd)->cnt = 0;     /* traverse the distributions */
@@ -519,6 +1729,154 @@ void nbc_clear (NBC *nbc)
   }                             /* value and variance are computed */
 }  /* nbc_clear() */
 
+/*--------------------------------------------------------------------*/
+
+int nbc_hash (const NBC *nbc, const char *name)
+{                               /* --- get the bucket of a token */
+  unsigned int h;               /* hash value of the token name */
+  int          b;               /* attribute identifier of bucket */
+
+  assert(nbc && name && (nbc->bktcnt > 0));
+  h = _hash(name, nbc->seed);   /* hash the token name */
+  b = (int)(h % (unsigned int)nbc->bktcnt) +1;
+  return ((nbc->hmode & NBC_HSIGN) && (h & 0x80000000U)) ? -b : b;
+}  /* nbc_hash() */             /* return the (signed) bucket */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_hinst (NBC *nbc, ATTSET *attset, int clsid,
+               SPINST *insts, int *cls)
+{                               /* --- map a token instantiation */
+  int        i, k, n, v, r;     /* loop variables, buffers */
+  ATT        *att, *dst;        /* token and bucket attribute */
+  HTOK       *ht;               /* to traverse the token maps */
+  int        *ids;              /* buffer for reallocation */
+  const char *name;             /* name of a token value */
+
+  assert(nbc && attset && insts /* check the function arguments */
+      && ((nbc->bktcnt > 0) || ((nbc->slotcnt > 0) && cls)));
+  if (attset != nbc->htset) {   /* if the token set has changed, */
+    _htclear(nbc); nbc->htset = attset; }  /* clear the maps */
+  n = as_attcnt(attset);        /* get the number of attributes */
+  if (n > nbc->htcnt) {         /* if there are new attributes */
+    ht = (HTOK*)realloc(nbc->htoks, n *sizeof(HTOK));
+    if (!ht) return -1;         /* enlarge the token map vector */
+    nbc->htoks = ht;            /* and map the new attributes */
+    for (ht += i = nbc->htcnt; i < n; ht++, i++) {
+      att = as_att(attset, i);  /* traverse the new attributes */
+      ht->cnt = 0; ht->ids = NULL; ht->bkt = 0; ht->ctr = -2;
+      if ((i == clsid) || (att_type(att) != AT_NOM)
+      ||  ((attset == nbc->attset) && (i < nbc->attcnt)))
+        continue;               /* skip the class, numeric atts. */
+      if (nbc->bktcnt > 0)      /* and the buckets themselves */
+           ht->bkt = nbc_hash(nbc, att_name(att));
+      else ht->ctr = -1;        /* hash the token names or */
+    }                           /* prepare tracking the tokens */
+    nbc->htcnt = n;             /* (tokens are materialized when */
+  }                             /*  they have become frequent) */
+  if (cls) *cls = -1;           /* default: null class */
+  for (k = i = 0; i < n; i++) { /* traverse the attributes */
+    ht = nbc->htoks +i;         /* get the token map */
+    if (!ht->bkt && (i != clsid) && (ht->ctr < -1))
+      continue;                 /* skip non-token attributes */
+    att = as_att(attset, i);    /* get the token value */
+    v   = att_inst(att)->i;     /* and skip null values */
+    if (v < 0) continue;
+    if (!ht->bkt && (i != clsid)) {
+      r = _track(nbc, i, as_getwgt(attset), att_name(att));
+      if (r < 0) return r;      /* count a tracked token and */
+      if (r < 1) continue;      /* skip it unless it has been */
+    }                           /* materialized just now */
+    dst = as_att(nbc->attset, (i == clsid) ? nbc->clsid
+                            : (ht->bkt < 0) ? -ht->bkt : ht->bkt);
+    if (v >= ht->cnt) {         /* if the value is not mapped yet */
+      ids = (int*)realloc(ht->ids, att_valcnt(att) *sizeof(int));
+      if (!ids) return -1;      /* enlarge the value map */
+      for (ht->ids = ids; ht->cnt < att_valcnt(att); ht->cnt++)
+        ids[ht->cnt] = -1;      /* (values are looked up lazily) */
+    }
+    if ((ht->ids[v] == -1)      /* if the value is not known yet */
+    || ((ht->ids[v] <  0) && cls)) {
+      name = att_valname(att, v);
+      if (!cls)                 /* when executing, look it up */
+        ht->ids[v] = nbc_valid(nbc, att_id(dst), name);
+      else {                    /* when training, add it */
+        if (att_valadd(dst, name, NULL) < 0) return -1;
+        ht->ids[v] = att_inst(dst)->i;
+      }                         /* (-2: value has been looked up, */
+      if (ht->ids[v] < 0) ht->ids[v] = -2;  /* but is unknown) */
+    }
+    if (ht->ids[v] < 0)         /* skip unknown values */
+      continue;                 /* (they count as null values) */
+    if (i == clsid) {           /* if this is the class attribute, */
+      if (cls) *cls = ht->ids[v];             /* note the class */
+      continue;                 /* and continue with the next */
+    }                           /* attribute */
+    insts[k].attid  = ht->bkt;  /* store the bucket and the value */
+    insts[k++].inst.i = ht->ids[v];   /* in the bucket's domain */
+  }                             /* (a token may share its bucket */
+  return k;                     /*  with other tokens) */
+}  /* nbc_hinst() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_hstats (const NBC *nbc, int *used, int *coll, int *maxld)
+{                               /* --- collision statistics */
+  int        i, b, n;           /* loop variables, buffer */
+  int        *lds;              /* number of tokens per bucket */
+  const HTOK *ht;               /* to traverse the token maps */
+
+  assert(nbc && used && coll && maxld);
+  *used = *coll = *maxld = 0;   /* initialize the statistics */
+  if (nbc->bktcnt <= 0) return 0;
+  lds = (int*)calloc(nbc->bktcnt +1, sizeof(int));
+  if (!lds) return -1;          /* create the bucket counters */
+  for (n = 0, ht = nbc->htoks +(i = nbc->htcnt); --i >= 0; ) {
+    b = (--ht)->bkt;            /* traverse the token maps */
+    if (b == 0) continue;       /* skip non-token attributes */
+    lds[(b < 0) ? -b : b]++; n++;
+  }                             /* count the tokens per bucket */
+  for (b = nbc->bktcnt; b > 0; b--) {
+    if (lds[b] <= 0) continue;  /* traverse the used buckets */
+    (*used)++;                  /* count the used buckets */
+    if (lds[b] > 1)      *coll += lds[b];
+    if (lds[b] > *maxld) *maxld = lds[b];
+  }                             /* count the colliding tokens */
+  free(lds);                    /* and determine the maximal load */
+  return n;                     /* return the number of tokens */
+}  /* nbc_hstats() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_tstats (const NBC *nbc, int *used, int *dropped)
+{                               /* --- token tracking statistics */
+  int        i, n;              /* loop variable, token counter */
+  const HTOK *ht;               /* to traverse the token maps */
+
+  assert(nbc && used && dropped);
+  *used    = nbc->slotused;     /* get the number of materialized */
+  *dropped = nbc->dropped;      /* and of dropped frequent tokens */
+  for (n = 0, ht = nbc->htoks +(i = nbc->htcnt); --i >= 0; )
+    if ((--ht)->ctr != -2) n++; /* count the token attributes */
+  return n;                     /* return the number of tokens */
+}  /* nbc_tstats() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_tdone (NBC *nbc)
+{                               /* --- finish token tracking */
+  int i;                        /* loop variable */
+
+  assert(nbc);                  /* check the function argument */
+  _htclear(nbc);                /* delete the token maps */
+  if (nbc->ctrs) { free(nbc->ctrs); nbc->ctrs = NULL; }
+  nbc->ctrcnt = nbc->slotcnt = 0;  /* and the heavy hitter counters */
+  for (i = nbc->attcnt; --i >= 0; )
+    att_setmark(as_att(nbc->attset, i), (i <= nbc->slotused) ? 1 : -1);
+  att_setmark(as_att(nbc->attset, nbc->clsid), 0);
+  return nbc->slotused;         /* mark the used token slots */
+}  /* nbc_tdone() */            /* and return their number */
+
 /*--------------------------------------------------------------------*/
 #ifdef NBC_INDUCE
 
@@ -529,9 +1887,6 @@ int nbc_add (NBC *nbc, const TUPLE *tpl)
   float  wgt;                   /* instantiation weight */
   const  INST *inst;            /* to traverse the instances */
   DVEC   *dvec;                 /* to traverse the distrib. vectors */
-  NORMD  *normd;                /* to access normal   distributions */
-  DISCD  *discd;                /* to access discrete distributions */
-  double v;                     /* buffer (for an attribute value) */
 
   assert(nbc);                  /* check the function argument */
 
@@ -560,35 +1915,119 @@ int nbc_add (NBC *nbc, const TUPLE *tpl)
     inst = (tpl)                /* get the attribute instantiation */
          ? tpl_colval(tpl, i)   /* from the tuple or the att. set */
          : att_inst(as_att(nbc->attset, i));
-    if (dvec->type == AT_NOM) { /* -- if the attribute is nominal */
-      if (inst->i < 0)          /* if the attribute value is null, */
-        continue;               /* there is nothing to do */
-      if ((inst->i >= dvec->valcnt)
-      &&  (_valrsz(dvec, nbc->clscnt, inst->i+1) != 0))
-        return -1;              /* resize the value freq. vectors */
-      discd = dvec->discds +cls;   /* get the proper distribution */
-      discd->frqs[inst->i] += wgt; /* and update the value frequency */
-      discd->cnt += wgt; }         /* and the total frequency */
-    else {                      /* -- if the attribute is numeric */
-      if (dvec->type == AT_REAL){  /* if the attribute is real valued */
-        if (inst->f <= NV_REAL) continue;
-        v = (double)inst->f;}   /* check and get the attribute value */
-      else {                    /* if the attribute is integer valued */
-        if (inst->i <= NV_INT)  continue;
-        v = (double)inst->i;    /* check and get the attribute value */
-      }                         /* (convert it to double) */
-      normd = dvec->normds +cls;/* get the proper distribution */
-      normd->cnt += wgt;        /* update the case counter */
-      normd->sv  += wgt *v;     /* the sum of the values, and */
-      normd->sv2 += wgt *v*v;   /* the sum of their squares */
-    }                           /* (expected value and variance */
-  }                             /*  are computed in nbc_setup) */
+    if (_add(nbc, i, cls, wgt, inst) != 0)
+      return -1;                /* update the distributions */
+  }                             /* of the attribute */
   return 0;                     /* return 'ok' */
 }  /* nbc_add() */
 
 /*--------------------------------------------------------------------*/
 
-NBC* nbc_induce (TABLE *table, int clsid, int mode, double lcorr)
+int nbc_addsp (NBC *nbc, int cls, float wgt,
+               const SPINST *insts, int cnt)
+{                               /* --- add a sparse instantiation */
+  int   k;                      /* attribute identifier */
+  float w;                      /* (signed) instantiation weight */
+
+  assert(nbc && (insts || (cnt <= 0)) && (wgt >= 0.0F));
+  if (cls < 0) return 0;        /* if the class is null, abort */
+
+  /* --- update class distribution --- */
+  if ((cls >= nbc->clscnt)      /* if the class is a new one, */
+  &&  (_clsrsz(nbc,cls+1) != 0))/* resize the class dependent vectors */
+    return -1;                  /* (frequencies and distributions) */
+  nbc->frqs[cls] += wgt;        /* update the class frequency */
+  nbc->total     += wgt;        /* and the total frequency */
+
+  /* --- update conditional distributions --- */
+  for (insts += cnt; --cnt >= 0; ) {
+    --insts;                    /* traverse the given instances */
+    k = insts->attid;           /* get the attribute identifier */
+    if (k < 0) { k = -k; w = -wgt; } else w = wgt;
+    assert(k < nbc->attcnt);    /* (negative: sign hashed token) */
+    if (nbc->dvecs[k].type == 0)
+      continue;                 /* skip the class attribute */
+    if (_add(nbc, k, cls, w, &insts->inst) != 0)
+      return -1;                /* update the distributions */
+  }                             /* of the attribute */
+  return 0;                     /* return 'ok' */
+}  /* nbc_addsp() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_sub (NBC *nbc, const TUPLE *tpl)
+{                               /* --- remove an instantiation */
+  int    i;                     /* loop variable */
+  int    cls;                   /* value of class attribute */
+  float  wgt;                   /* instantiation weight */
+  const  INST *inst;            /* to traverse the instances */
+  DVEC   *dvec;                 /* to traverse the distrib. vectors */
+
+  assert(nbc);                  /* check the function argument */
+
+  /* --- get class and weight --- */
+  if (tpl) {                    /* if a tuple is given */
+    cls = tpl_colval(tpl, nbc->clsid)->i;
+    wgt = tpl_getwgt(tpl); }    /* get the class and the tuple weight */
+  else {                        /* if no tuple is given */
+    cls = att_inst(as_att(nbc->attset, nbc->clsid))->i;
+    wgt = as_getwgt(nbc->attset);
+  }                             /* get the class and the inst. weight */
+  if ((cls < 0) || (cls >= nbc->clscnt))
+    return 0;                   /* if the class is null or unknown, */
+  assert(wgt >= 0.0F);          /* there is nothing to remove */
+
+  /* --- update class distribution --- */
+  nbc->frqs[cls] -= wgt;        /* update the class frequency */
+  nbc->total     -= wgt;        /* and the total frequency */
+
+  /* --- update conditional distributions --- */
+  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
+    if ((--dvec)->type == 0)    /* traverse all attributes */
+      continue;                 /* except the class attribute */
+    inst = (tpl)                /* get the attribute instantiation */
+         ? tpl_colval(tpl, i)   /* from the tuple or the att. set */
+         : att_inst(as_att(nbc->attset, i));
+    if (_add(nbc, i, cls, -wgt, inst) != 0)
+      return -1;                /* update the distributions */
+  }                             /* of the attribute */
+  return 0;                     /* return 'ok' */
+}  /* nbc_sub() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_subsp (NBC *nbc, int cls, float wgt,
+               const SPINST *insts, int cnt)
+{                               /* --- remove a sparse instantiation */
+  int   k;                      /* attribute identifier */
+  float w;                      /* (signed) instantiation weight */
+
+  assert(nbc && (insts || (cnt <= 0)) && (wgt >= 0.0F));
+  if ((cls < 0) || (cls >= nbc->clscnt))
+    return 0;                   /* if the class is null or unknown, */
+                                /* there is nothing to remove */
+  /* --- update class distribution --- */
+  nbc->frqs[cls] -= wgt;        /* update the class frequency */
+  nbc->total     -= wgt;        /* and the total frequency */
+
+  /* --- update conditional distributions --- */
+  for (insts += cnt; --cnt >= 0; ) {
+    --insts;                    /* traverse the given instances */
+    k = insts->attid;           /* get the attribute identifier */
+    if (k < 0) { k = -k; w = wgt; } else w = -wgt;
+    assert(k < nbc->attcnt);    /* (negative: sign hashed token) */
+    if (nbc->dvecs[k].type == 0)
+      continue;                 /* skip the class attribute */
+    if (_add(nbc, k, cls, w, &insts->inst) != 0)
+      return -1;                /* update the distributions */
+  }                             /* of the attribute */
+  return 0;                     /* return 'ok' */
+}  /* nbc_subsp() */
+
+/*--------------------------------------------------------------------*/
+
+NBC* nbc_induce (TABLE *table, int clsid, int mode, double lcorr,
+                 int thcnt)
 {                               /* --- induce a naive Bayes class. */
   int    i, r = 0;              /* loop variable, buffer */
   int    cnt;                   /* number of selectable attributes */
@@ -602,6 +2041,7 @@ NBC* nbc_induce (TABLE *table, int clsid, int mode, double lcorr)
   double *p;                    /* to traverse the class probs. */
   double max;                   /* maximum of class probabilities */
   double errs;                  /* weight sum of misclassified tuples */
+  double *lps;                  /* log. posteriors of the tuples */
 
   assert(table                  /* check the function arguments */
       && (clsid >= 0) && (clsid < tab_colcnt(table))
@@ -619,7 +2059,8 @@ NBC* nbc_induce (TABLE *table, int clsid, int mode, double lcorr)
   /* --- build initial classifier --- */
   for (i = tab_tplcnt(table); --i >= 0; )
     nbc_add(nbc, tab_tpl(table, i));    /* start with a */
-  nbc_setup(nbc, mode|NBC_ALL, lcorr);  /* full classifier */
+  if (nbc_setup(nbc, mode|NBC_ALL, lcorr) != 0) {  /* full class. */
+    nbc_delete(nbc, mode & NBC_CLONE); return NULL; }
   if (!(mode & (NBC_ADD|NBC_REMOVE)))
     return nbc;                 /* if no simp. is requested, abort */
 
@@ -651,10 +2092,11 @@ NBC* nbc_induce (TABLE *table, int clsid, int mode, double lcorr)
   sa = savec;                   /* create vector of selectable atts. */
   for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
     (--dvec)->mark = -1;        /* traverse all attributes */
-    if ( (dvec->type == 0)      /* except the class attribute */
-    ||  ((dvec->type == AT_NOM) /* and all nominal attributes */
-    &&   (dvec->valcnt <= 0)))  /* that do not have any values */
-      continue;
+    if ( (dvec->type == 0)      /* except the class attribute, */
+    ||  ((dvec->type == AT_NOM) /* all nominal attributes */
+    &&   (dvec->valcnt <= 0))   /* that do not have any values, */
+    ||  (!dvec->discds && !dvec->normds))  /* and all attributes */
+      continue;                 /* without distributions */
     if (mode & NBC_REMOVE)      /* if to remove attributes, */
       dvec->mark = i;           /* mark all selectable attributes */
     sa->attid = i;              /* note selectable attributes and */
@@ -663,12 +2105,22 @@ NBC* nbc_induce (TABLE *table, int clsid, int mode, double lcorr)
   cnt = (int)(sa -savec);       /* compute the number of attributes */
   nbc->dvecs[nbc->clsid].mark = nbc->clsid;   /* and mark the class */
 
+  /* --- compute initial log. posteriors --- */
+  lps = (double*)malloc((size_t)(tab_tplcnt(table)+1)
+                       *nbc->clscnt *sizeof(double));
+  if (!lps) { free(savec); nbc_delete(nbc, mode & NBC_CLONE);
+              return NULL; }    /* create a log. posterior matrix */
+  for (i = tab_tplcnt(table); --i >= 0; )
+    _logpost(nbc, tpl_colval(tab_tpl(table, i), 0),
+             lps +(size_t)i *nbc->clscnt, nbc->cond);
+                                /* (updated with _update() later) */
+
   /* --- select attributes --- */
   while ((cnt  > 0)             /* while there are selectable atts. */
   &&     (errs > 0)) {          /* and the classifier is not perfect */
     for (sa = savec +(i = cnt); --i >= 0; )
       (--sa)->errs = 0;         /* clear the numbers of errors */
-    r = _eval(nbc, table, mode, savec, cnt);
+    r = _eval(nbc, table, mode, savec, cnt, lps, thcnt);
     if (r < 0) break;           /* evaluate selectable attributes */
     best = sa = savec;          /* traverse the selectable attributes */
     for (i = cnt; --i > 0; ) {  /* in order to find the best */
@@ -686,11 +2138,15 @@ NBC* nbc_induce (TABLE *table, int clsid, int mode, double lcorr)
     #endif                      /* print a counter for debugging */
     nbc->dvecs[best->attid].mark = (mode & NBC_ADD)
       ? best->attid : -1;       /* mark/unmark the selected attribute */
+    _update(nbc, table, lps, best->attid, mode);
     for (--cnt; best < sa; best++)  /* remove the selected */
       best->attid = best[1].attid;  /* attribute from the  */
   }                                 /* list of attributes  */
   free(savec);                  /* delete the selectable atts. vector */
-
+  free(lps);                    /* and the log. posterior matrix */
+  if ((r >= 0) && (mode & NBC_MULTI))  /* token probabilities depend */
+    r = nbc_setup(nbc, mode & ~(NBC_ALL|NBC_MARKED|NBC_DIRTY), lcorr);
+                                /* on the selected count attributes */
   if (r < 0) {                  /* if an error occurred, abort */
     nbc_delete(nbc, mode & NBC_CLONE); return NULL; }
   return nbc;                   /* return the created classifier */
@@ -706,29 +2162,161 @@ int nbc_mark (NBC *nbc)
 
   assert(nbc);                  /* check the function argument */
   for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
-    if ((--dvec)->mark < 0) m = -1;
+    if (((--dvec)->mark < 0) && (nbc->bktcnt <= 0)) m = -1;
     else           { cnt++; m =  1; }
     att_setmark(as_att(nbc->attset, i), m);
   }                             /* transfer marker to attribute set */
+                                /* (hash buckets are always kept) */
   att_setmark(as_att(nbc->attset, nbc->clsid), 0);
   return cnt;                   /* return number of marked atts. */
 }  /* nbc_mark() */
 
+/*--------------------------------------------------------------------*/
+
+static int _attmap (NBC *dst, const NBC *src, int *ids)
+{                               /* --- map attributes by their names */
+  int        i, k;              /* loop variables */
+  const DVEC *dvec;             /* to traverse the distrib. vectors */
+
+  assert(dst && src && ids);    /* check the function arguments */
+  for (dvec = src->dvecs +(i = src->attcnt); --i >= 0; ) {
+    if (!(--dvec)->discds && !dvec->normds && (dvec->type != 0)) {
+      ids[i] = -1; continue; }  /* skip attributes without data */
+    k = as_attid(dst->attset, att_name(as_att(src->attset, i)));
+    if ((k < 0) || (k >= dst->attcnt))
+      return -2;                /* get the corresp. attribute */
+    if (dvec->type != dst->dvecs[k].type)
+      return -2;                /* check the attribute type */
+    ids[i] = k;                 /* (type 0 is the class attribute) */
+  }                             /* and note the attribute id */
+  return 0;                     /* return 'ok' */
+}  /* _attmap() */
+
+/*--------------------------------------------------------------------*/
+
+static int _valmap (NBC *dst, const NBC *src, int sid, int did,
+                    int *map)
+{                               /* --- map values by their names */
+  int i, n;                     /* loop variable, number of values */
+  int cnt = 0;                  /* number of destination values */
+  ATT *att;                     /* destination attribute */
+
+  assert(dst && src && map);    /* check the function arguments */
+  att = as_att(dst->attset, did);
+  n   = (src->dvecs[sid].type == 0)
+      ? src->clscnt : src->dvecs[sid].valcnt;
+  for (i = 0; i < n; i++) {     /* traverse the source values */
+    if (att_valadd(att, _valname(src, sid, i), NULL) < 0)
+      return -1;                /* add the value to the destination */
+    map[i] = att_inst(att)->i;  /* attribute (if it is new) and */
+    if (map[i] >= cnt) cnt = map[i]+1;  /* note its identifier */
+  }                             /* (the number of values needed */
+  return cnt;                   /*  in the destination classifier) */
+}  /* _valmap() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_merge (NBC *dst, const NBC *src)
+{                               /* --- merge two naive Bayes class. */
+  int         i, k, n;          /* loop variables, buffer */
+  int         *ids;             /* map of attribute identifiers */
+  int         *cls, *vals;      /* maps of class and value ids. */
+  DVEC        *dv;              /* to traverse the distrib. vectors */
+  const DVEC  *sv;              /* of destination and source */
+  DISCD       *dd;              /* to traverse the discrete distribs. */
+  const DISCD *sd;              /* of destination and source */
+  NORMD       *dn;              /* to traverse the normal   distribs. */
+  const NORMD *sn;              /* of destination and source */
+
+  assert(dst && src && !dst->bin); /* check the function arguments */
+  if (src->quant) return -2;    /* quantized plans cannot be merged */
+  if ((src->bktcnt != dst->bktcnt) || (src->seed  != dst->seed)
+  ||  (src->hmode  != dst->hmode)) /* the hashing parameters */
+    return -2;                  /* must be the same */
+  for (n = src->clscnt, sv = src->dvecs +(i = src->attcnt); --i >= 0; )
+    if ((--sv)->valcnt > n) n = sv->valcnt;
+  ids = (int*)malloc((src->attcnt +src->clscnt +n) *sizeof(int));
+  if (!ids) return -1;          /* create the identifier maps */
+  cls  = ids +src->attcnt;      /* and organize the memory */
+  vals = cls +src->clscnt;      /* (attributes, classes, values) */
+
+  /* --- map attributes and classes --- */
+  if (_attmap(dst, src, ids) != 0) {
+    free(ids); return -2; }     /* map the attributes by their names */
+  k = _valmap(dst, src, src->clsid, dst->clsid, cls);
+  if ((k < 0)                   /* map the classes by their names */
+  ||  ((k > dst->clscnt)        /* and resize the class dependent */
+  &&   (_clsrsz(dst, k) != 0))) {  /* vectors for new classes */
+    free(ids); return -1; }
+  for (i = src->clscnt; --i >= 0; ) {
+    dst->frqs[cls[i]] += src->frqs[i];
+    dst->total        += src->frqs[i];
+  }                             /* add the class frequencies */
+
+  /* --- merge the conditional distributions --- */
+  for (sv = src->dvecs +(i = src->attcnt); --i >= 0; ) {
+    if (((--sv)->type == 0) || (ids[i] < 0))
+      continue;                 /* skip class and empty attributes */
+    dv = dst->dvecs +ids[i];    /* get the destination attribute */
+    if ((_attown (dst, dv) != 0)   /* unshare the distributions */
+    ||  (_attinit(dst, dv) != 0)) {/* or create them if necessary */
+      free(ids); return -1; }
+    if (!dv->discds && !dv->normds)
+      continue;                 /* skip attributes without classes */
+    if (sv->mark > dv->mark)    /* a destination attribute is used */
+      dv->mark = sv->mark;      /* if it is used in either classifier */
+    if (sv->type == AT_NOM) {   /* -- if the attribute is nominal */
+      k = _valmap(dst, src, i, ids[i], vals);
+      if ((k < 0)               /* map the values by their names */
+      ||  ((k > dv->valcnt)     /* and resize the value freq. vectors */
+      &&   (_valrsz(dst, dv, k) != 0))) {
+        free(ids); return -1; }
+      for (sd = sv->discds +(k = src->clscnt); --k >= 0; ) {
+        dd = dv->discds +cls[k];/* traverse the discrete distribs. */
+        dd->cnt += (--sd)->cnt; /* add the total frequency */
+        for (n = sv->valcnt; --n >= 0; )
+          dd->frqs[vals[n]] += sd->frqs[n];
+      } }                       /* add the value frequencies */
+    else {                      /* -- if the attribute is numeric */
+      att_valcopy(as_att(dst->attset, ids[i]), as_att(src->attset, i), 0);
+                                /* extend range and value widths */
+      for (sn = sv->normds +(k = src->clscnt); --k >= 0; ) {
+        dn = dv->normds +cls[k];/* traverse the normal distribs. */
+        dn->cnt += (--sn)->cnt; /* add the number of cases, */
+        dn->sv  += sn->sv;      /* the sum of the values, */
+        dn->sv2 += sn->sv2;     /* and the sum of their squares */
+      }                         /* (expected value and variance */
+    }                           /*  are computed in nbc_setup) */
+  }
+  free(ids);                    /* delete the identifier maps */
+  dst->dcnt = -1;               /* all attributes need a new setup */
+  return 0;                     /* return 'ok' */
+}  /* nbc_merge() */
+
 #endif
 /*--------------------------------------------------------------------*/
 
-void nbc_setup (NBC *nbc, int mode, double lcorr)
+int nbc_setup (NBC *nbc, int mode, double lcorr)
 {                               /* --- set up a naive Bayes class. */
-  int    i, k, n;               /* loop variables */
+  int    i, n;                  /* loop variables */
+  int    incr;                  /* whether to set up incrementally */
+  int    r = 0;                 /* result of estimation */
   DVEC   *dvec;                 /* to traverse the distrib. vectors */
-  NORMD  *normd;                /* to traverse the normal   distribs. */
-  DISCD  *discd;                /* to traverse the discrete distribs. */
-  double *frq, *prb;            /* to traverse the value frqs./probs. */
-  double cnt, sp;               /* number of cases, sum of priors */
-  double add;                   /* Laplace corr. + distributed weight */
+  double *frq, *prb, *lpr;      /* to traverse the value frqs./probs. */
+  double cnt;                   /* number of cases */
+  double *tsum = NULL;          /* denominators of token probs. */
 
   assert(nbc && (lcorr >= 0));  /* check the function arguments */
-  nbc->mode  = mode & (NBC_DWNULL|NBC_MAXLLH);
+  if (nbc->quant) return -2;    /* quantized plans cannot be set up */
+  if (nbc->plan) {              /* if there is a compiled plan, */
+    _plandel(nbc->plan); nbc->plan = NULL; }   /* it gets invalid */
+  incr = (mode & NBC_DIRTY)     /* check whether an incremental */
+      && (nbc->dcnt >= 0)       /* setup is requested and possible */
+      && !(mode & NBC_DWNULL)   /* (weight distribution for nulls */
+      && (lcorr == nbc->lcorr)  /* depends on the class frequencies) */
+      && ((mode & NBC_MAXLLH) == (nbc->mode & NBC_MAXLLH))
+      && !(mode & NBC_MULTI);   /* (token probs. depend on all counts) */
+  nbc->mode  = mode & (NBC_DWNULL|NBC_MAXLLH|NBC_MULTI);
   nbc->lcorr = lcorr;           /* note estimation parameters */
 
   /* --- estimate class probabilities --- */
@@ -741,47 +2329,47 @@ void nbc_setup (NBC *nbc, int mode, double lcorr)
     frq = nbc->frqs +n;         /* traverse the class frequencies */
     while (--n >= 0) *--prb = (*--frq +lcorr) /cnt;
   }                             /* estimate the class probabilities */
+  lpr = nbc->lpriors +(n = nbc->clscnt);
+  for (prb += n; --n >= 0; ) {  /* compute the log. of the priors */
+    --prb; *--lpr = (*prb > 0) ? log(*prb) : -HUGE_VAL; }
+
+  /* --- sum token frequencies --- */
+  if ((mode & NBC_MULTI) && (nbc->clscnt > 0)) {
+    tsum = nbc->cond;           /* (buffer is not needed for setup) */
+    for (n = nbc->clscnt; --n >= 0; ) tsum[n] = 0;
+    for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
+      if ((--dvec)->type != AT_INT) continue;
+      if      (mode & NBC_ALL)  /* traverse the integer attributes */
+        n = 1;                  /* and determine whether they */
+      else if (mode & NBC_MARKED)       /* will be used */
+        n = att_getmark(as_att(nbc->attset, i));
+      else n = dvec->mark;      /* (same selection as in _estim) */
+      if (n < 0) continue;      /* skip unused attributes */
+      for (n = nbc->clscnt; --n >= 0; ) {
+        tsum[n] += lcorr;       /* sum the token frequencies */
+        if (dvec->normds) tsum[n] += dvec->normds[n].sv;
+      }                         /* (plus one Laplace correction */
+    }                           /*  per token, i.e. count attribute) */
+  }
 
   /* --- estimate conditional probabilities --- */
-  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
-    if ((--dvec)->type == 0) {  /* traverse all attributes */
-      dvec->mark = 0; continue;}/* except the class attribute */
-    if      (mode & NBC_ALL)    /* if to use all attributes, */
-      dvec->mark = 1;           /* mark attribute as used */
-    else if (mode & NBC_MARKED) /* if to use only marked atts. */
-      dvec->mark = (att_getmark(as_att(nbc->attset, i)) >= 0)
-                 ? 1 : -1;      /* get the attribute mark */
-    if (dvec->mark < 0)         /* otherwise keep the */
-      continue;                 /* selection of attributes */
-    if (dvec->type == AT_NOM) { /* -- if the attribute is nominal */
-      if (dvec->valcnt <= 0) {  /* if the attribute has no values, */
-        dvec->mark = -1; continue; }     /* there is nothing to do */
-      sp = dvec->valcnt *lcorr; /* compute the sum of the priors */
-      for (discd = dvec->discds +(k = nbc->clscnt); --k >= 0; ) {
-        --discd;                /* traverse the distributions */
-        n   = dvec->valcnt;     /* get the number of att. values */
-        prb = discd->probs +n;  /* and the probability vector */
-        add = (mode & NBC_DWNULL) ? nbc->frqs[k] : discd->cnt;
-        cnt = sp +add;          /* compute denominator of estimator */
-        if (cnt <= 0)           /* if the estimator is invalid, */
-          while (--n >= 0) *--prb = 0;      /* clear all probs. */
-        else {                  /* if the estimator is valid */
-          add = lcorr +(add -discd->cnt) /n;
-          for (frq = discd->frqs +n; --n >= 0; )
-            *--prb = (*--frq +add) /cnt;
-        }                       /* traverse the value frequencies */
-      } }                       /* and estimate the probabilities */
-    else {                      /* -- if the attribute is numeric */
-      for (normd = dvec->normds +(k = nbc->clscnt); --k >= 0; ) {
-        cnt = (--normd)->cnt;   /* traverse the distributions */
-        normd->exp = (cnt > 0) ? normd->sv /cnt : 0;
-        if (!(mode & NBC_MAXLLH)) cnt -= 1;
-        normd->var = (cnt > 0)
-                   ? (normd->sv2 -normd->exp *normd->sv) /cnt : 0;
-      }                         /* estimate the expected value */
-    }                           /* and the variance */
-  }                             /* (max. likelihood estimator) */
+  if (incr) {                   /* if to set up incrementally, */
+    for (i = nbc->dcnt; --i >= 0; ) {  /* traverse only */
+      dvec = nbc->dvecs +nbc->dlist[i];  /* the changed atts. */
+      r |= _estim(nbc, nbc->dlist[i], mode, lcorr, tsum);
+      dvec->dirty = 0;          /* estimate the probabilities */
+    } }                         /* and clear the change flag */
+  else {                        /* if to set up all attributes */
+    for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
+      (--dvec)->dirty = 0;      /* traverse all attributes */
+      if (dvec->type == 0) {    /* except the class attribute */
+        dvec->mark = 0; continue; }
+      r |= _estim(nbc, i, mode, lcorr, tsum);
+    }                           /* estimate the probabilities */
+  }
+  nbc->dcnt = (r) ? -1 : 0;     /* clear the list of changed atts. */
   nbc->dvecs[nbc->clsid].mark = 1;  /* mark the class attribute */
+  return r;                     /* return the error status */
 }  /* nbc_setup() */
 
 /*----------------------------------------------------------------------
@@ -804,55 +2392,155 @@ Source: R.L. Larsen and M.L. Marx.
         Prentice Hall, Englewood Cliffs, NJ, USA 1986, pp. 312 & 314
 ----------------------------------------------------------------------*/
 
-int nbc_exec (NBC *nbc, const TUPLE *tpl, double *conf)
-{                               /* --- execute a naive Bayes class. */
-  int        i, k;              /* loop variables */
-  DVEC       *dvec;             /* to traverse the distrib. vectors */
-  const INST *inst;             /* to traverse the instances */
-  double     *s, *d;            /* to traverse the probabilities */
-  double     sum;               /* sum of class probabilities */
+int nbc_compile (NBC *nbc)
+{                               /* --- compile an execution plan */
+  int     i, k, n, c;           /* loop variables, buffers */
+  size_t  z;                    /* size of the attribute tables */
+  DVEC    *dvec;                /* to traverse the distrib. vectors */
+  NORMD   *normd;               /* to traverse the normal distribs. */
+  NBCPLAN *plan;                /* created execution plan */
+  CATT    *att;                 /* to traverse the compiled atts. */
+  double  *tab;                 /* to traverse the attribute tables */
 
   assert(nbc);                  /* check the function argument */
-
-  /* --- initialize --- */
-  s = nbc->priors +nbc->clscnt; /* init. the posterior distribution */
-  d = nbc->posts  +nbc->clscnt; /* with  the prior     distribution */
-  for (k = nbc->clscnt; --k >= 0; ) *--d = *--s;
-
-  /* --- process attribute values --- */
+  if (nbc->quant) return 0;     /* keep a quantized plan */
+  n = 0; z = 1;                 /* init. the counters */
   for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
     if (((--dvec)->type == 0)   /* traverse all attributes */
     ||  (   dvec ->mark <  0))  /* except the class attribute */
       continue;                 /* and all unmarked attributes */
-    inst = (tpl)                /* get the attribute instantiation */
-         ? tpl_colval(tpl, i)   /* from the tuple or the att. set */
-         : att_inst(as_att(nbc->attset, i));
-    if (_exec(nbc, i, inst) < 0)/* execute the classifier */
-      continue;                 /* for the current attribute */
-    s = nbc->cond +nbc->clscnt; /* traverse the cond. probabilities */
-    d = nbc->posts+nbc->clscnt; /* and the posterior distribution */
-    for (sum = 0, k = nbc->clscnt; --k >= 0; )
-      sum += *--d *= *--s;      /* multiply with cond. probabilities */
-    if ((sum > 1e-24) && (sum < 1e24))
-      continue;                 /* if the sum is ok, continue */
-    if (sum <= 0) break;        /* if the sum is fubar, abort */
-    for (d += k = nbc->clscnt; --k >= 0; )
-      *--d /= sum;              /* otherwise renormalize in order */
-  }                             /* to avoid an over- or underflow */
-  s = d = nbc->posts;           /* traverse the final distribution */
-  for (sum = *s, k = nbc->clscnt; --k > 0; ) {
-    if (*++s > *d) d = s;       /* find the most probable class */
-    sum += *s;                  /* and sum all probabilities */
-  }                             /* (for the normalization) */
-  sum = (sum > 0) ? 1/sum : 1;  /* compute normalization factor */
-  for (k = nbc->clscnt; --k >= 0; )
-    nbc->posts[k] *= sum;       /* normalize probabilities */
-  if (conf) *conf = *d;         /* get the confidence value and */
-  return (int)(d -nbc->posts);  /* return the classification result */
+    n++;                        /* count the attribute and */
+    z += (size_t)nbc->clscnt    /* sum the sizes of the tables */
+       * (size_t)((dvec->type == AT_NOM) ? dvec->valcnt : 3);
+  }                             /* (nominal: one row per value) */
+  plan = (NBCPLAN*)malloc(sizeof(NBCPLAN)
+                        +((n > 0) ? n-1 : 0) *sizeof(CATT));
+  if (!plan) return -1;         /* create the plan body */
+  plan->tabs = tab = (double*)malloc(z *sizeof(double));
+  if (!tab) { free(plan); return -1; }
+  plan->cnt = n;                /* create the attribute tables */
+  att = plan->atts;             /* traverse the compiled attributes */
+  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
+    if (((--dvec)->type == 0)   /* traverse the attributes */
+    ||  (   dvec ->mark <  0))  /* in the same order as _logpost, */
+      continue;                 /* so that sums are not reordered */
+    att->attid  = i;            /* note the attribute identifier, */
+    att->type   = dvec->type;   /* the attribute type, and */
+    att->valcnt = dvec->valcnt; /* the number of values */
+    att->tab    = tab;          /* set the attribute table */
+    att->scale  = 0;            /* (no fixed-point numbers) */
+    if (dvec->type == AT_NOM) { /* -- if the attribute is nominal */
+      for (k = 0; k < dvec->valcnt; k++)
+        for (c = 0; c < nbc->clscnt; c++)
+          *tab++ = dvec->discds[c].lprobs[k]; }
+                                /* copy the log. probs. value major */
+    else {                      /* -- if the attribute is numeric */
+      normd = dvec->normds;     /* traverse the normal distributions */
+      for (c = nbc->clscnt; --c >= 0; normd++) {
+        *tab++ = normd->exp;    /* copy the expected value and */
+        *tab++ = normd->ivar;   /* the parameters of the */
+        *tab++ = normd->lnrm;   /* logarithm of the density */
+      }                         /* (one triplet per class) */
+    }
+    att++;                      /* go to the next compiled attribute */
+  }                             /* (all tables in one memory block) */
+  if (nbc->plan) _plandel(nbc->plan);
+  nbc->plan = plan;             /* replace the execution plan */
+  return 0;                     /* return 'ok' */
+}  /* nbc_compile() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_exec (NBC *nbc, const TUPLE *tpl, double *conf)
+{                               /* --- execute a naive Bayes class. */
+  assert(nbc);                  /* check the function argument */
+  _logpost(nbc, (tpl) ? tpl_colval(tpl, 0) : NULL,
+           nbc->posts, nbc->cond);     /* compute log. posteriors */
+  return _norm(nbc->posts, nbc->clscnt, conf);   /* and normalize */
 }  /* nbc_exec() */
 
 /*--------------------------------------------------------------------*/
 
+int nbc_execsp (NBC *nbc, const SPINST *insts, int cnt, double *conf)
+{                               /* --- execute on a sparse instant. */
+  int  k;                       /* attribute identifier */
+  DVEC *dvec;                   /* distribution vector of attribute */
+
+  assert(nbc && (insts || (cnt <= 0)));  /* check the arguments */
+  _init(nbc, nbc->posts);       /* start with the prior distribution */
+  for (insts += cnt; --cnt >= 0; ) {
+    --insts;                    /* traverse the given instances */
+    k = (insts->attid < 0) ? -insts->attid : insts->attid;
+    assert(k < nbc->attcnt);    /* (the sign of a hashed token */
+    dvec = nbc->dvecs +k;       /*  only matters for training) */
+    if ((dvec->type == 0)       /* skip the class attribute */
+    ||  (dvec->mark <  0))      /* and all unmarked attributes */
+      continue;                 /* (absent attributes count as null) */
+    if (_exec(nbc, k, &insts->inst, nbc->cond) == 0)
+      _mult(nbc->posts, nbc->cond, nbc->clscnt);
+  }                             /* execute the classifier for the */
+                                /* attribute and add the log. probs. */
+  return _norm(nbc->posts, nbc->clscnt, conf);
+}  /* nbc_execsp() */
+
+/*--------------------------------------------------------------------*/
+
+NBCWS* nbc_wscreate (const NBC *nbc)
+{                               /* --- create an execution workspace */
+  NBCWS *ws;                    /* created workspace */
+
+  assert(nbc);                  /* check the function argument */
+  ws = (NBCWS*)malloc(sizeof(NBCWS));
+  if (!ws) return NULL;         /* create the workspace body */
+  ws->clscnt = (nbc->clscnt > 0) ? nbc->clscnt : 1;
+  ws->posts  = (double*)malloc(ws->clscnt *2 *sizeof(double));
+  if (!ws->posts) { free(ws); return NULL; }
+  ws->cond   = ws->posts +ws->clscnt;
+  return ws;                    /* create the class vectors */
+}  /* nbc_wscreate() */         /* and return the workspace */
+
+/*--------------------------------------------------------------------*/
+
+void nbc_wsdelete (NBCWS *ws)
+{                               /* --- delete an execution workspace */
+  assert(ws);                   /* check the function argument */
+  free(ws->posts);              /* delete the class vectors */
+  free(ws);                     /* and the workspace body */
+}  /* nbc_wsdelete() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_exec_r (const NBC *nbc, NBCWS *ws, const INST *insts,
+                double *conf)
+{                               /* --- execute a naive Bayes class. */
+  assert(nbc && ws && insts     /* check the function arguments */
+      && (ws->clscnt >= nbc->clscnt));
+  _logpost(nbc, insts, ws->posts, ws->cond);
+  return _norm(ws->posts, nbc->clscnt, conf);
+}  /* nbc_exec_r() */           /* compute and normalize posteriors */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_exec_batch (const NBC *nbc, TUPLE *const *tpls, int n,
+                    int *classes, double *confs, double *posts)
+{                               /* --- execute on a set of tuples */
+  assert(nbc && (tpls || (n <= 0)) && classes);
+  if (n <= 0) return 0;         /* check for an empty set of tuples */
+  return _batch(nbc, tpls, NULL, n, classes, confs, posts);
+}  /* nbc_exec_batch() */       /* execute on the tuples */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_exec_block (const NBC *nbc, const INST *cols, int n,
+                    int *classes, double *confs, double *posts)
+{                               /* --- execute on a column block */
+  assert(nbc && (cols || (n <= 0)) && classes);
+  if (n <= 0) return 0;         /* check for an empty block */
+  return _batch(nbc, NULL, cols, n, classes, confs, posts);
+}  /* nbc_exec_block() */       /* execute on the instances */
+
+/*--------------------------------------------------------------------*/
+
 void nbc_rand (NBC *nbc, double drand (void))
 {                               /* --- generate a random tuple */
   int    i, k, n;               /* loop variables */
@@ -893,7 +2581,7 @@ void nbc_rand (NBC *nbc, double drand (void))
 
 /*--------------------------------------------------------------------*/
 
-int nbc_desc (NBC *nbc, FILE *file, int mode, int maxlen)
+int nbc_desc (const NBC *nbc, FILE *file, int mode, int maxlen)
 {                               /* --- describe a naive Bayes class. */
   int         i, k, n;          /* loop variables */
   int         pos, ind;         /* current position and indentation */
@@ -903,10 +2591,13 @@ int nbc_desc (NBC *nbc, FILE *file, int mode, int maxlen)
   const DVEC  *dvec;            /* to traverse the distrib. vectors */
   const NORMD *normd;           /* to traverse the normal   distribs. */
   const DISCD *discd;           /* to traverse the discrete distribs. */
+  static const NORMD nul = { 0, 0, 0, 0, 0, 0, 0 };
+                                /* empty normal distribution */
   char  name[4*AS_MAXLEN+4];    /* output buffer for names */
   char  num[64];                /* output buffer for numbers */
 
   assert(nbc && file);          /* check the function arguments */
+  if (nbc->quant) return -2;    /* quantized plans have no distribs. */
 
   /* --- print a header (as a comment) --- */
   if (mode & NBC_TITLE) {       /* if the title flag is set */
@@ -929,8 +2620,14 @@ int nbc_desc (NBC *nbc, FILE *file, int mode, int maxlen)
     fprintf(file, "  params = %g", nbc->lcorr);
     if (nbc->mode & NBC_DWNULL) fputs(", dwnull", file);
     if (nbc->mode & NBC_MAXLLH) fputs(", maxllh", file);
+    if (nbc->mode & NBC_MULTI)  fputs(", multi",  file);
     fputs(";\n", file);         /* print Laplace correction */
   }                             /* and estimation mode */
+  if (nbc->bktcnt > 0) {        /* if feature hashing is used */
+    fprintf(file, "  hash = %d, %u", nbc->bktcnt, nbc->seed);
+    if (nbc->hmode & NBC_HSIGN) fputs(", sign", file);
+    fputs(";\n", file);         /* print the number of buckets, */
+  }                             /* the seed, and the hashing mode */
 
   /* --- print the class distribution --- */
   fputs("  prob(", file);       /* print a distribution indicator */
@@ -965,9 +2662,9 @@ int nbc_desc (NBC *nbc, FILE *file, int mode, int maxlen)
     sc_format(name, clsname,0); /* format and print */
     fputs(name, file);          /* the class attribute name */
     fputs(") = {\n    ", file); /* and start the cond. distribution */
-    if (dvec->discds) {         /* if the attribute is nominal, */
+    if (dvec->type == AT_NOM) { /* if the attribute is nominal, */
       discd = dvec->discds;     /* traverse the discrete distribs. */
-      for (i = 0; i < nbc->clscnt; discd++, i++) {
+      for (i = 0; i < nbc->clscnt; i++) {
         if (i > 0)              /* if this is not the first class, */
           fputs(",\n    ", file);       /* start a new output line */
         len = sc_format(name, att_valname(clsatt, i), 0);
@@ -979,10 +2676,11 @@ int nbc_desc (NBC *nbc, FILE *file, int mode, int maxlen)
         for (k = 0; k < dvec->valcnt; k++) {
           if (k > 0) {          /* if this is not the first value, */
             putc(',', file); pos++; }         /* print a separator */
-          len  = sc_format(name, att_valname(att, k), 0);
-          len += l = sprintf(num, ": %g", discd->frqs[k]);
+          len  = sc_format(name, _valname(nbc, n, k), 0);
+          len += l = sprintf(num, ": %g", (discd) ? discd[i].frqs[k]:0);
           if (mode & NBC_REL)   /* format value frequency */
-            len += sprintf(num +l, " (%.1f%%)", discd->probs[k]*100);
+            len += sprintf(num +l, " (%.1f%%)",
+                           (discd) ? discd[i].probs[k]*100 : 0.0);
           if ((pos      > ind)  /* if the line would get too long */
           &&  (pos +len > maxlen -4)) {
             putc('\n', file);   /* start a new line and indent */
@@ -995,19 +2693,22 @@ int nbc_desc (NBC *nbc, FILE *file, int mode, int maxlen)
         fputs(" }", file);      /* terminate the value distribution */
       } }
     else {                      /* if the attribute is numeric, */
-      normd = dvec->normds;     /* traverse the normal distributions */
-      for (i = 0; i < nbc->clscnt; normd++, i++) {
+      for (i = 0; i < nbc->clscnt; i++) {
+        normd = (dvec->normds) ? dvec->normds +i : &nul;
         if (i > 0)              /* if this is not the first class, */
           fputs(",\n    ", file);       /* start a new output line */
         len = sc_format(name, att_valname(clsatt, i), 0);
         fputs(name, file);      /* get and print the class name */
         for (pos = len+2; pos < ind; pos++)
           putc(' ', file);      /* pad with blanks to equal width */
-        fprintf(file, ": N(%g, %g) [%g]",
-                normd->exp, normd->var, normd->cnt);
+        if ((nbc->mode & NBC_MULTI) && (dvec->type == AT_INT))
+          fprintf(file, ": M(%g) [%g]", normd->sv, normd->cnt);
+        else                    /* print the token frequency or */
+          fprintf(file, ": N(%g, %g) [%g]",
+                  normd->exp, normd->var, normd->cnt);
       }                         /* print the normal distribution */
       putc(' ', file);          /* with expected value and variance */
-    }  /* if (dvec->discds) .. else .. */
+    }  /* if (dvec->type == AT_NOM) .. else .. */
     fputs("};\n", file);        /* terminate the distributions */
   }  /* for (n = 0; .. */
   fputs("};\n", file);          /* terminate the classifier */
@@ -1015,21 +2716,553 @@ int nbc_desc (NBC *nbc, FILE *file, int mode, int maxlen)
   return ferror(file) ? -1 : 0; /* return the write status */
 }  /* nbc_desc() */
 
+/*----------------------------------------------------------------------
+  Binary Model Files
+----------------------------------------------------------------------*/
+
+static BINOFF _bput (BINBUF *b, const void *data, size_t n, size_t align)
+{                               /* --- append data to a binary file */
+  size_t o, z;                  /* offset of the data, new size */
+  char   *p;                    /* buffer for reallocation */
+
+  assert(b && (align > 0));     /* check the function arguments */
+  if (b->err) return 0;         /* check for an earlier error */
+  o = (b->used +align-1) /align *align;
+  if (o +n > b->size) {         /* if the buffer is too small */
+    z = (b->size > 0) ? b->size << 1 : 4096;
+    while (z < o +n) z <<= 1;   /* compute a new buffer size */
+    p = (char*)realloc(b->buf, z);
+    if (!p) { b->err = -1; return 0; }
+    b->buf = p; b->size = z;    /* enlarge the buffer */
+  }
+  memset(b->buf +b->used, 0, o -b->used);
+  if (data) memcpy(b->buf +o, data, n);  /* copy the data */
+  else      memset(b->buf +o, 0,    n);  /* or clear the space */
+  b->used = o +n;               /* update the number of used bytes */
+  if (b->used > (BINOFF)-1) b->err = -1;
+  return (BINOFF)o;             /* return the offset of the data */
+}  /* _bput() */
+
+/*----------------------------------------------------------------------
+Quantized log. probabilities:
+The posterior distribution does not change if the same constant is
+added to the log. probabilities of all classes for an attribute value.
+Hence the table row of value k is stored as the distances
+  d_kc = \max_{c'} \ln P(A=k|C=c') - \ln P(A=k|C=c) \in [0, r],
+where r is the largest such distance in the table of the attribute.
+With b-bit fixed-point numbers the distances are stored as
+round(d_kc /s) with the per-attribute scale s = r /(2^b -1), so that
+the error of a table entry is at most e = s/2. With 32 bit floats the
+distances are rounded to the nearest float, so that e = r *2^{-24}.
+
+If E is the sum of the entry errors e over all marked nominal
+attributes, every log. posterior \ln p_c (before normalization) is
+changed by some \delta_c with |\delta_c| <= E. The normalized
+posteriors then satisfy
+  e^{-2E} <= p'_c / p_c <= e^{2E}
+and hence |p'_c - p_c| <= p_c (e^{2E} -1) <= e^{2E} -1. The predicted
+class can only change if the two largest log. posteriors differ by
+less than 2E. The bound E is stored in the binary file (nbc_qerr).
+Numeric attributes and the prior probabilities are not quantized.
+----------------------------------------------------------------------*/
+
+static double _bquant (BINBUF *b, const NBC *nbc, const DVEC *dvec,
+                       int quant, double *scale)
+{                               /* --- store a quantized table */
+  int            k, c;          /* loop variables */
+  const double   *lpr;          /* log. probs. of a value */
+  double         min, max, r;   /* range of a row, max. distance */
+  double         qmax, d;       /* maximal code, distance to maximum */
+  float          f;             /* buffer for a 32 bit float */
+  unsigned short q16;           /* buffer for a 16 bit code */
+  unsigned char  q8;            /* buffer for an 8 bit code */
+
+  assert(b && nbc && dvec && scale);  /* check the function args. */
+  for (r = 0, k = dvec->valcnt; --k >= 0; ) {
+    min = DBL_MAX; max = -DBL_MAX;    /* traverse the values */
+    for (c = nbc->clscnt; --c >= 0; ) {
+      d = dvec->discds[c].lprobs[k];
+      if (d < min) min = d;     /* traverse the classes and */
+      if (d > max) max = d;     /* determine the range of the */
+    }                           /* log. probs. of the value */
+    if (max -min > r) r = max -min;
+  }                             /* determine the maximal distance */
+  qmax   = (quant == NBC_Q16) ? 65535.0 : 255.0;
+  *scale = (quant == NBC_F32) ? 0 : (r > 0) ? r /qmax : 1;
+  for (k = 0; k < dvec->valcnt; k++) {
+    max = -DBL_MAX;             /* traverse the values and */
+    for (c = nbc->clscnt; --c >= 0; ) {  /* find the row maximum */
+      d = dvec->discds[c].lprobs[k]; if (d > max) max = d; }
+    for (c = 0; c < nbc->clscnt; c++) {
+      lpr = dvec->discds[c].lprobs +k;
+      d   = max -*lpr;          /* traverse the classes and compute */
+      if (quant == NBC_F32) {   /* the distances to the row maximum */
+        f = (float)-d; _bput(b, &f, sizeof(float), sizeof(float));
+        continue;               /* store a float (negated distance) */
+      }                         /* or a fixed-point number */
+      d = floor(d /(*scale) +0.5); if (d > qmax) d = qmax;
+      if (quant == NBC_Q16) {   /* if 16 bit fixed-point numbers */
+        q16 = (unsigned short)d; _bput(b, &q16, sizeof(q16), 2); }
+      else {                    /* if  8 bit fixed-point numbers */
+        q8  = (unsigned char) d; _bput(b, &q8,  sizeof(q8),  1); }
+    }                           /* store the codes value major */
+  }                             /* (as the table of nbc_compile) */
+  if (r <= 0) return 0;         /* constant rows are exact */
+  return (quant == NBC_F32)     /* return the error bound */
+       ? r *FLT_EPSILON *0.5 : *scale *0.5;  /* of a table entry */
+}  /* _bquant() */
+
+/*--------------------------------------------------------------------*/
+
+static double _battput (BINBUF *b, const NBC *nbc, int attid,
+                        BINATT *ba, int quant)
+{                               /* --- write an attribute to a file */
+  int         i, k, c, n;       /* loop variables, buffers */
+  ATT         *att;             /* attribute to write */
+  const DVEC  *dvec;            /* distribution vector of attribute */
+  const DISCD *discd;           /* to traverse the discrete distribs. */
+  const NORMD *normd;           /* to traverse the normal   distribs. */
+  const char  *s;               /* value name */
+  BINOFF      *vals;            /* offsets of the value names */
+  int         *htab;            /* hash table of the value names */
+
+  assert(b && nbc && ba);       /* check the function arguments */
+  att  = as_att(nbc->attset, attid);
+  dvec = nbc->dvecs +attid;     /* get attribute and distributions */
+  memset(ba, 0, sizeof(BINATT));/* clear the attribute record */
+  s = att_name(att);            /* and store the attribute name */
+  ba->name     = _bput(b, s, strlen(s)+1, 1);
+  ba->type     = att_type(att); /* note the attribute type, */
+  ba->mark     = dvec->mark;    /* the distribution vector mark, */
+  ba->valwd[0] = att_valwd(att, 0);      /* and the widths */
+  ba->valwd[1] = att_valwd(att, 1);      /* of the value names */
+  n = (dvec->type == 0) ? nbc->clscnt : dvec->valcnt;
+  if ((ba->type == AT_NOM) && (n > 0)) {
+    ba->valcnt = n;             /* if the attribute is nominal */
+    for (ba->vhsz = 2; ba->vhsz < 2*n; ) ba->vhsz <<= 1;
+    vals = (BINOFF*)malloc(n *sizeof(BINOFF) +ba->vhsz *sizeof(int));
+    if (!vals) { b->err = -1; return 0; }
+    htab = (int*)(vals +n);     /* create vectors for the names */
+    for (i = ba->vhsz; --i >= 0; ) htab[i] = -1;
+    for (k = 0; k < n; k++) {   /* traverse the values */
+      s = _valname(nbc, attid, k);
+      vals[k] = _bput(b, s, strlen(s)+1, 1);
+      for (i = (int)(_strhash(s) & (ba->vhsz-1)); htab[i] >= 0; )
+        i = (i+1) & (ba->vhsz-1);
+      htab[i] = k;              /* store the value name and */
+    }                           /* insert it into the hash table */
+    ba->vals  = _bput(b, vals, n *sizeof(BINOFF),      BINALIGN);
+    ba->vhash = _bput(b, htab, ba->vhsz *sizeof(int), BINALIGN);
+    free(vals);                 /* store the value names */
+  }                             /* and their hash table */
+  if ((dvec->type == 0)         /* if this is the class attribute */
+  ||  (!dvec->discds && !dvec->normds))  /* or it has no data, */
+    return 0;                   /* there is nothing else to do */
+  if (quant) {                  /* -- if to quantize the tables */
+    if (dvec->mark < 0) return 0;    /* store only the tables */
+    ba->tab = _bput(b, NULL, 0, BINALIGN);   /* of marked atts. */
+    if (dvec->type == AT_NOM)   /* (no distributions, inference only) */
+      return _bquant(b, nbc, dvec, quant, &ba->scale);
+    for (normd = dvec->normds, c = nbc->clscnt; --c >= 0; normd++) {
+      _bput(b, &normd->exp,  sizeof(double), sizeof(double));
+      _bput(b, &normd->ivar, sizeof(double), sizeof(double));
+      _bput(b, &normd->lnrm, sizeof(double), sizeof(double));
+    }                           /* store the parameters of the */
+    return 0;                   /* log. density unchanged */
+  }                             /* (numeric atts. are not quantized) */
+  if (dvec->type == AT_NOM) {   /* -- if the attribute is nominal */
+    ba->dists = _bput(b, NULL, 0, BINALIGN);
+    for (discd = dvec->discds, c = 0; c < nbc->clscnt; discd++, c++) {
+      _bput(b, &discd->cnt, sizeof(double), sizeof(double));
+      if (n <= 0) continue;     /* store the total frequency */
+      _bput(b, discd->frqs,   n *sizeof(double), sizeof(double));
+      _bput(b, discd->probs,  n *sizeof(double), sizeof(double));
+      _bput(b, discd->lprobs, n *sizeof(double), sizeof(double));
+    }                           /* store the value distributions */
+    if (dvec->mark < 0) return 0;    /* if the att. is not marked, */
+    ba->tab = _bput(b, NULL, 0, BINALIGN);       /* abort, otherwise */
+    for (k = 0; k < n; k++)     /* store a value major table */
+      for (c = 0; c < nbc->clscnt; c++)   /* (as nbc_compile) */
+        _bput(b, dvec->discds[c].lprobs +k, sizeof(double),
+              sizeof(double)); }
+  else {                        /* -- if the attribute is numeric */
+    ba->dists = _bput(b, dvec->normds, nbc->clscnt *sizeof(NORMD),
+                      BINALIGN);/* store the normal distributions */
+    if (dvec->mark < 0) return 0;    /* if the att. is not marked, */
+    ba->tab = _bput(b, NULL, 0, BINALIGN);       /* abort, otherwise */
+    for (normd = dvec->normds, c = nbc->clscnt; --c >= 0; normd++) {
+      _bput(b, &normd->exp,  sizeof(double), sizeof(double));
+      _bput(b, &normd->ivar, sizeof(double), sizeof(double));
+      _bput(b, &normd->lnrm, sizeof(double), sizeof(double));
+    }                           /* store the parameters of the */
+  }                             /* log. density (as nbc_compile) */
+  return 0;                     /* return 'no quantization error' */
+}  /* _battput() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_save (const NBC *nbc, FILE *file, int mode)
+{                               /* --- save a classifier (binary) */
+  int    i, n, r;               /* loop variable, buffers */
+  BINBUF b;                     /* buffer for the file contents */
+  BINHDR hdr;                   /* header of the binary file */
+  BINATT ba;                    /* buffer for an attribute record */
+
+  assert(nbc && file);          /* check the function arguments */
+  if (nbc->quant) return -2;    /* quantized plans have no distribs. */
+  memset(&hdr, 0, sizeof(BINHDR));
+  memcpy(hdr.magic, NBC_MAGIC, 4);
+  hdr.version = NBC_BINVER;     /* fill the file header */
+  hdr.bom     = BINBOM;         /* (magic number, version, and */
+  hdr.hdrsz   = (int)sizeof(BINHDR);  /* a description of the */
+  hdr.attsz   = (int)sizeof(BINATT);  /* binary representation, */
+  hdr.dblsz   = (int)sizeof(double);  /* so that incompatible */
+  hdr.clscnt  = nbc->clscnt;    /* files can be recognized) */
+  hdr.mode    = nbc->mode;
+  hdr.quant   = (mode & NBC_Q8)  ? NBC_Q8     /* get the */
+              : (mode & NBC_Q16) ? NBC_Q16    /* quantization mode */
+              : (mode & NBC_F32) ? NBC_F32 : 0;
+  hdr.bktcnt  = nbc->bktcnt;    /* note the hashing parameters */
+  hdr.seed    = nbc->seed;
+  hdr.hmode   = nbc->hmode;
+  if (nbc->bktcnt > 0)          /* all buckets must be stored, */
+    mode &= ~NBC_MARKED;        /* as their ids. are computed */
+  hdr.lcorr   = nbc->lcorr;
+  hdr.total   = nbc->total;
+  for (n = i = 0; i < nbc->attcnt; i++) {
+    if (i == nbc->clsid) hdr.clsid = n;
+    if ((i == nbc->clsid) || !(mode & NBC_MARKED)
+    ||  (nbc->dvecs[i].mark >= 0)) n++;
+  }                             /* count the attributes to store */
+  hdr.attcnt  = n;              /* (in marked mode only the class */
+  b.buf = NULL; b.size = b.used = 0; b.err = 0;   /* and the */
+  _bput(&b, &hdr, sizeof(BINHDR), BINALIGN);   /* marked atts.) */
+  hdr.atts = _bput(&b, NULL, n *sizeof(BINATT), BINALIGN);
+  hdr.frqs = _bput(&b, nbc->frqs,    nbc->clscnt *sizeof(double),
+                   BINALIGN);   /* store the class frequencies, */
+  _bput(&b, nbc->priors,  nbc->clscnt *sizeof(double), sizeof(double));
+  _bput(&b, nbc->lpriors, nbc->clscnt *sizeof(double), sizeof(double));
+  for (n = i = 0; i < nbc->attcnt; i++) {  /* the prior probs. */
+    if ((i != nbc->clsid) && (mode & NBC_MARKED)
+    &&  (nbc->dvecs[i].mark < 0)) continue;
+    hdr.qerr += _battput(&b, nbc, i, &ba, hdr.quant);
+    if (!b.err) memcpy(b.buf +hdr.atts +n *sizeof(BINATT), &ba,
+                       sizeof(BINATT));
+    n++;                        /* store the attribute record */
+  }                             /* and count it */
+  hdr.size = (BINOFF)b.used;    /* note the size of the file */
+  if (!b.err) memcpy(b.buf, &hdr, sizeof(BINHDR));
+  r = (b.err || (fwrite(b.buf, 1, b.used, file) != b.used)) ? -1 : 0;
+  if (b.buf) free(b.buf);       /* write the file contents */
+  return r;                     /* and return the write status */
+}  /* nbc_save() */
+
+/*--------------------------------------------------------------------*/
+
+static NBCSHR* _map (const char *fname, int mode)
+{                               /* --- map a binary model file */
+  NBCSHR *shr;                  /* memory block for the file */
+  FILE   *file;                 /* file to read */
+  long   size;                  /* size of the file */
+  #ifdef NBC_MMAP
+  int    fd;                    /* file descriptor */
+  struct stat st;               /* file status */
+  void   *map;                  /* mapped file */
+  #endif
+
+  assert(fname);                /* check the function argument */
+  shr = (NBCSHR*)malloc(sizeof(NBCSHR));
+  if (!shr) return NULL;        /* create a shared memory block */
+  shr->refs  = 1; shr->slabs  = NULL; shr->base = NULL;
+  shr->map   = NULL; shr->size = 0; shr->mapped = 0;
+  #ifdef NBC_MMAP
+  if (!(mode & NBC_READ)) {     /* if to map the file, */
+    fd = open(fname, O_RDONLY); /* open the file and get its size */
+    if (fd < 0) { free(shr); return NULL; }
+    if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+      map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,fd,0);
+      if (map != MAP_FAILED) {  /* map the file into memory */
+        shr->map  = map; shr->mapped = 1;
+        shr->size = (size_t)st.st_size;
+      }                         /* (read-only, so that the pages */
+    }                           /*  can be shared between processes) */
+    close(fd);                  /* close the file descriptor */
+    if (shr->map) return shr;   /* (no longer needed for the map) */
+  }                             /* (a mapped file must not change */
+  #endif                        /*  while the map is in use) */
+  file = fopen(fname, "rb");    /* if the file cannot be mapped, */
+  if (!file) { free(shr); return NULL; }    /* read it into memory */
+  if ((fseek(file, 0, SEEK_END) != 0)
+  ||  ((size = ftell(file)) < 0)
+  ||  (fseek(file, 0, SEEK_SET) != 0)) {
+    fclose(file); free(shr); return NULL; }
+  shr->map = malloc((size > 0) ? (size_t)size : 1);
+  if (!shr->map) { fclose(file); free(shr); return NULL; }
+  shr->size = (size_t)size;     /* read the file contents */
+  if (fread(shr->map, 1, shr->size, file) != shr->size) {
+    fclose(file); free(shr->map); free(shr); return NULL; }
+  fclose(file);                 /* close the file */
+  return shr;                   /* and return the memory block */
+}  /* _map() */
+
+/*--------------------------------------------------------------------*/
+
+static int _bcheck (const NBCSHR *shr, BINOFF off, size_t n)
+{                               /* --- check a section of a file */
+  return (off > 0) && (off % sizeof(double) == 0)
+      && (off <= shr->size) && (n <= shr->size -off);
+}  /* _bcheck() */
+
+/*--------------------------------------------------------------------*/
+
+static int _bname (const NBCSHR *shr, BINOFF off)
+{                               /* --- check a name in a file */
+  return (off > 0) && (off < shr->size)
+      && (memchr((char*)shr->map +off, 0, shr->size -off) != NULL);
+}  /* _bname() */
+
+/*--------------------------------------------------------------------*/
+
+static int _bhash (const NBCSHR *shr, const BINATT *ba)
+{                               /* --- check a value hash table */
+  int       i, k, n;            /* loop variables, number of entries */
+  const int *htab;              /* hash table of the value names */
+
+  if (ba->vhsz <= 0) return 1;  /* check for a hash table */
+  htab = (const int*)((const char*)shr->map +ba->vhash);
+  for (n = 0, i = ba->vhsz; --i >= 0; ) {
+    k = htab[i];                /* traverse the hash table entries */
+    if (k <  -1)         return 0;   /* each entry must be empty */
+    if (k >= ba->valcnt) return 0;   /* or a value identifier */
+    if (k >= 0) n++;            /* count the used entries */
+  }                             /* (at most one per value, so that */
+  return (n <= ba->valcnt);     /*  linear probing finds an empty */
+}  /* _bhash() */               /*  entry and terminates) */
+
+/*--------------------------------------------------------------------*/
+
+NBC* nbc_load (const char *fname, int mode)
+{                               /* --- load a classifier (binary) */
+  int          i, k, c, n;      /* loop variables, buffers */
+  NBCSHR       *shr;            /* memory block of the file */
+  const char   *map;            /* contents of the file */
+  const BINHDR *hdr;            /* header of the file */
+  const BINATT *ba;             /* to traverse the attribute records */
+  const BINOFF *vals;           /* offsets of the value names */
+  ATTSET       *attset;         /* created attribute set */
+  ATT          *att;            /* to traverse the attributes */
+  NBC          *nbc;            /* created classifier */
+  DVEC         *dvec;           /* to traverse the distrib. vectors */
+  DISCD        *discd;          /* to traverse the discrete distribs. */
+  NBCPLAN      *plan;           /* execution plan of the classifier */
+  CATT         *catt;           /* to traverse the compiled atts. */
+  double       *frq;            /* to traverse the frequency vectors */
+  size_t       z;               /* size of the distributions */
+  size_t       q;               /* size of a table entry */
+
+  assert(fname);                /* check the function argument */
+  shr = _map(fname, mode);      /* map the file into memory */
+  if (!shr) return NULL;        /* and check its header */
+  map = (const char*)shr->map; hdr = (const BINHDR*)map;
+  if ((shr->size < sizeof(BINHDR))
+  ||  (memcmp(hdr->magic, NBC_MAGIC, 4) != 0)
+  ||  (hdr->version != NBC_BINVER) || (hdr->bom != BINBOM)
+  ||  (hdr->hdrsz != (int)sizeof(BINHDR))
+  ||  (hdr->attsz != (int)sizeof(BINATT))
+  ||  (hdr->dblsz != (int)sizeof(double))
+  ||  (hdr->size  != shr->size)
+  ||  ((hdr->quant != 0)     && (hdr->quant != NBC_F32)
+  &&   (hdr->quant != NBC_Q16) && (hdr->quant != NBC_Q8))
+  ||  (hdr->attcnt <= 0) || (hdr->clscnt < 0)
+  ||  (hdr->bktcnt < 0)       || ((hdr->bktcnt > 0)
+  &&  ((hdr->clsid != 0)      || (hdr->attcnt != hdr->bktcnt+1)))
+  ||  (hdr->clsid  <  0) || (hdr->clsid >= hdr->attcnt)
+  ||  !_bcheck(shr, hdr->atts, hdr->attcnt *sizeof(BINATT))
+  ||  !_bcheck(shr, hdr->frqs, hdr->clscnt *3 *sizeof(double))) {
+    _unmap(shr); free(shr); return NULL; }
+
+  /* --- create the attribute set --- */
+  attset = as_create("domains", att_delete);
+  if (!attset) { _unmap(shr); free(shr); return NULL; }
+  ba = (const BINATT*)(map +hdr->atts);
+  for (i = 0; i < hdr->attcnt; i++) {
+    if (!_bname(shr, ba[i].name)/* traverse the attribute records */
+    ||  ((ba[i].type != AT_NOM) && (ba[i].type != AT_INT)
+    &&   (ba[i].type != AT_REAL))
+    ||  (ba[i].valcnt < 0)      /* check the attribute record */
+    ||  ((ba[i].valcnt <= 0) && (ba[i].vhsz != 0))
+    ||  ((ba[i].valcnt >  0)
+    &&   (!_bcheck(shr, ba[i].vals,  ba[i].valcnt *sizeof(BINOFF))
+    ||    !_bcheck(shr, ba[i].vhash, ba[i].vhsz   *sizeof(int))
+    ||    (ba[i].vhsz < 2*ba[i].valcnt)
+    ||    (ba[i].vhsz & (ba[i].vhsz-1))))) break;
+    vals = (const BINOFF*)(map +ba[i].vals);
+    for (k = ba[i].valcnt; --k >= 0; )
+      if (!_bname(shr, vals[k])) break;
+    if (k >= 0) break;          /* check the value names */
+    if (!_bhash(shr, ba +i)) break;  /* and their hash table */
+    att = att_create(map +ba[i].name, ba[i].type);
+    if (!att) break;            /* create an attribute */
+    if (as_attadd(attset, att) != 0) { att_delete(att); break; }
+    if (i == hdr->clsid) {      /* if this is the class attribute */
+      if ((ba[i].type != AT_NOM) || (ba[i].valcnt != hdr->clscnt))
+        break;                  /* check type and number of classes */
+      for (k = 0; k < ba[i].valcnt; k++)
+        if (att_valadd(att, map +vals[k], NULL) != 0) break;
+      if (k < ba[i].valcnt) break;
+    }                           /* add the class values (in order) */
+    att->valwd[0] = ba[i].valwd[0];  /* set the value name widths */
+    att->valwd[1] = ba[i].valwd[1];  /* (as if all values existed) */
+  }                             /* (other values are only in the */
+  if (i < hdr->attcnt) {        /*  file and are looked up there) */
+    as_delete(attset); _unmap(shr); free(shr); return NULL; }
+
+  /* --- create the classifier --- */
+  nbc = nbc_create(attset, hdr->clsid);
+  if (!nbc) { as_delete(attset); _unmap(shr); free(shr); return NULL; }
+  nbc->shr = shr;               /* note the file memory block */
+  nbc->bin = map;               /* and the file contents */
+  nbc->mode  = hdr->mode;       /* copy the estimation parameters */
+  nbc->lcorr = hdr->lcorr;      /* and the class distribution */
+  nbc->total = hdr->total;
+  nbc->quant = hdr->quant;      /* note the quantization mode */
+  nbc->qerr  = hdr->qerr;       /* and the error bound */
+  nbc->bktcnt = hdr->bktcnt;    /* copy the hashing parameters */
+  nbc->seed   = hdr->seed;
+  nbc->hmode  = hdr->hmode & NBC_HSIGN;
+  q = (hdr->quant == NBC_F32) ? sizeof(float)    /* get the size */
+    : (hdr->quant == NBC_Q16) ? sizeof(short)    /* of an entry */
+    : (hdr->quant == NBC_Q8)  ? 1 : sizeof(double);
+  k = hdr->clscnt *sizeof(double);
+  frq = (double*)(map +hdr->frqs);
+  memcpy(nbc->frqs,    frq,                k);
+  memcpy(nbc->priors,  frq +  hdr->clscnt, k);
+  memcpy(nbc->lpriors, frq +2*hdr->clscnt, k);
+  n = 0;                        /* init. the number of marked atts. */
+  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
+    (--dvec)->mark = ba[i].mark;/* traverse the distribution vectors */
+    if (dvec->type == 0) continue;   /* skip the class attribute */
+    dvec->valcnt = dvec->valvsz = ba[i].valcnt;
+    if (hdr->quant) {           /* if the tables are quantized, */
+      if (dvec->mark < 0) continue;  /* there are no distributions */
+      z = (dvec->type == AT_NOM)     /* (inference only) */
+        ? (size_t)dvec->valcnt *q : 3 *sizeof(double);
+      if (!_bcheck(shr, ba[i].tab, z *nbc->clscnt)) break;
+      n++; continue;            /* check the table of the plan */
+    }                           /* and count the marked attribute */
+    if (ba[i].dists == 0) {     /* if there are no distributions, */
+      if (dvec->mark >= 0) break;    /* the att. must be unmarked */
+      continue;                 /* (distributions are needed */
+    }                           /*  for the compiled plan) */
+    dvec->shared = 1;           /* distributions are in the file */
+    if (dvec->type == AT_NOM) { /* -- if the attribute is nominal */
+      z = (size_t)nbc->clscnt *(1 +3*(size_t)dvec->valcnt);
+      if (!_bcheck(shr, ba[i].dists, z *sizeof(double))) break;
+      discd = (DISCD*)_alloc(nbc, NDBL(nbc->clsvsz, DISCD));
+      if (!discd) break;        /* create a vector of discrete dists. */
+      frq = (double*)(map +ba[i].dists);
+      for (c = 0; c < nbc->clscnt; c++) {
+        discd[c].cnt  = *frq++; /* set the total frequency */
+        discd[c].frqs = discd[c].probs = discd[c].lprobs = NULL;
+        if (dvec->valcnt <= 0) continue;
+        discd[c].frqs   = frq;  frq += dvec->valcnt;
+        discd[c].probs  = frq;  frq += dvec->valcnt;
+        discd[c].lprobs = frq;  frq += dvec->valcnt;
+      }                         /* set the value distributions */
+      dvec->discds = discd;     /* (they are not copied, but */
+      z = (size_t)dvec->valcnt; }  /* used directly from the file) */
+    else {                      /* -- if the attribute is numeric */
+      if (!_bcheck(shr, ba[i].dists, nbc->clscnt *sizeof(NORMD)))
+        break;                  /* check the normal distributions */
+      dvec->normds = (NORMD*)(map +ba[i].dists);
+      z = 3;                    /* use the normal distributions */
+    }                           /* directly from the file */
+    if (dvec->mark < 0) continue;    /* check the compiled table */
+    if (!_bcheck(shr, ba[i].tab, z *nbc->clscnt *sizeof(double)))
+      break;                    /* of a marked attribute */
+    n++;                        /* count the marked attribute */
+  }
+  if (i >= 0) { nbc_delete(nbc, 1); return NULL; }
+  nbc->dcnt = 0;                /* the classifier has been set up */
+
+  /* --- create the execution plan --- */
+  plan = (NBCPLAN*)malloc(sizeof(NBCPLAN)
+                        +((n > 0) ? n-1 : 0) *sizeof(CATT));
+  if (!plan) { nbc_delete(nbc, 1); return NULL; }
+  plan->cnt  = n;               /* create the plan body */
+  plan->tabs = NULL;            /* (the tables are in the file) */
+  catt = plan->atts;            /* traverse the compiled attributes */
+  for (dvec = nbc->dvecs +(i = nbc->attcnt); --i >= 0; ) {
+    if (((--dvec)->type == 0)   /* traverse the attributes */
+    ||  (   dvec ->mark <  0))  /* in the same order as nbc_compile */
+      continue;                 /* (class and unmarked atts. skipped) */
+    catt->attid  = i;           /* note the attribute identifier, */
+    catt->type   = dvec->type;  /* the attribute type, and */
+    catt->valcnt = dvec->valcnt;/* the number of values */
+    catt->tab    = map +ba[i].tab;
+    catt->scale  = ba[i].scale; /* use the table from the file */
+    catt++;                     /* (possibly quantized) */
+  }                             /* and go to the next attribute */
+  nbc->plan = plan;             /* set the execution plan */
+  return nbc;                   /* return the loaded classifier */
+}  /* nbc_load() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_valid (const NBC *nbc, int attid, const char *name)
+{                               /* --- get the identifier of a value */
+  int          i, k;            /* hash bin index, value identifier */
+  const BINATT *ba;             /* attribute record of binary file */
+  const int    *htab;           /* hash table of the value names */
+
+  assert(nbc && name && (attid >= 0) && (attid < nbc->attcnt));
+  if (!nbc->bin)                /* if not loaded from a binary file, */
+    return att_valid(as_att(nbc->attset, attid), name);
+  ba = (const BINATT*)(nbc->bin +((const BINHDR*)nbc->bin)->atts);
+  ba += attid;                  /* get the attribute record */
+  if (ba->vhsz <= 0) return -1; /* and its value hash table */
+  htab = (const int*)(nbc->bin +ba->vhash);
+  for (i = (int)(_strhash(name) & (ba->vhsz-1)); (k = htab[i]) >= 0; ) {
+    if (strcmp(name, _valname(nbc, attid, k)) == 0)
+      return k;                 /* traverse the hash bin chain */
+    i = (i+1) & (ba->vhsz-1);   /* and compare the value names */
+  }                             /* (linear probing) */
+  return -1;                    /* return 'value not found' */
+}  /* nbc_valid() */
+
+/*--------------------------------------------------------------------*/
+
+int nbc_isbin (const char *fname)
+{                               /* --- check for a binary file */
+  FILE *file;                   /* file to check */
+  char magic[4];                /* buffer for the magic number */
+  int  r;                       /* result of the check */
+
+  assert(fname);                /* check the function argument */
+  file = fopen(fname, "rb");    /* open the file */
+  if (!file) return 0;          /* and read the magic number */
+  r = (fread(magic, 1, 4, file) == 4)
+   && (memcmp(magic, NBC_MAGIC, 4) == 0);
+  fclose(file);                 /* close the file and */
+  return r;                     /* return the check result */
+}  /* nbc_isbin() */
+
 /*--------------------------------------------------------------------*/
 #ifdef NBC_PARSE
 
-static int _distin (SCAN *scan, ATT *att, double *frqs, double *sum)
+static int _distin (SCAN *scan, ATT *att, double *frqs, double *sum,
+                    int neg)
 {                               /* --- read a distribution */
   int    i, cnt;                /* loop variable, number of values */
   double *p, f;                 /* to traverse the frequencies */
   int    t;                     /* buffer for token */
 
-  assert(scan && att && frqs && sum); /* check the function arguments */
+  assert(scan && att && sum && (frqs || (att_valcnt(att) <= 0)));
   GET_CHR('{');                 /* consume '{' (start of distrib.) */
   cnt = att_valcnt(att);        /* get the number of att. values */
   for (p = frqs +(i = cnt); --i >= 0; )
-    *--p = -1;                  /* clear the value frequencies */
-  while (1) {                   /* attribute value read loop */
+    *--p = -DBL_MAX;            /* clear the value frequencies */
+  while (sc_token(scan) != '}') {  /* attribute value read loop */
     t = sc_token(scan);         /* check for a name */
     if ((t != T_ID) && (t != T_NUM)) ERROR(E_VALEXP);
     if (t != T_NUM) t = ':';    /* if the token is no number, */
@@ -1046,11 +3279,12 @@ static int _distin (SCAN *scan, ATT *att, double *frqs, double *sum)
       GET_TOK();                /* get and consume the value */
       GET_CHR(':');             /* consume ':' */
     }
-    if (frqs[i] >= 0)           /* check whether value has been read */
+    if (frqs[i] > -DBL_MAX)     /* check whether value has been read */
       XERROR(E_DUPVAL, att_valname(att, i));
     if (sc_token(scan) != T_NUM) ERROR(E_NUMEXP);
-    f = atof(sc_value(scan));   /* get and check */
-    if (f < 0) ERROR(E_NUMBER); /* the value frequency */
+    f = atof(sc_value(scan));   /* get and check the value frequency */
+    if ((f < 0) && !neg)        /* (may be negative only for */
+      ERROR(E_NUMBER);          /*  sign hashed tokens) */
     frqs[i] = f;                /* set the value frequency */
     GET_TOK();                  /* consume the value frequency */
     if (sc_token(scan) == '('){ /* if a relative number follows, */
@@ -1066,7 +3300,7 @@ static int _distin (SCAN *scan, ATT *att, double *frqs, double *sum)
   }                             /* otherwise consume ',' */
   GET_CHR('}');                 /* consume '}' (end of distribution) */
   for (f = 0, p = frqs +(i = cnt); --i >= 0; ) {
-    if (*--p < 0) *p = 0;       /* clear the unset frequencies */
+    if (*--p <= -DBL_MAX) *p = 0;  /* clear the unset frequencies */
     else          f += *p;      /* and sum all other frequencies */
   }                             /* to obtain the total frequency */
   *sum = f;                     /* set the sum of the frequencies */
@@ -1098,7 +3332,8 @@ static int _discdin (NBC *nbc, SCAN *scan,
     discd = dvec->discds +i;    /* get and check the distribution */
     if (discd->cnt >= 0) XERROR(E_DUPVAL, att_valname(clsatt, i));
     discd->cnt = 0;             /* clear the counter as a flag */
-    t = _distin(scan, att, discd->frqs, &discd->cnt);
+    t = _distin(scan, att, discd->frqs, &discd->cnt,
+                nbc->hmode & NBC_HSIGN);
     if (t) return t;            /* read distribution */
     if (sc_token(scan) != ',') break;
     GET_TOK();                  /* if at end of list, abort loop */
@@ -1115,6 +3350,7 @@ static int _contdin (NBC *nbc, SCAN *scan,
                      ATT *clsatt, ATT *att, DVEC *dvec)
 {                               /* --- read continuous distributions */
   int    i = -1;                /* class identifier, buffer */
+  int    multi;                 /* whether multinomial for counts */
   NORMD  *normd;                /* to access normal distribution */
   double t;                     /* temporary buffer */
 
@@ -1142,19 +3378,25 @@ static int _contdin (NBC *nbc, SCAN *scan,
     if (normd->cnt >= 0)        /* check whether it is already set */
       XERROR(E_DUPVAL, att_valname(clsatt, i));
     normd->cnt = 0;             /* clear the counter as a flag */
+    multi = (nbc->mode & NBC_MULTI) && (dvec->type == AT_INT);
     if ((sc_token(scan) != T_ID)
-    ||  (strcmp(sc_value(scan), "N") != 0))
-      ERR_STR("N");             /* check for an 'N' */
-    GET_TOK();                  /* consume 'N' */
+    ||  (strcmp(sc_value(scan), (multi) ? "M" : "N") != 0))
+      ERR_STR((multi) ? "M" : "N");   /* check for an 'N' or 'M' */
+    GET_TOK();                  /* consume 'N' or 'M' */
     GET_CHR('(');               /* consume '(' */
     if (sc_token(scan) != T_NUM) ERROR(E_NUMEXP);
     normd->exp = atof(sc_value(scan));
     GET_TOK();                  /* get and consume the exp. value */
-    GET_CHR(',');               /* consume ',' */
-    if (sc_token(scan) != T_NUM) ERROR(E_NUMEXP);
-    normd->var = atof(sc_value(scan));
-    if (normd->var < 0)          ERROR(E_NUMBER);
-    GET_TOK();                  /* get and consume the variance */
+    if (multi) {                /* or the token frequency */
+      if (normd->exp < 0)        ERROR(E_NUMBER);
+      normd->var = 0; }         /* (variance is not stored) */
+    else {                      /* if normal distribution */
+      GET_CHR(',');             /* consume ',' */
+      if (sc_token(scan) != T_NUM) ERROR(E_NUMEXP);
+      normd->var = atof(sc_value(scan));
+      if (normd->var < 0)        ERROR(E_NUMBER);
+      GET_TOK();                /* get and consume the variance */
+    }
     GET_CHR(')');               /* consume ')' */
     if (sc_token(scan) != '['){ /* if no number of cases follows, */
       normd->cnt = nbc->frqs[i];/* get the class frequencies */
@@ -1167,6 +3409,8 @@ static int _contdin (NBC *nbc, SCAN *scan,
       GET_TOK();                /* consume the number of cases */
       GET_CHR(']');             /* consume ']' */
     }                           /* then compute the sums */
+    if (multi)                  /* convert the token frequency */
+      normd->exp = (normd->cnt > 0) ? normd->exp /normd->cnt : 0;
     normd->sv  = normd->exp *(t = normd->cnt);
     if (!(nbc->mode & NBC_MAXLLH)) t -= 1;
     normd->sv2 = normd->var *t +normd->exp *normd->sv;
@@ -1203,6 +3447,7 @@ static int _dvecsin (NBC *nbc, SCAN *scan, ATT *clsatt)
     if (dvec->type == 0) ERROR(E_ATTYPE);
     if (dvec->mark >= 0) ERROR(E_DUPATT);
     dvec->mark = 1;             /* set the read flag */
+    if (_attinit(nbc, dvec) != 0) ERROR(E_NOMEM);
     GET_TOK();                  /* consume the attribute name */
     GET_CHR('|');               /* consume '|' (condition indicator) */
     t = sc_token(scan);         /* get the next token */
@@ -1273,12 +3518,39 @@ static int _parse (ATTSET *attset, SCAN *scan, NBC **pnbc)
         nbc->mode |= NBC_DWNULL;/* distribute weight for nulls */
       else if (strcmp(sc_value(scan), "maxllh") == 0)
         nbc->mode |= NBC_MAXLLH;/* use max. likelihood estimate */
+      else if (strcmp(sc_value(scan), "multi")  == 0)
+        nbc->mode |= NBC_MULTI; /* multinomial model for counts */
       else ERROR(E_PAREXP);     /* abort on all other values */
       GET_TOK();                /* consume the estimator flag */
     }
     GET_CHR(';');               /* consume ';' */
   }
 
+  /* --- read hashing parameters --- */
+  if ((sc_token(scan) == T_ID)  /* if 'hash' follows */
+  &&  (strcmp(sc_value(scan), "hash") == 0)) {
+    GET_TOK();                  /* consume 'hash' */
+    GET_CHR('=');               /* consume '=' */
+    if (sc_token(scan) != T_NUM)  ERROR(E_NUMEXP);
+    nbc->bktcnt = atoi(sc_value(scan));
+    if ((nbc->bktcnt <= 0)      /* get and check the number of */
+    ||  (nbc->attcnt != nbc->bktcnt+1) || (clsid != 0))
+      ERROR(E_NUMBER);          /* buckets (bucket i is att. i+1) */
+    GET_TOK();                  /* consume the number of buckets */
+    GET_CHR(',');               /* consume ',' */
+    if (sc_token(scan) != T_NUM)  ERROR(E_NUMEXP);
+    nbc->seed = (unsigned int)strtoul(sc_value(scan), NULL, 10);
+    GET_TOK();                  /* get and consume the seed */
+    if (sc_token(scan) == ',') {/* if a hashing mode follows */
+      GET_TOK();                /* consume ',' */
+      if ((sc_token(scan) != T_ID)
+      ||  (strcmp(sc_value(scan), "sign") != 0)) ERROR(E_PAREXP);
+      nbc->hmode |= NBC_HSIGN;  /* sign hashing */
+      GET_TOK();                /* consume 'sign' */
+    }
+    GET_CHR(';');               /* consume ';' */
+  }
+
   /* --- read class distribution --- */
   if ((sc_token(scan) != T_ID)
   ||  ((strcmp(sc_value(scan), "prob") != 0)
@@ -1293,7 +3565,7 @@ static int _parse (ATTSET *attset, SCAN *scan, NBC **pnbc)
   GET_TOK();                    /* consume the class name */
   GET_CHR(')');                 /* consume ')' */
   GET_CHR('=');                 /* consume '=' */
-  t = _distin(scan, att, nbc->frqs, &nbc->total);
+  t = _distin(scan, att, nbc->frqs, &nbc->total, 0);
   if (t) return t;              /* read the class distribution */
   GET_CHR(';');                 /* consume ';' */
   nbc->dvecs[clsid].mark = 0;   /* mark the class attribute */
@@ -1326,7 +3598,8 @@ NBC* nbc_parse (ATTSET *attset, SCAN *scan)
     if (nbc) nbc_delete(nbc,0); /* parse a naive Bayes classifier */
     return NULL;                /* if an error occurred, */
   }                             /* delete the classifier and abort */
-  nbc_setup(nbc, nbc->mode, nbc->lcorr);
+  if (nbc_setup(nbc, nbc->mode, nbc->lcorr) != 0) {
+    nbc_delete(nbc, 0); return NULL; }
   return nbc;                   /* set up the created classifier */
 }  /* nbc_parse() */            /* and then return it */
 
@@ -18,6 +18,24 @@
             2003.04.26 function nbc_rand added
             2004.08.12 adapted to new module parse
             2007.03.21 function nbc_post added (posterior prob.)
+            2026.10.17 sparse functions nbc_addsp and nbc_execsp added
+            2026.10.17 logarithms of probabilities added (log-space exec.)
+            2026.10.17 execution workspace and function nbc_exec_r added
+            2026.10.17 functions nbc_exec_batch and nbc_exec_block added
+            2026.10.17 compiled execution plan and nbc_compile added
+            2026.10.17 functions nbc_sub and nbc_subsp added
+            2026.10.17 incremental setup (mode NBC_DIRTY) added
+            2026.10.17 parameter 'thcnt' added to function nbc_induce
+            2026.10.17 memory slabs for the distributions (type SLAB)
+            2026.10.17 copy-on-write cloning (mode NBC_COW) added
+            2026.10.17 binary model files (nbc_save, nbc_load) added
+            2026.10.17 function nbc_merge added
+            2026.10.17 quantized binary model files (inference only)
+            2026.10.17 feature hashing (nbc_hcreate, nbc_hash, nbc_hinst)
+            2026.10.17 heavy hitter token tracking (nbc_tcreate etc.)
+            2026.10.17 load mode NBC_READ added (no map of the file)
+            2026.10.17 multinomial model for counts (mode NBC_MULTI)
+            2026.10.17 free lists for vectors replaced in memory slabs
 ----------------------------------------------------------------------*/
 #ifndef __NBAYES__
 #define __NBAYES__
@@ -39,6 +57,32 @@
 #define NBC_MARKED  0x0020      /* set up only for marked attributes */
 #define NBC_DWNULL  0x0040      /* distribute weight for null values */
 #define NBC_MAXLLH  0x0080      /* max. likelihood estim. of variance */
+#define NBC_DIRTY   0x0100      /* re-estimate only changed atts. */
+#define NBC_MULTI   0x0800      /* multinomial model for integer atts. */
+
+/* --- clone modes --- */
+/*      NBC_CLONE   0x0001         clone attribute set (see above) */
+#define NBC_COW     0x0200      /* share distributions (copy on write) */
+
+/* --- feature hashing modes --- */
+#define NBC_HSIGN   0x0400      /* sign hashing (expected counts */
+                                /* unbiased, but may be negative) */
+
+/* --- memory slabs --- */
+#define NBC_FREES   32          /* number of free lists (size classes) */
+
+/* --- binary model files --- */
+#define NBC_MAGIC   "NBCB"      /* magic number of binary files */
+#define NBC_BINVER  3           /* version of the binary format */
+
+/* --- quantization modes (binary model files) --- */
+#define NBC_F32     0x1000      /* log. probs. as 32 bit floats */
+#define NBC_Q16     0x2000      /* log. probs. as 16 bit fixed-point */
+#define NBC_Q8      0x4000      /* log. probs. as  8 bit fixed-point */
+#define NBC_QUANT   (NBC_F32|NBC_Q16|NBC_Q8)
+
+/* --- load modes (binary model files) --- */
+#define NBC_READ    0x0001      /* read the file instead of mapping it */
 
 /* --- description modes --- */
 #define NBC_TITLE   0x0001      /* print a title (as a comment) */
@@ -51,6 +95,7 @@ typedef struct {                /* --- discrete distribution --- */
   double cnt;                   /* number of cases (total frequency) */
   double *frqs;                 /* value frequency   vector */
   double *probs;                /* value probability vector */
+  double *lprobs;               /* logarithms of value probabilities */
 } DISCD;                        /* (discrete distribution) */
 
 typedef struct {                /* --- normal distribution --- */
@@ -59,10 +104,15 @@ typedef struct {                /* --- normal distribution --- */
   double sv2;                   /* sum of squared values */
   double exp;                   /* expected value */
   double var;                   /* variance */
+  double ivar;                  /* 1/(2 var) (for the log. density) */
+  double lnrm;                  /* log. of normalization factor */
+                                /* (NBC_MULTI: log. token prob.) */
 } NORMD;                        /* (normal distribution) */
 
 typedef struct {                /* --- distribution vector --- */
   int    mark;                  /* whether read or to be processed */
+  int    dirty;                 /* whether changed since last setup */
+  int    shared;                /* whether distribs. are shared */
   int    type;                  /* attribute type (0: class) */
   int    valvsz;                /* size of value frequency vectors */
   int    valcnt;                /* number of attribute values */
@@ -70,6 +120,50 @@ typedef struct {                /* --- distribution vector --- */
   NORMD  *normds;               /* vector of normal distributions */
 } DVEC;                         /* (distribution vector) */
 
+typedef struct {                /* --- compiled attribute --- */
+  int    attid;                 /* attribute identifier */
+  int    type;                  /* attribute type */
+  int    valcnt;                /* number of attribute values */
+  const void *tab;              /* log. probs. (value major) or */
+  double scale;                 /* (exp, ivar, lnrm) per class; */
+} CATT;                         /* scale of fixed-point log. probs. */
+
+typedef struct {                /* --- compiled execution plan --- */
+  int    cnt;                   /* number of compiled attributes */
+  double *tabs;                 /* tables of all attributes */
+  CATT   atts[1];               /* compiled attributes */
+} NBCPLAN;                      /* (compiled execution plan) */
+
+typedef struct slab {           /* --- memory slab --- */
+  struct slab *succ;            /* successor slab in list */
+  size_t size;                  /* number of doubles in slab */
+  size_t used;                  /* number of doubles used */
+  double data[1];               /* memory for the distributions */
+} SLAB;                         /* (memory slab) */
+
+typedef struct nbcshr {         /* --- shared memory --- */
+  int    refs;                  /* number of referencing classifiers */
+  SLAB   *slabs;                /* memory slabs with shared distribs. */
+  struct nbcshr *base;          /* memory shared before (older slabs) */
+  void   *map;                  /* mapped binary model file (if any) */
+  size_t size;                  /* size of the mapped file */
+  int    mapped;                /* whether mapped (otherwise read) */
+} NBCSHR;                       /* (shared memory) */
+
+typedef struct {                /* --- token map (hashing/tracking) */
+  int    bkt;                   /* bucket attribute (< 0: neg. sign) */
+  int    ctr;                   /* heavy hitter counter (-1: none, */
+                                /* -2: no token, -3: not tracked) */
+  int    cnt;                   /* number of mapped values */
+  int    *ids;                  /* value identifiers in the bucket */
+} HTOK;                         /* (token map) */
+
+typedef struct {                /* --- heavy hitter counter --- */
+  int    tok;                   /* token (attribute id. in token set) */
+  double frq;                   /* estimated token frequency */
+  double err;                   /* maximal overestimation */
+} HHCTR;                        /* (heavy hitter counter) */
+
 typedef struct {                /* --- naive Bayes classifier --- */
   ATTSET *attset;               /* underlying attribute set */
   int    attcnt;                /* number of attributes */
@@ -81,16 +175,56 @@ typedef struct {                /* --- naive Bayes classifier --- */
   double total;                 /* total number of cases */
   double *frqs;                 /* class frequencies */
   double *priors;               /* prior     class probabilities */
+  double *lpriors;              /* logarithms of prior class probs. */
   double *posts;                /* posterior class probabilities */
-  double *cond;                 /* buffer for conditional probs. */
+  double *cond;                 /* buffer for log. of cond. probs. */
+  SLAB   *slabs;                /* memory slabs (distributions) */
+  void   *frees[NBC_FREES];     /* free lists of replaced vectors */
+  NBCSHR *shr;                  /* memory shared with clones */
+  int    *asrefs;               /* reference counter of att. set */
+  const char *bin;              /* binary model file (value names) */
+  NBCPLAN *plan;                /* compiled execution plan */
+  int    quant;                 /* quantization of the plan tables */
+  double qerr;                  /* bound for the log. posterior error */
+  int    bktcnt;                /* number of hash buckets (0: none) */
+  unsigned int seed;            /* seed of the hash function */
+  int    hmode;                 /* feature hashing mode (NBC_HSIGN) */
+  const ATTSET *htset;          /* attribute set of the tokens */
+  int    htcnt;                 /* number of mapped token attributes */
+  HTOK   *htoks;                /* token maps (indexed by att. id) */
+  int    slotcnt;               /* number of token slots (0: none) */
+  int    slotused;              /* number of materialized tokens */
+  int    dropped;               /* number of frequent tokens dropped */
+  double minfrq;                /* minimal frequency of a token */
+  int    ctrcnt;                /* number of heavy hitter counters */
+  int    ctrused;               /* number of used counters */
+  HHCTR  *ctrs;                 /* heavy hitter counters (min-heap) */
+  int    dcnt;                  /* number of changed atts. (-1: all) */
+  int    *dlist;                /* list of changed attributes */
   DVEC   dvecs[1];              /* vector of distribution vectors */
 } NBC;                          /* (naive Bayes classifier) */
 
+typedef struct {                /* --- sparse attribute instance --- */
+  int    attid;                 /* attribute identifier (hashed: */
+                                /* < 0 for a negative sign) */
+  INST   inst;                  /* attribute instance (value) */
+} SPINST;                       /* (sparse attribute instance) */
+
+typedef struct {                /* --- execution workspace --- */
+  int    clscnt;                /* number of classes */
+  double *posts;                /* posterior class probabilities */
+  double *cond;                 /* buffer for log. of cond. probs. */
+} NBCWS;                        /* (naive Bayes execution workspace) */
+
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
 extern NBC*    nbc_create (ATTSET *attset, int clsid);
-extern NBC*    nbc_clone  (NBC *nbc, int cloneas);
+extern NBC*    nbc_hcreate (ATTSET *attset, int clsid, int bktcnt,
+                            unsigned int seed, int mode);
+extern NBC*    nbc_tcreate (ATTSET *attset, int clsid, int slotcnt,
+                            int ctrcnt, double minfrq);
+extern NBC*    nbc_clone  (NBC *nbc, int mode);
 extern void    nbc_delete (NBC *nbc, int delas);
 extern void    nbc_clear  (NBC *nbc);
 
@@ -100,17 +234,38 @@ extern int     nbc_valcnt (const NBC *nbc, int attid);
 extern int     nbc_clsid  (const NBC *nbc);
 extern int     nbc_clscnt (const NBC *nbc);
 extern double  nbc_total  (const NBC *nbc);
+extern int     nbc_bktcnt (const NBC *nbc);
+extern unsigned int nbc_seed (const NBC *nbc);
+extern int     nbc_hmode  (const NBC *nbc);
+extern int     nbc_hash   (const NBC *nbc, const char *name);
+extern int     nbc_hinst  (NBC *nbc, ATTSET *attset, int clsid,
+                           SPINST *insts, int *cls);
+extern int     nbc_hstats (const NBC *nbc, int *used, int *coll,
+                           int *maxld);
+extern int     nbc_tstats (const NBC *nbc, int *used, int *dropped);
+extern int     nbc_tdone  (NBC *nbc);
 
 #ifdef NBC_INDUCE
 extern int     nbc_add    (NBC *nbc, const TUPLE *tpl);
+extern int     nbc_addsp  (NBC *nbc, int cls, float wgt,
+                           const SPINST *insts, int cnt);
+extern int     nbc_sub    (NBC *nbc, const TUPLE *tpl);
+extern int     nbc_subsp  (NBC *nbc, int cls, float wgt,
+                           const SPINST *insts, int cnt);
 extern NBC*    nbc_induce (TABLE *table, int clsid,
-                           int mode, double lcorr);
+                           int mode, double lcorr, int thcnt);
 extern int     nbc_mark   (NBC *nbc);
+extern int     nbc_merge  (NBC *dst, const NBC *src);
 #endif
 
-extern void    nbc_setup  (NBC *nbc, int mode, double lcorr);
+extern int     nbc_setup  (NBC *nbc, int mode, double lcorr);
 extern double  nbc_lcorr  (const NBC *nbc);
 extern int     nbc_mode   (const NBC *nbc);
+extern int     nbc_quant  (const NBC *nbc);
+extern double  nbc_qerr   (const NBC *nbc);
+extern int     nbc_compile (NBC *nbc);
+extern int     nbc_compiled (const NBC *nbc);
+extern int     nbc_binary (const NBC *nbc);
 
 extern double  nbc_prior  (const NBC *nbc, int clsid);
 extern double  nbc_prob   (const NBC *nbc, int clsid, int attid,
@@ -119,9 +274,27 @@ extern double  nbc_exp    (const NBC *nbc, int clsid, int attid);
 extern double  nbc_var    (const NBC *nbc, int clsid, int attid);
 extern double  nbc_post   (const NBC *nbc, int clsid);
 extern int     nbc_exec   (NBC *nbc, const TUPLE *tpl, double *conf);
+extern int     nbc_execsp (NBC *nbc, const SPINST *insts, int cnt,
+                           double *conf);
+extern NBCWS*  nbc_wscreate (const NBC *nbc);
+extern void    nbc_wsdelete (NBCWS *ws);
+extern int     nbc_exec_r (const NBC *nbc, NBCWS *ws,
+                           const INST *insts, double *conf);
+extern double  nbc_wspost (const NBCWS *ws, int clsid);
+extern int     nbc_exec_batch (const NBC *nbc, TUPLE *const *tpls,
+                               int n, int *classes, double *confs,
+                               double *posts);
+extern int     nbc_exec_block (const NBC *nbc, const INST *cols,
+                               int n, int *classes, double *confs,
+                               double *posts);
 extern void    nbc_rand   (NBC *nbc, double drand (void));
 
-extern int     nbc_desc   (NBC *nbc, FILE *file, int mode, int maxlen);
+extern int     nbc_desc   (const NBC *nbc, FILE *file, int mode,
+                            int maxlen);
+extern int     nbc_save   (const NBC *nbc, FILE *file, int mode);
+extern NBC*    nbc_load   (const char *fname, int mode);
+extern int     nbc_valid  (const NBC *nbc, int attid, const char *name);
+extern int     nbc_isbin  (const char *fname);
 #ifdef NBC_PARSE
 extern NBC*    nbc_parse  (ATTSET *attset, SCAN *scan);
 #endif
@@ -135,14 +308,27 @@ extern NBC*    nbc_parse  (ATTSET *attset, SCAN *scan);
 #define nbc_clsid(b)        ((b)->clsid)
 #define nbc_clscnt(b)       ((b)->clscnt)
 #define nbc_total(b)        ((b)->total)
+#define nbc_bktcnt(b)       ((b)->bktcnt)
+#define nbc_seed(b)         ((b)->seed)
+#define nbc_hmode(b)        ((b)->hmode)
 
 #define nbc_lcorr(b)        ((b)->lcorr)
 #define nbc_mode(b)         ((b)->mode)
+#define nbc_quant(b)        ((b)->quant)
+#define nbc_qerr(b)         ((b)->qerr)
+#define nbc_compiled(b)     ((b)->plan != NULL)
+#define nbc_binary(b)       ((b)->bin  != NULL)
 
 #define nbc_prior(b,c)      ((b)->priors[c])
-#define nbc_prob(b,c,a,v)   ((b)->dvecs[a].discds[c].probs[v])
-#define nbc_exp(b,c,a)      ((b)->dvecs[a].normds[c].exp)
-#define nbc_var(b,c,a)      ((b)->dvecs[a].normds[c].var)
+#define nbc_prob(b,c,a,v)   (((b)->dvecs[a].discds) \
+                            ? (b)->dvecs[a].discds[c].probs[v] : 0.0)
+#define nbc_exp(b,c,a)      (((b)->dvecs[a].normds) \
+                            ? (b)->dvecs[a].normds[c].exp : 0.0)
+#define nbc_var(b,c,a)      (((b)->dvecs[a].normds) \
+                            ? (b)->dvecs[a].normds[c].var : 0.0)
+/* (distributions are created only when needed, so nbc_prob, nbc_exp, */
+/*  and nbc_var yield 0 for attributes without any distributions) */
 #define nbc_post(b,c)       ((b)->posts[c])
+#define nbc_wspost(w,c)     ((w)->posts[c])
 
 #endif
@@ -46,6 +46,8 @@
             2007.02.13 adapted to redesigned module tabscan
             2007.02.17 attribute directions added
             2007.09.02 order of parameters to as_chars modified
+            2026.10.17 field map access macros added
+            2026.10.17 function att_valaddh added (hashed slices)
 ----------------------------------------------------------------------*/
 #ifndef __ATTSET__
 #define __ATTSET__
@@ -147,6 +149,7 @@ typedef union {                 /* --- instance --- */
 typedef struct _val {           /* --- attribute value --- */
   int          id;              /* identifier (index in attribute) */
   unsigned int hval;            /* hash value of value name */
+  int          len;             /* length of value name */
   struct _val *succ;            /* successor in hash bucket */
   char         name[1];         /* value name */
 } VAL;                          /* (attribute value) */
@@ -232,6 +235,8 @@ extern int      att_id      (const ATT *att);
   Attribute Value Functions
 ----------------------------------------------------------------------*/
 extern int      att_valadd  (ATT *att, CCHAR *name, INST *inst);
+extern int      att_valaddh (ATT *att, CCHAR *name, int len,
+                             unsigned int hval, INST *inst);
 extern void     att_valrem  (ATT *att, int valid);
 extern void     att_valexg  (ATT *att, int valid1, int valid2);
 extern void     att_valmove (ATT *att, int off, int cnt, int pos);
@@ -330,6 +335,8 @@ extern void     as_stats    (const ATTSET *set);
 #ifdef AS_RDWR
 #define as_tabscan(s)       ((s)->tscan)
 #define as_err(s)           ((s)->err)
+#define as_fldcnt(s)        ((s)->fldcnt)
+#define as_fldid(s,i)       ((s)->flds[i])
 #endif
 
 #endif
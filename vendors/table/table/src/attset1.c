@@ -28,6 +28,9 @@
             2004.05.21 bug concerning null value output fixed
             2005.11.19 cast from object to function pointer removed
             2007.02.13 adapted to redesigned module tabscan
+            2026.10.17 bug in function att_rename fixed (hash sign)
+            2026.10.17 function att_valaddh added (hashed slices)
+            2026.10.17 names hashed with ts_hash() (same as fields)
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,6 +39,7 @@
 #include <assert.h>
 #include "arrays.h"
 #include "attset.h"
+#include "tabscan.h"
 #include "scan.h"
 #ifdef STORAGE
 #include "storage.h"
@@ -77,12 +81,12 @@ static char* _copy (char *d, const char *s)
 
 static unsigned int _hash (const char *s)
 {                               /* --- hash function */
-  register unsigned int h = 0;  /* hash value */
+  register const char *e = s;   /* to find the end of the name */
   register int n = AS_MAXLEN;   /* character counter */
 
-  while ((--n >= 0) && *s) h ^= (h << 3) ^ (unsigned int)(*s++);
-  return h;                     /* compute and return hash value */
-}  /* _hash() */
+  while ((--n >= 0) && *e) e++; /* hash at most AS_MAXLEN characters */
+  return ts_hash(s, (int)(e-s));/* with the hash function of fields, */
+}  /* _hash() */                /* so that slices can be looked up */
 
 /*--------------------------------------------------------------------*/
 
@@ -226,7 +230,7 @@ void att_delete (ATT *att)
 
 int att_rename (ATT *att, const char *name)
 {                               /* --- rename an attribute */
-  int  hval;                    /* hash value of new attribute name */
+  unsigned int hval;            /* hash value of new attribute name */
   char *tmp;                    /* temporary buffer for name */
   ATT  **p, **hb = NULL;        /* buffers for hash buckets */  
   ATT  *t;                      /* to traverse a hash bucket */
@@ -463,14 +467,16 @@ int att_valadd (ATT *att, const char *name, INST *inst)
   h = _hash(name);              /* compute the name's hash value */
   p = att->htab +h % att->valvsz;
   for (val = *p; val; val = val->succ) {
-    if (strncmp(name, val->name, AS_MAXLEN) == 0) {
+    if ((val->hval == h)
+    &&  (strncmp(name, val->name, AS_MAXLEN) == 0)) {
       att->inst.i = val->id; return 1; }
   }                             /* if name already exists, abort */
   if (inst) return -3;          /* if not to extend the domain, abort */
-  val = (VAL*)malloc(sizeof(VAL) +_length(name) *sizeof(char));
+  len = _length(name);          /* get the length of the name */
+  val = (VAL*)malloc(sizeof(VAL) +len *sizeof(char));
   if (!val) return -1;          /* allocate memory for a value */
   _copy(val->name, name);       /* copy name and set hash value */
-  val->hval = h;                /* set value identifier and instance */
+  val->hval = h; val->len = len;/* and the length of the name */
   val->id   = att->inst.i = att->valcnt;
   val->succ = *p; *p = val;     /* insert value into the hash table */
   att->vals[att->valcnt++] = val;           /* and the value vector */
@@ -485,6 +491,29 @@ int att_valadd (ATT *att, const char *name, INST *inst)
 
 /*--------------------------------------------------------------------*/
 
+int att_valaddh (ATT *att, const char *name, int len,
+                 unsigned int hval, INST *inst)
+{                               /* --- add a value given as a slice */
+  VAL  *val;                    /* to traverse hash bucket */
+  char buf[AS_MAXLEN+1];        /* buffer for a terminated copy */
+
+  assert(att && name && (len > 0));   /* check function arguments */
+  if (len > AS_MAXLEN) len = AS_MAXLEN;
+  if ((att->type == AT_NOM) && (att->valcnt > 0)) {
+    val = att->htab[hval % att->valvsz];
+    for ( ; val; val = val->succ) {   /* traverse hash bucket list */
+      if ((val->hval == hval) && (val->len == len)
+      &&  (memcmp(name, val->name, (size_t)len) == 0)) {
+        att->inst.i = val->id; return 1; }
+    }                           /* if value found, set instance */
+  }                             /* (no copy needed for known values) */
+  memcpy(buf, name, (size_t)len);
+  buf[len] = '\0';              /* terminate a copy of the name and */
+  return att_valadd(att, buf, inst);  /* add it the standard way */
+}  /* att_valaddh() */          /* (numbers and new values) */
+
+/*--------------------------------------------------------------------*/
+
 void att_valrem (ATT *att, int valid)
 {                               /* --- remove an attribute value */
   int i;                        /* loop variable */
@@ -712,7 +741,8 @@ int att_valcopy (ATT *dst, const ATT *src, int mode, ...)
     *d = (VAL*)malloc(sizeof(VAL) +strlen((*s)->name) *sizeof(char));
     if (!*d) break;             /* allocate memory for a new value */
     strcpy((*d)->name, (*s)->name);
-    (*d)->hval = (*s)->hval;    /* copy value name and hash value */
+    (*d)->hval = (*s)->hval;    /* copy value name, hash value */
+    (*d)->len  = (*s)->len;     /* and the length of the name */
   }                             /* (the identifier is set later) */
   if (i >= 0) {                 /* if an error occured */
     for (i = (int)(d -(dst->vals +dst->valcnt)); --i > 0; )
@@ -786,13 +816,16 @@ int att_valwd (ATT *att, int scform)
 int att_valid (const ATT *att, const char *name)
 {                               /* --- get the identifier of a value */
   VAL *val;                     /* to traverse hash bucket */
+  unsigned int h;               /* hash value of value name */
 
   assert(att                    /* check the function arguments */
       && name && (att->type == AT_NOM));
   if (att->valcnt <= 0) return NV_NOM;
-  val = att->htab[_hash(name) % att->valvsz];
+  h   = _hash(name);            /* compute the name's hash value */
+  val = att->htab[h % att->valvsz];
   for ( ; val; val = val->succ) /* traverse hash bucket list */
-    if (strncmp(name, val->name, AS_MAXLEN) == 0)
+    if ((val->hval == h)
+    &&  (strncmp(name, val->name, AS_MAXLEN) == 0))
       break;                    /* if value found, abort loop */
   return (val) ? val->id : NV_NOM;
 }  /* att_valid() */            /* return value identifier */
@@ -40,6 +40,7 @@
             2006.10.06 adapted to improved function ts_next
             2007.02.13 adapted to redesigned module tabscan
             2007.02.17 directions added, weight description modified
+            2026.10.17 instance values read as slices (ts_field())
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -140,6 +141,7 @@ int as_read (ATTSET *set, FILE *file, int mode, ...)
   char    *s;                   /* end pointer for conversion */
   int     d;                    /* delimiter type */
   INST    *inst;                /* dummy instance */
+  TSFLD   val;                  /* value field (slice of buffer) */
   char    buf[AS_MAXLEN+1];     /* read buffer */
   char    dflt[32];             /* buffer for default name */
 
@@ -253,7 +255,7 @@ int as_read (ATTSET *set, FILE *file, int mode, ...)
   else       { fld = NULL; cnt = set->attcnt; }
   d = TS_FLD;                   /* set default delimiter type */
   for (i = 0; (i < cnt) && (d == TS_FLD); i++) {
-    d = ts_next(set->tscan, file, buf, AS_MAXLEN);
+    d = ts_field(set->tscan, file, buf, AS_MAXLEN, &val);
     if (d <= TS_EOF) {          /* get the next value */
       if (d == TS_ERR) return _rderr(set, E_FREAD, i+1, 0, NULL);
       if (i <= 0)      return set->err->code = 1;
@@ -265,17 +267,21 @@ int as_read (ATTSET *set, FILE *file, int mode, ...)
     if ((mode & AS_MARKED)      /* if in marked mode and */
     &&  (att->mark < 0))        /* attribute is not marked, */
       continue;                 /* skip this field */
-    if (buf[0] == '\0') {       /* if the value is null */
-      if (mode & AS_NONULL)     /* check whether nulls are allowed */
-        return _rderr(set, E_VALUE, i+1, 0, buf);
+    if ((val.len <= 0) || (val.s[0] == '\0')) {
+      if (mode & AS_NONULL)     /* if the value is null, */
+        return _rderr(set, E_VALUE, i+1, 0, "");
       if      (att->type == AT_REAL) att->inst.f = NV_REAL;
       else if (att->type == AT_INT)  att->inst.i = NV_INT;
       else                           att->inst.i = NV_NOM; }
     else {                      /* if the value is not null */
-      r = att_valadd(att, buf, inst);
+      r = att_valaddh(att, val.s, val.len, val.hval, inst);
       if (r >=  0) continue;    /* add the value to the attribute */
       if (r >= -1) return _rderr(set, E_NOMEM, i+1, 0, NULL);
-      else         return _rderr(set, E_VALUE, i+1, 0, buf);
+      if (val.s != buf) {       /* if the value is a slice, */
+        memcpy(buf, val.s, (size_t)val.len);   /* copy it to the */
+        buf[val.len] = '\0';    /* buffer for the error message */
+      }
+      return _rderr(set, E_VALUE, i+1, 0, buf);
     }                           /* if the value cannot be added, */
   }  /* for (i = 0; .. */       /* abort with an error code */
   if (!(mode & AS_WEIGHT))      /* if there is no weight field, */
@@ -8,6 +8,8 @@
             2001.07.23 function msg removed
             2003.08.16 slight changes in error message output
             2007.02.13 adapted to redesigned modules tabscan, attset
+            2026.10.17 table body read buffered (ts_attach())
+            2026.10.17 table header read buffered as well
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -89,11 +91,14 @@ int io_error (int code, ...)
 FILE* io_hdr (ATTSET *attset, const char *fn_hdr,
               const char *fn_tab, int flags, int verbose)
 {                               /* --- read a table header */
-  FILE   *in;                   /* input file to read */
-  TSINFO *err;                  /* error information */
-  int    r;                     /* buffer for result of as_read */
+  FILE    *in;                  /* input file to read */
+  TABSCAN *tsc;                 /* table scanner of attribute set */
+  TSINFO  *err;                 /* error information */
+  int     r;                    /* buffer for result of as_read */
 
   assert(attset);               /* check the function arguments */
+  tsc = as_tabscan(attset);     /* release the buffer of a file */
+  ts_detach(tsc);               /* that may still be attached */
   if (flags & AS_ATT) {         /* if to use a table header file */
     if      (fn_hdr && *fn_hdr) /* if a proper file name is given, */
       in = fopen(fn_hdr, "rb"); /* open header file for reading */
@@ -102,8 +107,10 @@ FILE* io_hdr (ATTSET *attset, const char *fn_hdr,
     else { io_error(E_STDIN); return NULL; }
     if (verbose) fprintf(stderr, "reading %s ... ", fn_hdr);
     if (!in) { io_error(E_FOPEN, fn_hdr); return NULL; }
+    ts_attach(tsc, in);         /* read the table header buffered */
     r = as_read(attset, in, flags & ~AS_DFLT);
-    if (in != stdin) fclose(in);/* read the table header */
+    ts_detach(tsc);             /* release the read buffer */
+    if (in != stdin) fclose(in);/* and close the header file */
     if (r  != 0) {              /* if an error occurred, */
       err = as_err(attset);     /* get the error information */
       io_error(r, fn_hdr, 1, err->s, err->fld, err->exp);
@@ -118,14 +125,20 @@ FILE* io_hdr (ATTSET *attset, const char *fn_hdr,
     in = stdin; fn_tab = "<stdin>"; }      /* read from stdin */
   if (verbose) fprintf(stderr, "reading %s ... ", fn_tab);
   if (!in) { io_error(E_FOPEN, fn_tab); return NULL; }
-  if (!(flags & AS_ATT)         /* if not to use a table header file */
-  &&  (as_read(attset, in, flags|AS_ATT) != 0)) {
+  if (flags & AS_ATT)           /* if a table header file was read, */
+    return in;                  /* return the file to read table from */
+  ts_attach(tsc, in);           /* read the header buffered */
+  if (as_read(attset, in, flags|AS_ATT) != 0) {
     err = as_err(attset);       /* get the error information */
     io_error(err->code, fn_tab, 1, err->s, err->fld, err->exp);
-    if (in != stdin) fclose(in); return NULL;
+    ts_detach(tsc);             /* release the read buffer */
+    if (in != stdin) fclose(in);
+    return NULL;                /* close the table file */
   }                             /* read att. names from table file */
-  return in;                    /* return the file to read table from */
-}  /* io_hdr() */
+  if (ts_tell(tsc, in) >= 0)    /* if the file is seekable, set it */
+    ts_detach(tsc);             /* to the start of the table body */
+  return in;                    /* (otherwise the body is read from */
+}  /* io_hdr() */               /*  the attached buffer, ts_attach()) */
 
 /*--------------------------------------------------------------------*/
 
@@ -143,13 +156,15 @@ int io_body (ATTSET *attset, FILE *in, const char *fn_tab,
   t = clock();                  /* start the timer */
   if (!fn_tab || !*fn_tab) fn_tab = "<stdin>";
   f = AS_INST | (flags & ~(AS_ATT|AS_DFLT));
+  ts_attach(as_tabscan(attset), in);
   r = ((flags & AS_DFLT) && !(flags & AS_ATT))
-    ? 0 : as_read(attset, in, f);
+    ? 0 : as_read(attset, in, f);  /* read the body buffered */
   while (r == 0) {              /* record read loop */
     cnt++;                      /* increment the tuple counter */
     wgt += as_getwgt(attset);   /* and sum the tuple weight */
     r = as_read(attset, in, f); /* try to read the next tuple */
   }                             /* from the table file */
+  ts_detach(as_tabscan(attset));/* release the read buffer */
   if (in != stdin) fclose(in);  /* close the input file */
   if (r < 0) {                  /* if an error occurred, */
     err  = as_err(attset);      /* get the error information */
@@ -202,8 +217,9 @@ TABLE* io_bodyin (ATTSET *attset, FILE *in, const char *fn_tab,
     io_error(E_NOMEM); return NULL;
   }
   f = AS_INST | (flags & ~(AS_ATT|AS_DFLT));
+  ts_attach(as_tabscan(attset), in);
   r = ((flags & AS_DFLT) && !(flags & AS_ATT))
-    ? 0 : as_read(attset, in, f);
+    ? 0 : as_read(attset, in, f);  /* read the body buffered */
   while (r == 0) {              /* record read loop */
     if (tab_tpladd(table, NULL) != 0) {
       r = E_NOMEM; break; }     /* store the current tuple */
@@ -211,6 +227,7 @@ TABLE* io_bodyin (ATTSET *attset, FILE *in, const char *fn_tab,
     wgt += as_getwgt(attset);   /* and sum the tuple weight */
     r = as_read(attset, in, f); /* try to read the next tuple */
   }                             /* from the table file */
+  ts_detach(as_tabscan(attset));/* release the read buffer */
   if (in != stdin) fclose(in);  /* close the input file */
   if (r < 0) {                  /* if an error occurred, */
     err  = as_err(attset);      /* get the error information */
@@ -0,0 +1,24 @@
+/*----------------------------------------------------------------------
+  File    : refcnt.h
+  Contents: reference counters that may be changed by several threads
+  Author  : agent
+  History : 2026.10.17 file created
+----------------------------------------------------------------------*/
+#ifndef __REFCNT__
+#define __REFCNT__
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#ifdef __GNUC__                 /* atomic builtins of gcc and clang */
+#define rc_inc(p)     __sync_add_and_fetch(p, 1)
+#define rc_dec(p)     __sync_sub_and_fetch(p, 1)
+#define rc_get(p)     __sync_add_and_fetch((int*)(p), 0)
+#else                           /* other compilers are only used */
+#define rc_inc(p)     (++*(p))  /* for builds without threads */
+#define rc_dec(p)     (--*(p))
+#define rc_get(p)     (*(p))
+#endif
+/* rc_inc and rc_dec return the new value of the counter */
+
+#endif
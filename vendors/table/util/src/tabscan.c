@@ -20,10 +20,41 @@
             2007.05.17 function ts_allchs() added
             2007.09.02 made '*' a null value character by default
             2008.07.08 bug in function ts_next fixed (null at EOL)
+            2026.10.17 reading without stream locking added (TS_NOLOCK)
+            2026.10.17 buffered reading (mapped file or blocks) added
+            2026.10.17 fields as slices of the read buffer (ts_field())
+            2026.10.17 partial blocks read with read(), mapping optional
 ----------------------------------------------------------------------*/
+#if defined __unix__ || defined __APPLE__
+#define TS_READ                 /* read blocks with read(), which */
+#else                           /* returns as soon as data arrives */
+#undef  TS_MMAP                 /* mapping table files (TS_MMAP) */
+#endif                          /* needs a unix system; it is not */
+/* the default, because accessing a mapped file that is truncated */
+/* while it is read raises SIGBUS instead of a read error         */
+#if (defined TS_NOLOCK || defined TS_READ) && !defined _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L /* needed for getc_unlocked, mmap */
+#endif
+#if !defined TS_NOSIMD && defined __GNUC__ \
+&&  (defined __x86_64__ || (defined __i386__ && defined __SSE2__))
+#define TS_SIMD                 /* find separators with SSE2/AVX2 */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#ifdef TS_READ
+#include <errno.h>
+#include <unistd.h>
+#endif
+#ifdef TS_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#ifdef TS_SIMD
+#include <immintrin.h>
+#endif
 #include "tabscan.h"
 #ifdef STORAGE
 #include "storage.h"
@@ -40,6 +71,243 @@
 #define isnull(c)     ts_istype(tsc, TS_NULL,    c)
 #define iscomment(c)  ts_istype(tsc, TS_COMMENT, c)
 
+/* --- character input --- */
+#ifdef TS_NOLOCK                /* a table file is read by one thread */
+#undef  getc                    /* only, so the stream need not be */
+#define getc(f)       getc_unlocked(f)       /* locked for each char. */
+#endif
+
+/* --- buffered input --- */
+#define bgetc(t)      (((t)->next < (t)->end) \
+                      ? (unsigned char)*(t)->next++ : _fill(t))
+#define beof(t)       ((t)->delim = ((t)->err) ? TS_ERR : TS_EOF)
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static void _seps (TABSCAN *tsc)
+{                               /* --- collect separators for SIMD */
+  int i, k, n;                  /* loop variables, number of seps. */
+  int type;                     /* separator type flags */
+
+  for (k = 0; k < 2; k++) {     /* 0: field/record, 1: record seps. */
+    type = (k) ? TS_RECSEP : TS_FLDSEP|TS_RECSEP;
+    for (n = i = 0; i < 256; i++) {
+      if (!(tsc->cflags[i] & type)) continue;
+      if (n >= TS_MAXSEP) { n = -1; break; }
+      tsc->seps[k][n++] = (unsigned char)i;
+    }                           /* collect the separator characters */
+    tsc->sepcnt[k] = n;         /* (too many separators: -1, */
+  }                             /*  only scalar search possible) */
+}  /* _seps() */
+
+/*--------------------------------------------------------------------*/
+#ifdef TS_SIMD
+
+static const char* _sse2 (const unsigned char *seps, int cnt,
+                          const char *s, const char *e)
+{                               /* --- find a separator (16 bytes) */
+  int     i, b;                 /* loop variable, bit mask */
+  __m128i v, m;                 /* characters and comparison result */
+  __m128i set[TS_MAXSEP];       /* separator characters */
+
+  for (i = cnt; --i >= 0; )     /* broadcast the separators */
+    set[i] = _mm_set1_epi8((char)seps[i]);
+  for ( ; e -s >= 16; s += 16){ /* traverse blocks of 16 characters */
+    v = _mm_loadu_si128((const __m128i*)s);
+    m = _mm_cmpeq_epi8(v, set[0]);
+    for (i = 1; i < cnt; i++)   /* compare to all separators */
+      m = _mm_or_si128(m, _mm_cmpeq_epi8(v, set[i]));
+    b = _mm_movemask_epi8(m);   /* get the matching positions */
+    if (b) return s +__builtin_ctz((unsigned)b);
+  }                             /* return the first match */
+  return s;                     /* return the start of the rest */
+}  /* _sse2() */
+
+/*--------------------------------------------------------------------*/
+
+__attribute__((target("avx2")))
+static const char* _avx2 (const unsigned char *seps, int cnt,
+                          const char *s, const char *e)
+{                               /* --- find a separator (32 bytes) */
+  int     i; unsigned b;        /* loop variable, bit mask */
+  __m256i v, m;                 /* characters and comparison result */
+  __m256i set[TS_MAXSEP];       /* separator characters */
+
+  for (i = cnt; --i >= 0; )     /* broadcast the separators */
+    set[i] = _mm256_set1_epi8((char)seps[i]);
+  for ( ; e -s >= 32; s += 32){ /* traverse blocks of 32 characters */
+    v = _mm256_loadu_si256((const __m256i*)s);
+    m = _mm256_cmpeq_epi8(v, set[0]);
+    for (i = 1; i < cnt; i++)   /* compare to all separators */
+      m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, set[i]));
+    b = (unsigned)_mm256_movemask_epi8(m);
+    if (b) return s +__builtin_ctz(b);
+  }                             /* return the first match */
+  return s;                     /* return the start of the rest */
+}  /* _avx2() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static const char* _find (const TABSCAN *tsc, const char *s,
+                          const char *e, int k)
+{                               /* --- find the next separator */
+  int        type;              /* separator type flags */
+  const char *p;                /* end of the scalar probe */
+
+  type = (k) ? TS_RECSEP : TS_FLDSEP|TS_RECSEP;
+  for (p = (e -s > 16) ? s +16 : e; s < p; s++)
+    if (tsc->cflags[(unsigned char)*s] & type) return s;
+  #ifdef TS_SIMD                /* short fields are found scalar, */
+  if ((tsc->simd > 0) && (tsc->sepcnt[k] >= 0) && (e -s >= 16)) {
+    if (tsc->sepcnt[k] <= 0) return e;   /* no separators at all */
+    s = (tsc->simd > 1)         /* use the widest available */
+      ? _avx2(tsc->seps[k], tsc->sepcnt[k], s, e)  /* comparisons */
+      : _sse2(tsc->seps[k], tsc->sepcnt[k], s, e);
+  }                             /* (the rest is searched scalar) */
+  #endif
+  while ((s < e) && !(tsc->cflags[(unsigned char)*s] & type)) s++;
+  return s;                     /* return the separator position */
+}  /* _find() */                /* (or the end of the data) */
+
+/*--------------------------------------------------------------------*/
+
+static int _fill (TABSCAN *tsc)
+{                               /* --- fill the read buffer */
+  #ifdef TS_READ
+  long   n;                     /* number of characters read */
+  #else
+  size_t n;                     /* number of characters read */
+  #endif
+
+  if (tsc->mapped || tsc->err)  /* a mapped file has no more data */
+    return EOF;                 /* (it is mapped completely) */
+  if (tsc->off >= 0)            /* advance the buffer start offset */
+    tsc->off += (long)(tsc->end -tsc->base);
+  #ifdef TS_READ                /* read what is available, so that */
+  do n = (long)read(fileno(tsc->file), tsc->base, TS_BLKSIZE);
+  while ((n < 0) && (errno == EINTR));  /* a pipe does not stall */
+  if (n < 0) { n = 0; tsc->err = 1; }   /* until a block is full */
+  #else                         /* (a partial block is not the end) */
+  n = fread(tsc->base, 1, TS_BLKSIZE, tsc->file);
+  if (n <= 0) tsc->err = (ferror(tsc->file)) ? 1 : 0;
+  #endif
+  tsc->next = tsc->base; tsc->end = tsc->base +n;
+  if (n > 0) return (unsigned char)*tsc->next++;
+  return EOF;                   /* return the next character or */
+}  /* _fill() */                /* the end of file indicator */
+
+/*--------------------------------------------------------------------*/
+
+static void _keep (TSFLD *fld, char *buf)
+{                               /* --- copy a slice into the buffer */
+  if (fld->s == buf) return;    /* check whether already copied */
+  memcpy(buf, fld->s, (size_t)fld->len);
+  buf[fld->len] = '\0';         /* copy the field contents */
+  fld->s = buf;                 /* (needed before the read buffer */
+}  /* _keep() */                /*  is filled with the next block) */
+
+/*--------------------------------------------------------------------*/
+
+static int _bnext (TABSCAN *tsc, char *buf, int len, TSFLD *fld)
+{                               /* --- read the next field (buffered) */
+  int        c, d;              /* character read, delimiter type */
+  size_t     n;                 /* number of characters to copy */
+  char       *p;                /* to traverse the buffer */
+  const char *s, *e;            /* start and end of a character run */
+
+  /* --- initialize --- */
+  p = buf; *p = '\0';           /* clear the read buffer and */
+  tsc->cnt = 0;                 /* the number of characters read */
+  if (fld) { fld->s = buf; fld->len = 0; }
+  c = bgetc(tsc);               /* get the first character and */
+  if (c == EOF) return beof(tsc);     /* check for end of file */
+
+  /* --- skip comment records --- */
+  if (tsc->delim != 0) {        /* if at the start of a record */
+    while (iscomment(c)) {      /* while the record is a comment */
+      tsc->reccnt++;            /* count the record to be read */
+      while (!isrecsep(c)) {    /* while not at end of record */
+        tsc->next = _find(tsc, tsc->next, tsc->end, 1);
+        c = bgetc(tsc);         /* skip to a record separator */
+        if (c == EOF) return beof(tsc);
+      }                         /* (read up to a record separator) */
+      c = bgetc(tsc);           /* get the next character and */
+      if (c == EOF) return beof(tsc); /* check for end of file */
+    }
+  }                             /* (comment records are skipped) */
+
+  /* --- skip leading blanks --- */
+  while (isblank(c)) {          /* while character is blank, */
+    c = bgetc(tsc);             /* get the next character and */
+    if (c == EOF)               /* check for end of file/error */
+      return tsc->delim = (tsc->err) ? TS_ERR : TS_REC;
+  }                             /* check for end of file */
+  if (issep(c)) {               /* check for field/record separator */
+    if (isfldsep(c)) return tsc->delim = TS_FLD;
+    tsc->reccnt++;   return tsc->delim = TS_REC;
+  }                             /* if at end of record, count record */
+
+  /* --- read the field --- */
+  s = tsc->next -1;             /* note the start of the field and */
+  tsc->next = _find(tsc, tsc->next, tsc->end, 0);  /* find its end */
+  if (fld                       /* if a slice is requested and */
+  && ((tsc->next < tsc->end) || tsc->mapped)) {   /* the field lies */
+    e = (tsc->next -s > len) ? s +len : tsc->next; /* in the buffer */
+    c = bgetc(tsc);             /* get the separator (or end of file) */
+    d = (isfldsep(c)) ? TS_FLD : TS_REC;
+    while ((e > s) && isblank(e[-1])) e--;
+    for (p = (char*)e; --p >= s; )   /* remove trailing blanks and */
+      if (!isnull((unsigned char)*p)) break;   /* check for a null */
+    if (p < s) e = s;           /* value (only null value chars.) */
+    fld->s = s; tsc->cnt = fld->len = (int)(e -s); }
+  else {                        /* if the field is to be copied */
+    while (1) {                 /* (e.g. it spans two blocks) */
+      n = (size_t)(tsc->next -s);     /* copy the characters */
+      if (n > (size_t)len) n = (size_t)len;
+      memcpy(p, s, n); p += n; len -= (int)n;
+      c = bgetc(tsc);           /* get the next character */
+      if (issep(c)) { d = (isfldsep(c)) ? TS_FLD : TS_REC; break; }
+      if (c == EOF) { d = (tsc->err)    ? TS_ERR : TS_REC; break; }
+      s = tsc->next -1;         /* a character that is no separator */
+      tsc->next = _find(tsc, tsc->next, tsc->end, 0);
+    }                           /* starts a new block of the file */
+
+    /* --- remove trailing blanks --- */
+    while (isblank(*--p));      /* while character is blank */
+    *++p = '\0';                /* terminate string in buffer */
+    tsc->cnt = (int)(p -buf);   /* store number of characters read */
+
+    /* --- check for a null value --- */
+    while (--p >= buf)          /* check for only null value chars. */
+      if (!isnull((unsigned char)*p)) break;
+    if (p < buf) {              /* clear buffer if null value */
+      buf[0] = '\0'; tsc->cnt = 0; }
+    if (fld) fld->len = tsc->cnt;
+  }                             /* note the length of the field */
+
+  /* --- check for end of line --- */
+  if (d != TS_FLD) {            /* if not at a field separator */
+    if (d == TS_REC) tsc->reccnt++;
+    return tsc->delim = d;      /* if at end of record, count record, */
+  }                             /* and then abort the function */
+
+  /* --- skip trailing blanks --- */
+  while (isblank(c)) {          /* while character is blank, */
+    if (fld && (tsc->next >= tsc->end))
+      _keep(fld, buf);          /* keep a slice before a refill */
+    c = bgetc(tsc);             /* get the next character */
+    if (c == EOF) return tsc->delim = (tsc->err) ? TS_ERR : TS_REC;
+  }                             /* check for end of file/error */
+  if (isrecsep(c)) {            /* check for a record separator */
+    tsc->reccnt++; return tsc->delim = TS_REC; }
+  if (!isfldsep(c))             /* put back character (may be */
+    tsc->next--;                /* necessary if blank = field sep.) */
+  return tsc->delim = TS_FLD;   /* return the delimiter type */
+}  /* _bnext() */
+
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
@@ -62,11 +330,29 @@ TABSCAN* ts_create (void)
   tsc->cflags[',']  = TS_FLDSEP;
   tsc->cflags['?']  = tsc->cflags['*'] = TS_NULL;
   tsc->cflags['#']  = TS_COMMENT;
+  _seps(tsc);                   /* collect the separators */
+  tsc->file   = NULL;           /* no file is attached */
+  tsc->base   = NULL; tsc->next = tsc->end = NULL;
+  tsc->off    = 0; tsc->mapped = tsc->err = 0;
+  #ifdef TS_SIMD                /* check the processor features */
+  tsc->simd   = (__builtin_cpu_supports("avx2")) ? 2 : 1;
+  #else                         /* (AVX2 is used if available, */
+  tsc->simd   = 0;              /*  SSE2 is always present on x86-64) */
+  #endif
   return tsc;                   /* return created table scanner */
 }  /* ts_create() */
 
 /*--------------------------------------------------------------------*/
 
+void ts_delete (TABSCAN *tsc)
+{                               /* --- delete a table scanner */
+  assert(tsc);                  /* check the function argument */
+  if (tsc->file) ts_detach(tsc);/* release the read buffer */
+  free(tsc);                    /* and the table scanner */
+}  /* ts_delete() */
+
+/*--------------------------------------------------------------------*/
+
 void ts_copy (TABSCAN *dst, const TABSCAN *src)
 {                               /* --- copy character flags */
   int  i;                       /* loop variable */
@@ -75,7 +361,8 @@ void ts_copy (TABSCAN *dst, const TABSCAN *src)
   assert(src && dst);           /* check the function arguments */
   s = src->cflags +256; d = dst->cflags +256;
   for (i = 256; --i >= 0; ) *--d = *--s;
-}  /* ts_copy() */              /* copy the character flags */
+  _seps(dst);                   /* copy the character flags */
+}  /* ts_copy() */              /* and collect the separators */
 
 /*--------------------------------------------------------------------*/
 
@@ -92,6 +379,7 @@ int ts_chars (TABSCAN *tsc, int type, const char *chars)
   s = &chars;                   /* traverse the given characters */
   for (c = d = ts_decode(s); c >= 0; c = ts_decode(s))
     tsc->cflags[c] |= (char)type;  /* set character flags */
+  _seps(tsc);                   /* collect the separators */
   return (d >= 0) ? d : 0;      /* return first character */
 }  /* ts_chars() */
 
@@ -110,6 +398,84 @@ void ts_allchs (TABSCAN *tsc, const char *recseps, const char *fldseps,
 
 /*--------------------------------------------------------------------*/
 
+int ts_attach (TABSCAN *tsc, FILE *file)
+{                               /* --- attach a file for buffered reading */
+  #ifdef TS_MMAP
+  struct stat st;               /* file status (type and size) */
+  long pos;                     /* current position in the file */
+  void *p;                      /* mapped file */
+  #endif
+
+  assert(tsc && file);          /* check the function arguments */
+  if (tsc->file == file)        /* if the file is already attached, */
+    return 0;                   /* keep the data in the buffer */
+  if (tsc->file) ts_detach(tsc);/* detach a previous file */
+  tsc->file = file; tsc->err = 0;
+  #ifdef TS_MMAP                /* if a regular file, map it */
+  pos = ftell(file);            /* get the current position */
+  if ((pos >= 0) && (fstat(fileno(file), &st) == 0)
+  &&  S_ISREG(st.st_mode) && (st.st_size > 0) && (pos <= st.st_size)
+  &&  ((off_t)(size_t)st.st_size == st.st_size)) {
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+             fileno(file), 0);  /* map the whole file into memory */
+    if (p != MAP_FAILED) {      /* if the file could be mapped */
+      posix_madvise(p, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+      tsc->base = (char*)p; tsc->mapped = 1; tsc->off = 0;
+      tsc->next = tsc->base +pos; tsc->end = tsc->base +st.st_size;
+      return 0;                 /* continue reading at the current */
+    }                           /* position of the file */
+  }                             /* (otherwise read the file blocks) */
+  #endif
+  tsc->base = (char*)malloc(TS_BLKSIZE);
+  if (!tsc->base) { tsc->file = NULL; return -1; }
+  tsc->off  = ftell(file);      /* note the start of the first block */
+  tsc->next = tsc->end = tsc->base; tsc->mapped = 0;
+  #ifdef TS_READ                /* read() bypasses the stream buffer, */
+  if (tsc->off >= 0)            /* so discard it and move the file */
+    fflush(file);               /* offset to the stream position */
+  #endif                        /* (a stream that is not seekable */
+  return 0;                     /* must be attached before anything */
+}  /* ts_attach() */            /* is read from it) */
+
+/*--------------------------------------------------------------------*/
+
+int ts_detach (TABSCAN *tsc)
+{                               /* --- detach a buffered file */
+  long pos;                     /* position of next character */
+  int  r = 0;                   /* result of repositioning */
+
+  assert(tsc);                  /* check the function argument */
+  if (!tsc->file) return 0;     /* check for an attached file */
+  pos = ts_tell(tsc, tsc->file);/* get the position to continue at */
+  #ifdef TS_MMAP
+  if (tsc->mapped) {            /* if the file is mapped */
+    munmap(tsc->base, (size_t)(tsc->end -tsc->base));
+    r = fseek(tsc->file, pos, SEEK_SET); }
+  else                          /* unmap the file and set the stream */
+  #endif                        /* to the next character to read */
+  {                             /* if the file was read in blocks, */
+    if      (pos >= 0)          /* set the stream to the next char. */
+      r = fseek(tsc->file, pos, SEEK_SET);
+    else if (tsc->next < tsc->end)
+      r = -1;                   /* (cannot be done for a pipe, */
+    free(tsc->base);            /*  which loses unread characters) */
+  }                             /* release the read buffer */
+  tsc->file = NULL; tsc->base = NULL; tsc->next = tsc->end = NULL;
+  return (r != 0) ? -1 : 0;     /* clear the buffer and */
+}  /* ts_detach() */            /* return an error indicator */
+
+/*--------------------------------------------------------------------*/
+
+long ts_tell (TABSCAN *tsc, FILE *file)
+{                               /* --- get the position in a file */
+  assert(tsc && file);          /* check the function arguments */
+  if (file != tsc->file) return ftell(file);
+  if (tsc->off < 0) return -1;  /* if not attached, ask the stream */
+  return tsc->off +(long)(tsc->next -tsc->base);
+}  /* ts_tell() */              /* return the logical position */
+
+/*--------------------------------------------------------------------*/
+
 int ts_next (TABSCAN *tsc, FILE *file, char *buf, int len)
 {                               /* --- read the next table field */
   int  c, d;                    /* character read, delimiter type */
@@ -120,6 +486,8 @@ int ts_next (TABSCAN *tsc, FILE *file, char *buf, int len)
   /* --- initialize --- */
   if (!buf) {                   /* if no buffer given, use internal */
     buf = tsc->buf; len = TS_SIZE; }
+  if (tsc->file && (file == tsc->file))
+    return _bnext(tsc, buf, len, NULL);   /* read an attached file */
   p = buf; *p = '\0';           /* clear the read buffer and */
   tsc->cnt = 0;                 /* the number of characters read */
   c = getc(file);               /* get the first character and */
@@ -196,6 +564,33 @@ int ts_next (TABSCAN *tsc, FILE *file, char *buf, int len)
 
 /*--------------------------------------------------------------------*/
 
+int ts_field (TABSCAN *tsc, FILE *file, char *buf, int len, TSFLD *fld)
+{                               /* --- read the next field as a slice */
+  int d;                        /* delimiter type */
+
+  assert(tsc && buf && (len >= 0) && fld);
+  if (tsc->file && (file == tsc->file))
+    d = _bnext(tsc, buf, len, fld);   /* read an attached file */
+  else {                        /* (slice of the read buffer) */
+    d = ts_next(tsc, file, buf, len);
+    fld->s = buf; fld->len = tsc->cnt;
+  }                             /* read the field into the buffer */
+  fld->hval = ts_hash(fld->s, fld->len);
+  return d;                     /* compute the hash value and */
+}  /* ts_field() */             /* return the delimiter type */
+
+/*--------------------------------------------------------------------*/
+
+unsigned ts_hash (const char *s, int len)
+{                               /* --- compute the hash of a field */
+  register unsigned int h = 0;  /* hash value */
+
+  while (--len >= 0) h ^= (h << 3) ^ (unsigned int)(*s++);
+  return h;                     /* (also used for attribute and */
+}  /* ts_hash() */              /*  value names in attset1.c) */
+
+/*--------------------------------------------------------------------*/
+
 void ts_reset (TABSCAN *tsc)
 {                               /* --- reset a table scanner */
   tsc->reccnt =  1;             /* reset the record counter */
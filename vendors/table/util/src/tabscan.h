@@ -12,6 +12,8 @@
             2002.02.11 ts_reccnt() and ts_reset() added
             2007.02.13 renamed to tabscan, TS_NULL added
             2007.05.17 function ts_allchs() added
+            2026.10.17 buffered reading added (ts_attach(), ts_detach())
+            2026.10.17 fields as slices of the read buffer (ts_field())
 ----------------------------------------------------------------------*/
 #ifndef __TABSCAN__
 #define __TABSCAN__
@@ -36,6 +38,8 @@
 
 /* --- buffer size --- */
 #define TS_SIZE     256        /* size of internal read buffer */
+#define TS_BLKSIZE  1048576    /* size of a block for buffered reading */
+#define TS_MAXSEP   8          /* max. number of separators for SIMD */
 
 /*----------------------------------------------------------------------
   Type Definitions
@@ -47,6 +51,12 @@ typedef struct {                /* --- error information --- */
   char   *s;                    /* a string (e.g., field contents) */
 } TSINFO;                       /* (error information) */
 
+typedef struct {                /* --- table field (slice) --- */
+  const char   *s;              /* contents (not terminated) */
+  int          len;             /* number of characters */
+  unsigned int hval;            /* hash value of the contents */
+} TSFLD;                        /* (table field) */
+
 typedef struct {                /* --- table scanner --- */
   char   cflags[256];           /* character flags */
   int    reccnt;                /* number of records read */
@@ -54,6 +64,16 @@ typedef struct {                /* --- table scanner --- */
   int    cnt;                   /* number of characters read */
   char   buf[TS_SIZE+4];        /* read buffer */
   TSINFO info;                  /* error information */
+  FILE   *file;                 /* attached file (buffered reading) */
+  char   *base;                 /* start of block or mapped file */
+  const char *next;             /* next character to read */
+  const char *end;              /* end of the data in the buffer */
+  long   off;                   /* file offset of the buffer start */
+  int    mapped;                /* whether the file is mapped */
+  int    err;                   /* whether a read error occurred */
+  int    simd;                  /* SIMD level (0: scalar only) */
+  int    sepcnt[2];             /* number of separators for SIMD */
+  unsigned char seps[2][TS_MAXSEP]; /* field/record and record seps. */
 } TABSCAN;                      /* (table file scanner) */
 
 /*----------------------------------------------------------------------
@@ -70,7 +90,13 @@ extern void     ts_allchs (TABSCAN *tsc, const char *recseps,
 extern int      ts_istype (const TABSCAN *tsc, int type, int c);
 extern int      ts_type   (const TABSCAN *tsc, int c);
 
+extern int      ts_attach (TABSCAN *tsc, FILE *file);
+extern int      ts_detach (TABSCAN *tsc);
+extern long     ts_tell   (TABSCAN *tsc, FILE *file);
 extern int      ts_next   (TABSCAN *tsc, FILE *file, char *buf,int len);
+extern int      ts_field  (TABSCAN *tsc, FILE *file, char *buf,int len,
+                           TSFLD *fld);
+extern unsigned ts_hash   (const char *s, int len);
 extern int      ts_delim  (TABSCAN *tsc);
 extern int      ts_cnt    (TABSCAN *tsc);
 extern char*    ts_buf    (TABSCAN *tsc);
@@ -85,8 +111,6 @@ extern int      ts_decode (char const **s);
 /*----------------------------------------------------------------------
   Preprocessor Definitions
 ----------------------------------------------------------------------*/
-#define ts_delete(s)     free(s)
-
 #define ts_istype(s,t,c) ((s)->cflags[(unsigned char)(c)] & (t))
 #define ts_type(s,c)     ((s)->cflags[(unsigned char)(c)])
 